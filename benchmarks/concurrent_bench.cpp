@@ -0,0 +1,112 @@
+/**
+ * 并发读写(concurrent_inifile)压力测试
+ * - 多个线程对不同租户 section 进行混合读写(默认 90% 读, 10% 写)
+ * - 对比: 一把全局互斥锁保护的 basic_inifile 与按 section 分片的 concurrent_inifile
+ * - 输出不同线程数下的吞吐量
+ *
+ * 用法: inifile_concurrent_bench [ops_per_thread] [sections] [write_percent] [max_threads]
+ */
+#include <inifile/concurrent.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using bench_clock = std::chrono::steady_clock;
+
+struct workload
+{
+  std::size_t ops_per_thread;
+  std::size_t sections;
+  unsigned write_percent;
+};
+
+/// 简单的 xorshift 随机数, 避免在线程间共享随机数引擎
+static std::uint64_t next_random(std::uint64_t &state)
+{
+  state ^= state << 13;
+  state ^= state >> 7;
+  state ^= state << 17;
+  return state;
+}
+
+/// 运行 threads 个线程, 每个线程调用 op(thread_index, i, random) ops_per_thread 次, 返回 ops/s
+template <typename Op>
+static double run(std::size_t threads, const workload &w, Op op)
+{
+  std::atomic<bool> go{false};
+  std::vector<std::thread> pool;
+  for (std::size_t t = 0; t < threads; ++t)
+  {
+    pool.emplace_back([&, t] {
+      std::uint64_t state = 0x9E3779B97F4A7C15ULL * (t + 1);
+      while (!go.load()) std::this_thread::yield();
+      for (std::size_t i = 0; i < w.ops_per_thread; ++i) op(next_random(state));
+    });
+  }
+  const auto begin = bench_clock::now();
+  go = true;
+  for (auto &th : pool) th.join();
+  const double seconds = std::chrono::duration<double>(bench_clock::now() - begin).count();
+  return static_cast<double>(threads * w.ops_per_thread) / seconds;
+}
+
+int main(int argc, char **argv)
+{
+  workload w;
+  w.ops_per_thread = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200000;
+  w.sections = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 64;
+  w.write_percent = argc > 3 ? static_cast<unsigned>(std::strtoul(argv[3], nullptr, 10)) : 10;
+  std::size_t max_threads = argc > 4 ? std::strtoul(argv[4], nullptr, 10) : std::thread::hardware_concurrency();
+  if (max_threads == 0) max_threads = 4;
+  if (w.sections == 0) w.sections = 1;
+
+  std::vector<std::string> names;
+  for (std::size_t i = 0; i < w.sections; ++i) names.push_back("tenant" + std::to_string(i));
+  const std::size_t keys = 16;
+  std::vector<std::string> key_names;
+  for (std::size_t i = 0; i < keys; ++i) key_names.push_back("key" + std::to_string(i));
+
+  ini::inifile global;
+  ini::concurrent_inifile sharded;
+  for (const auto &sec : names)
+  {
+    for (const auto &key : key_names)
+    {
+      global.set(sec, key, 1);
+      sharded.set(sec, key, 1);
+    }
+  }
+
+  std::printf("%zu ops/thread, %zu sections, %u%% writes\n", w.ops_per_thread, w.sections, w.write_percent);
+  std::printf("%-8s %18s %18s %8s\n", "threads", "global mutex", "concurrent", "speedup");
+
+  std::mutex global_mutex;
+  for (std::size_t threads = 1; threads <= max_threads; threads *= 2)
+  {
+    const double global_ops = run(threads, w, [&](std::uint64_t r) {
+      const std::string &sec = names[r % names.size()];
+      const std::string &key = key_names[(r >> 16) % keys];
+      std::lock_guard<std::mutex> lock(global_mutex);
+      if ((r >> 32) % 100 < w.write_percent)
+        global.set(sec, key, static_cast<int>(r & 0xFFFF));
+      else
+        (void)global.get(sec, key);
+    });
+    const double sharded_ops = run(threads, w, [&](std::uint64_t r) {
+      const std::string &sec = names[r % names.size()];
+      const std::string &key = key_names[(r >> 16) % keys];
+      if ((r >> 32) % 100 < w.write_percent)
+        sharded.set(sec, key, static_cast<int>(r & 0xFFFF));
+      else
+        (void)sharded.get(sec, key);
+    });
+    std::printf("%-8zu %14.0f op/s %14.0f op/s %7.2fx\n", threads, global_ops, sharded_ops, sharded_ops / global_ops);
+  }
+  return 0;
+}
@@ -0,0 +1,190 @@
+/**
+ * 性能测试用的合成 INI 语料生成器
+ * - 由参数和随机种子确定性地生成文档: 相同的参数总是得到逐字节相同的输出
+ * - 可控制: 目标大小(1 KB ~ 数 GB, 流式输出, 不在内存中构造整个文档)、每个 section 的键数、值长度、
+ *   注释比例与行数、CRLF 换行、section/key 名的大小写变化
+ * - section 名为 Section<i>, key 名为 Key<j> (启用大小写变化时随机改变大小写), 便于在测试中构造命中/未命中的查找
+ */
+#ifndef INIFILE_BENCHMARKS_CORPUS_H_
+#define INIFILE_BENCHMARKS_CORPUS_H_
+
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <ostream>
+#include <sstream>
+#include <string>
+
+namespace bench
+{
+
+struct corpus_options
+{
+  std::uint64_t target_bytes = 64 * 1024;  // 生成的文档达到该大小后在 section 边界处停止
+  std::size_t keys_per_section = 50;
+  std::size_t min_value_length = 4;   // 字符串值的长度范围
+  std::size_t max_value_length = 32;
+  double comment_ratio = 0.1;     // 带注释的 key 所占比例 (section 同样按此比例带注释)
+  std::size_t comment_lines = 1;  // 每处注释的行数
+  bool crlf = false;              // 使用 \r\n 换行
+  bool vary_case = false;         // 随机改变 section/key 名的大小写
+  std::uint64_t seed = 1;
+};
+
+/// splitmix64, 用于生成确定性的伪随机序列
+class corpus_random
+{
+ public:
+  explicit corpus_random(std::uint64_t seed) : state_(seed) {}
+
+  std::uint64_t next()
+  {
+    std::uint64_t z = (state_ += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+  }
+  /// [0, n)
+  std::size_t below(std::size_t n)
+  {
+    return n == 0 ? 0 : static_cast<std::size_t>(next() % n);
+  }
+  /// [0, 1)
+  double unit()
+  {
+    return static_cast<double>(next() >> 11) * (1.0 / 9007199254740992.0);
+  }
+
+ private:
+  std::uint64_t state_;
+};
+
+namespace detail
+{
+inline void append_name(std::string &out, const char *prefix, std::size_t index, bool vary_case, corpus_random &rng)
+{
+  const std::size_t begin = out.size();
+  out += prefix;
+  out += std::to_string(index);
+  if (!vary_case) return;
+  switch (rng.below(4))
+  {
+    case 0:  // 全部大写
+      for (std::size_t i = begin; i < out.size(); ++i) out[i] = static_cast<char>(std::toupper(out[i]));
+      break;
+    case 1:  // 全部小写
+      for (std::size_t i = begin; i < out.size(); ++i) out[i] = static_cast<char>(std::tolower(out[i]));
+      break;
+    default:  // 保持原样
+      break;
+  }
+}
+
+inline void append_value(std::string &out, const corpus_options &opts, corpus_random &rng)
+{
+  static const char alphabet[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_-./";
+  switch (rng.below(5))
+  {
+    case 0:
+      out += std::to_string(static_cast<std::int64_t>(rng.next() % 2000000) - 1000000);
+      break;
+    case 1:  // 三位小数的浮点数
+    {
+      const std::uint64_t v = rng.next() % 1000000;
+      const std::uint64_t frac = v % 1000;
+      out += std::to_string(v / 1000);
+      out += '.';
+      out += static_cast<char>('0' + frac / 100);
+      out += static_cast<char>('0' + frac / 10 % 10);
+      out += static_cast<char>('0' + frac % 10);
+      break;
+    }
+    case 2:
+      out += rng.below(2) ? "true" : "false";
+      break;
+    default:
+    {
+      const std::size_t span = opts.max_value_length > opts.min_value_length
+                                 ? opts.max_value_length - opts.min_value_length + 1
+                                 : 1;
+      const std::size_t length = opts.min_value_length + rng.below(span);
+      for (std::size_t i = 0; i < length; ++i) out += alphabet[rng.below(sizeof(alphabet) - 1)];
+      break;
+    }
+  }
+}
+
+inline void append_comment(std::string &out, const corpus_options &opts, corpus_random &rng, const char *eol)
+{
+  for (std::size_t i = 0; i < opts.comment_lines; ++i)
+  {
+    out += rng.below(2) ? "; " : "# ";
+    out += "comment line ";
+    out += std::to_string(rng.next() % 100000);
+    out += eol;
+  }
+}
+}  // namespace detail
+
+/// @brief 将语料流式写入 os
+/// @return 写入的字节数
+inline std::uint64_t generate_corpus(std::ostream &os, const corpus_options &opts)
+{
+  corpus_random rng(opts.seed);
+  const char *eol = opts.crlf ? "\r\n" : "\n";
+  std::uint64_t written = 0;
+  std::string buffer;
+  for (std::size_t s = 0; written < opts.target_bytes; ++s)
+  {
+    buffer.clear();
+    if (s != 0) buffer += eol;
+    if (rng.unit() < opts.comment_ratio) detail::append_comment(buffer, opts, rng, eol);
+    buffer += '[';
+    detail::append_name(buffer, "Section", s, opts.vary_case, rng);
+    buffer += ']';
+    buffer += eol;
+    for (std::size_t k = 0; k < opts.keys_per_section; ++k)
+    {
+      if (rng.unit() < opts.comment_ratio) detail::append_comment(buffer, opts, rng, eol);
+      detail::append_name(buffer, "Key", k, opts.vary_case, rng);
+      buffer += rng.below(4) == 0 ? " = " : "=";
+      detail::append_value(buffer, opts, rng);
+      buffer += eol;
+    }
+    os.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    if (!os) break;
+    written += buffer.size();
+  }
+  return written;
+}
+
+/// @brief 生成语料并以字符串返回(适合较小的规模)
+inline std::string generate_corpus(const corpus_options &opts)
+{
+  std::ostringstream os;
+  generate_corpus(os, opts);
+  return os.str();
+}
+
+/// @brief 解析带单位的大小: "512", "64K", "16M", "2G" (1024 进制)
+inline std::uint64_t parse_size(const std::string &text)
+{
+  char *end = nullptr;
+  const double value = std::strtod(text.c_str(), &end);
+  std::uint64_t unit = 1;
+  if (end && *end)
+  {
+    switch (*end)
+    {
+      case 'k': case 'K': unit = 1024ULL; break;
+      case 'm': case 'M': unit = 1024ULL * 1024; break;
+      case 'g': case 'G': unit = 1024ULL * 1024 * 1024; break;
+      default: break;
+    }
+  }
+  return static_cast<std::uint64_t>(value * static_cast<double>(unit));
+}
+
+}  // namespace bench
+
+#endif  // INIFILE_BENCHMARKS_CORPUS_H_
@@ -0,0 +1,82 @@
+/**
+ * 合成 INI 语料生成工具, 参数见 corpus.h
+ *
+ * 用法: inifile_corpus [--size 64K] [--keys N] [--value-length MIN:MAX] [--comments RATIO] [--comment-lines N]
+ *                      [--crlf] [--vary-case] [--seed N] [-o FILE]
+ *       不指定 -o 时输出到标准输出
+ */
+#include "corpus.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+static int usage(const char *argv0)
+{
+  std::fprintf(stderr,
+               "usage: %s [--size 64K] [--keys N] [--value-length MIN:MAX] [--comments RATIO] [--comment-lines N]\n"
+               "          [--crlf] [--vary-case] [--seed N] [-o FILE]\n",
+               argv0);
+  return 2;
+}
+
+int main(int argc, char **argv)
+{
+  bench::corpus_options opts;
+  std::string output;
+  for (int i = 1; i < argc; ++i)
+  {
+    const std::string arg = argv[i];
+    const bool has_value = i + 1 < argc;
+    if (arg == "--size" && has_value)
+      opts.target_bytes = bench::parse_size(argv[++i]);
+    else if (arg == "--keys" && has_value)
+      opts.keys_per_section = std::strtoul(argv[++i], nullptr, 10);
+    else if (arg == "--value-length" && has_value)
+    {
+      const std::string range = argv[++i];
+      const std::size_t colon = range.find(':');
+      opts.min_value_length = std::strtoul(range.c_str(), nullptr, 10);
+      opts.max_value_length =
+        colon == std::string::npos ? opts.min_value_length : std::strtoul(range.c_str() + colon + 1, nullptr, 10);
+    }
+    else if (arg == "--comments" && has_value)
+      opts.comment_ratio = std::strtod(argv[++i], nullptr);
+    else if (arg == "--comment-lines" && has_value)
+      opts.comment_lines = std::strtoul(argv[++i], nullptr, 10);
+    else if (arg == "--crlf")
+      opts.crlf = true;
+    else if (arg == "--vary-case")
+      opts.vary_case = true;
+    else if (arg == "--seed" && has_value)
+      opts.seed = std::strtoull(argv[++i], nullptr, 10);
+    else if (arg == "-o" && has_value)
+      output = argv[++i];
+    else
+      return usage(argv[0]);
+  }
+
+  std::uint64_t written = 0;
+  if (output.empty())
+  {
+    written = bench::generate_corpus(std::cout, opts);
+    std::cout.flush();
+    if (!std::cout) return 1;
+  }
+  else
+  {
+    std::ofstream ofs(output, std::ios::binary);
+    if (!ofs)
+    {
+      std::fprintf(stderr, "cannot open %s\n", output.c_str());
+      return 1;
+    }
+    written = bench::generate_corpus(ofs, opts);
+    ofs.flush();
+    if (!ofs) return 1;
+  }
+  std::fprintf(stderr, "%llu bytes\n", static_cast<unsigned long long>(written));
+  return 0;
+}
@@ -0,0 +1,345 @@
+/**
+ * 核心接口性能测试套件
+ * - 解析: read / from_string / load
+ * - 序列化: write / to_string / save
+ * - 查找: get / at / contains, 命中与未命中, 大小写敏感与不敏感
+ * - 类型转换: as<T>
+ * - 拷贝 / 移动
+ * 每项测试自适应地选择迭代次数, 重复多轮取中位数. 结果输出到终端, 并可写入 JSON 文件以便跨版本对比.
+ * 解析和序列化测试使用 corpus.h 生成的语料, 在 --scales 指定的每个规模下各运行一次.
+ *
+ * 用法: inifile_bench [--json FILE] [--filter SUBSTRING] [--min-time SECONDS] [--repetitions N]
+ *                     [--scales 16K,1M,...] [--seed N]
+ *       --json - 表示输出到标准输出
+ */
+#include <inifile/inifile.h>
+
+#include "corpus.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifndef INIFILE_BENCH_VERSION
+#define INIFILE_BENCH_VERSION "unknown"
+#endif
+
+using bench_clock = std::chrono::steady_clock;
+
+/// 防止编译器优化掉被测代码的结果
+static volatile std::size_t g_sink = 0;
+
+static void keep(std::size_t value)
+{
+  g_sink = g_sink + value;
+}
+
+struct options
+{
+  std::string json_path;
+  std::string filter;
+  double min_time = 0.2;  // 每轮最短运行时间(秒)
+  int repetitions = 5;
+  std::vector<std::string> scales{"16K", "1M"};  // 解析/序列化测试的语料规模
+  std::uint64_t seed = 1;
+};
+
+struct result
+{
+  std::string name;
+  std::size_t iterations = 0;  // 每轮迭代次数
+  double ns_per_op = 0;        // 各轮的中位数
+  double min_ns_per_op = 0;
+  double max_ns_per_op = 0;
+  double bytes_per_second = 0;  // 只有处理字节流的测试才有意义, 否则为 0
+};
+
+class suite
+{
+ public:
+  explicit suite(options opts) : opts_(std::move(opts)) {}
+
+  /// 运行一项测试: op() 执行一次被测操作, bytes 为每次操作处理的字节数
+  template <typename Op>
+  void run(const std::string &name, Op op, std::size_t bytes = 0)
+  {
+    if (!opts_.filter.empty() && name.find(opts_.filter) == std::string::npos) return;
+
+    // 先估算迭代次数, 使一轮至少运行 min_time
+    std::size_t iterations = 1;
+    for (;;)
+    {
+      const double seconds = time(op, iterations) * 1e-9;
+      if (seconds >= opts_.min_time * 0.5 || iterations >= (std::size_t(1) << 40)) break;
+      double scale = seconds > 0 ? opts_.min_time / seconds : 100.0;
+      scale = (std::min)((std::max)(scale, 2.0), 100.0);
+      iterations = static_cast<std::size_t>(static_cast<double>(iterations) * scale);
+    }
+
+    std::vector<double> samples;
+    for (int r = 0; r < opts_.repetitions; ++r)
+    {
+      samples.push_back(time(op, iterations) / static_cast<double>(iterations));
+    }
+    std::sort(samples.begin(), samples.end());
+
+    result res;
+    res.name = name;
+    res.iterations = iterations;
+    res.ns_per_op = samples[samples.size() / 2];
+    res.min_ns_per_op = samples.front();
+    res.max_ns_per_op = samples.back();
+    if (bytes != 0) res.bytes_per_second = static_cast<double>(bytes) * 1e9 / res.ns_per_op;
+    std::printf("%-56s %12.1f ns/op  %12zu iters", name.c_str(), res.ns_per_op, iterations);
+    if (bytes != 0) std::printf("  %9.1f MB/s", res.bytes_per_second / 1e6);
+    std::printf("\n");
+    results_.push_back(res);
+  }
+
+  bool write_json() const
+  {
+    if (opts_.json_path.empty()) return true;
+    std::ostringstream os;
+    os << "{\n";
+    os << "  \"library\": \"inifile\",\n";
+    os << "  \"version\": \"" << INIFILE_BENCH_VERSION << "\",\n";
+    os << "  \"cplusplus\": " << __cplusplus << ",\n";
+#if defined(__clang__)
+    os << "  \"compiler\": \"clang " << __clang_major__ << "." << __clang_minor__ << "\",\n";
+#elif defined(__GNUC__)
+    os << "  \"compiler\": \"gcc " << __GNUC__ << "." << __GNUC_MINOR__ << "\",\n";
+#elif defined(_MSC_VER)
+    os << "  \"compiler\": \"msvc " << _MSC_VER << "\",\n";
+#else
+    os << "  \"compiler\": \"unknown\",\n";
+#endif
+#ifdef NDEBUG
+    os << "  \"optimized\": true,\n";
+#else
+    os << "  \"optimized\": false,\n";
+#endif
+    os << "  \"min_time\": " << opts_.min_time << ",\n";
+    os << "  \"repetitions\": " << opts_.repetitions << ",\n";
+    os << "  \"benchmarks\": [";
+    for (std::size_t i = 0; i < results_.size(); ++i)
+    {
+      const result &r = results_[i];
+      os << (i == 0 ? "\n" : ",\n");
+      os << "    {\"name\": \"" << r.name << "\", \"iterations\": " << r.iterations
+         << ", \"ns_per_op\": " << r.ns_per_op << ", \"min_ns_per_op\": " << r.min_ns_per_op
+         << ", \"max_ns_per_op\": " << r.max_ns_per_op << ", \"bytes_per_second\": " << r.bytes_per_second << "}";
+    }
+    os << "\n  ]\n}\n";
+
+    if (opts_.json_path == "-")
+    {
+      std::fputs(os.str().c_str(), stdout);
+      return true;
+    }
+    std::ofstream ofs(opts_.json_path, std::ios::binary);
+    ofs << os.str();
+    return static_cast<bool>(ofs);
+  }
+
+ private:
+  template <typename Op>
+  static double time(Op &op, std::size_t iterations)
+  {
+    const auto begin = bench_clock::now();
+    for (std::size_t i = 0; i < iterations; ++i) op();
+    const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(bench_clock::now() - begin);
+    return static_cast<double>(elapsed.count());
+  }
+
+  options opts_;
+  std::vector<result> results_;
+};
+
+static bool parse_options(int argc, char **argv, options &opts)
+{
+  for (int i = 1; i < argc; ++i)
+  {
+    const std::string arg = argv[i];
+    const bool has_value = i + 1 < argc;
+    if (arg == "--json" && has_value)
+      opts.json_path = argv[++i];
+    else if (arg == "--filter" && has_value)
+      opts.filter = argv[++i];
+    else if (arg == "--min-time" && has_value)
+      opts.min_time = std::strtod(argv[++i], nullptr);
+    else if (arg == "--repetitions" && has_value)
+      opts.repetitions = (std::max)(1, std::atoi(argv[++i]));
+    else if (arg == "--scales" && has_value)
+    {
+      opts.scales.clear();
+      std::istringstream list(argv[++i]);
+      for (std::string scale; std::getline(list, scale, ',');)
+      {
+        if (!scale.empty()) opts.scales.push_back(scale);
+      }
+    }
+    else if (arg == "--seed" && has_value)
+      opts.seed = std::strtoull(argv[++i], nullptr, 10);
+    else
+    {
+      std::fprintf(stderr,
+                   "usage: %s [--json FILE] [--filter SUBSTRING] [--min-time SECONDS] [--repetitions N]\n"
+                   "          [--scales 16K,1M,...] [--seed N]\n",
+                   argv[0]);
+      return false;
+    }
+  }
+  return true;
+}
+
+template <typename Inifile>
+static void lookup_benchmarks(suite &s, const std::string &prefix, const std::string &text)
+{
+  Inifile inif;
+  inif.from_string(text);
+  const Inifile &c = inif;
+  s.run(prefix + "/get/hit", [&] { keep(c.get("Section3", "Key17").str().size()); });
+  s.run(prefix + "/get/miss", [&] { keep(c.get("Section3", "NoSuchKey").str().size()); });
+  s.run(prefix + "/at/hit", [&] { keep(c.at("Section3").at("Key17").str().size()); });
+  s.run(prefix + "/contains/hit", [&] { keep(static_cast<std::size_t>(c.contains("Section3", "Key17"))); });
+  s.run(prefix + "/contains/miss", [&] { keep(static_cast<std::size_t>(c.contains("Section3", "NoSuchKey"))); });
+  s.run(prefix + "/contains/miss_section", [&] { keep(static_cast<std::size_t>(c.contains("Nope", "Key17"))); });
+  s.run(prefix + "/get/hit_other_case", [&] { keep(c.get("section3", "key17").str().size()); });
+}
+
+/// 在一个规模下运行解析和序列化测试
+static void scale_benchmarks(suite &s, const std::string &scale, bench::corpus_options corpus, const std::string &path)
+{
+  const std::string text = bench::generate_corpus(corpus);
+  {
+    std::ofstream ofs(path, std::ios::binary);
+    ofs << text;
+  }
+  std::printf("corpus %s: %zu bytes\n", scale.c_str(), text.size());
+
+  // 解析
+  s.run("parse/from_string/" + scale, [&] {
+    ini::inifile inif;
+    inif.from_string(text);
+    keep(inif.size());
+  }, text.size());
+  s.run("parse/read/" + scale, [&] {
+    std::istringstream is(text);
+    ini::inifile inif;
+    inif.read(is);
+    keep(inif.size());
+  }, text.size());
+  s.run("parse/load/" + scale, [&] {
+    ini::inifile inif;
+    inif.load(path);
+    keep(inif.size());
+  }, text.size());
+
+  // 生产环境中常见的形态: 大小写混杂的名字, 较多注释, CRLF 换行
+  corpus.vary_case = true;
+  corpus.comment_ratio = 0.5;
+  corpus.comment_lines = 2;
+  corpus.crlf = true;
+  const std::string mixed = bench::generate_corpus(corpus);
+  s.run("parse/from_string/case_insensitive+comments+crlf/" + scale, [&] {
+    ini::case_insensitive_inifile inif;
+    inif.from_string(mixed);
+    keep(inif.size());
+  }, mixed.size());
+
+  // 序列化
+  ini::inifile doc;
+  doc.from_string(text);
+  const std::size_t out_size = doc.to_string().size();
+  s.run("serialize/to_string/" + scale, [&] { keep(doc.to_string().size()); }, out_size);
+  s.run("serialize/write/" + scale, [&] {
+    std::ostringstream os;
+    doc.write(os);
+    keep(static_cast<std::size_t>(os.tellp()));
+  }, out_size);
+  s.run("serialize/save/" + scale, [&] { keep(static_cast<std::size_t>(doc.save(path))); }, out_size);
+}
+
+int main(int argc, char **argv)
+{
+  options opts;
+  if (!parse_options(argc, argv, opts)) return 2;
+  suite s(opts);
+
+  const std::string path = "inifile_bench.ini";
+  for (const std::string &scale : opts.scales)
+  {
+    bench::corpus_options corpus;
+    corpus.target_bytes = bench::parse_size(scale);
+    corpus.seed = opts.seed;
+    scale_benchmarks(s, scale, corpus, path);
+  }
+
+  // 查找 / 类型转换 / 拷贝使用固定的小文档: 约 30 个 section, 每个 50 个键
+  bench::corpus_options small;
+  small.target_bytes = 32 * 1024;
+  small.seed = opts.seed;
+  const std::string text = bench::generate_corpus(small);
+  ini::inifile doc;
+  doc.from_string(text);
+
+  // 查找
+  lookup_benchmarks<ini::inifile>(s, "lookup/case_sensitive", text);
+  lookup_benchmarks<ini::case_insensitive_inifile>(s, "lookup/case_insensitive", text);
+
+  // 类型转换
+  const ini::field int_field = 123456789;
+  const ini::field double_field = 3.14159265358979;
+  const ini::field bool_field = true;
+  const ini::field string_field = "value_with_some_longer_text";
+  s.run("convert/as<int>", [&] { keep(static_cast<std::size_t>(int_field.as<int>())); });
+  s.run("convert/as<long long>", [&] { keep(static_cast<std::size_t>(int_field.as<long long>())); });
+  s.run("convert/as<double>", [&] { keep(static_cast<std::size_t>(double_field.as<double>())); });
+  s.run("convert/as<bool>", [&] { keep(static_cast<std::size_t>(bool_field.as<bool>())); });
+  s.run("convert/as<std::string>", [&] { keep(string_field.as<std::string>().size()); });
+  s.run("convert/set<int>", [&] {
+    ini::field f;
+    f = 123456789;
+    keep(f.str().size());
+  });
+  s.run("convert/set<double>", [&] {
+    ini::field f;
+    f = 3.14159265358979;
+    keep(f.str().size());
+  });
+
+  // 拷贝 / 移动
+  s.run("copy/inifile", [&] {
+    ini::inifile copy = doc;
+    keep(copy.size());
+  });
+  s.run("copy/inifile+modify_all", [&] {
+    ini::inifile copy = doc;
+    for (auto &sec : copy) sec.second.set("Key0", 1);  // 写时复制: 每个 section 都被真正复制
+    keep(copy.size());
+  });
+  s.run("copy/section", [&] {
+    ini::section copy = doc.at("Section3");
+    keep(copy.size());
+  });
+  s.run("move/inifile", [&] {
+    ini::inifile a = doc;
+    ini::inifile b = std::move(a);
+    keep(b.size());
+  });
+
+  std::remove(path.c_str());
+  if (!s.write_json())
+  {
+    std::fprintf(stderr, "failed to write %s\n", opts.json_path.c_str());
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,97 @@
+/**
+ * 日志模式(journaled_inifile)性能测试
+ * - 追加一条日志记录的延迟, 与每次修改都调用 save() 全量重写对比
+ * - 重放日志的吞吐量
+ *
+ * 用法: inifile_journal_bench [updates] [keys]
+ */
+#include <inifile/journal.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using bench_clock = std::chrono::steady_clock;
+
+static double elapsed_ns(bench_clock::time_point begin, bench_clock::time_point end)
+{
+  return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count());
+}
+
+static void report(const char *name, std::vector<double> samples)
+{
+  std::sort(samples.begin(), samples.end());
+  double total = 0;
+  for (double s : samples) total += s;
+  std::printf("%-28s n=%-8zu mean=%10.0f ns  p50=%10.0f ns  p99=%10.0f ns\n", name, samples.size(),
+              total / static_cast<double>(samples.size()), samples[samples.size() / 2],
+              samples[samples.size() * 99 / 100]);
+}
+
+int main(int argc, char **argv)
+{
+  const std::size_t updates = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000;
+  const std::size_t keys = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1000;
+  const std::string path = "journal_bench.ini";
+
+  ini::inifile base;
+  for (std::size_t i = 0; i < keys; ++i)
+  {
+    base["section" + std::to_string(i % 20)]["key" + std::to_string(i)] = i;
+  }
+  base.save(path);
+  std::remove((path + ".journal").c_str());
+
+  std::printf("base file: %zu keys, %zu updates\n", keys, updates);
+
+  // 1. 每次修改都全量 save()
+  {
+    ini::inifile inif = base;
+    std::vector<double> samples;
+    const std::size_t n = (std::min)(updates, static_cast<std::size_t>(1000));
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      auto begin = bench_clock::now();
+      inif.set("section" + std::to_string(i % 20), "key" + std::to_string(i % keys), i * 2);
+      inif.save(path);
+      samples.push_back(elapsed_ns(begin, bench_clock::now()));
+    }
+    report("set + save()", samples);
+  }
+
+  // 2. 日志模式追加
+  {
+    ini::journaled_inifile jini;
+    jini.load(path);
+    std::vector<double> samples;
+    samples.reserve(updates);
+    for (std::size_t i = 0; i < updates; ++i)
+    {
+      auto begin = bench_clock::now();
+      jini.set("section" + std::to_string(i % 20), "key" + std::to_string(i % keys), i * 2);
+      samples.push_back(elapsed_ns(begin, bench_clock::now()));
+    }
+    report("journaled set", samples);
+  }
+
+  // 3. 重放日志
+  {
+    ini::journaled_inifile jini;
+    auto begin = bench_clock::now();
+    jini.load(path);
+    const double ns = elapsed_ns(begin, bench_clock::now());
+    std::printf("%-28s records=%zu  %.0f ns  %.0f records/s\n", "load + replay", jini.journal_records(), ns,
+                static_cast<double>(jini.journal_records()) * 1e9 / ns);
+
+    begin = bench_clock::now();
+    jini.compact();
+    std::printf("%-28s %.0f ns\n", "compact", elapsed_ns(begin, bench_clock::now()));
+  }
+
+  std::remove(path.c_str());
+  std::remove((path + ".journal").c_str());
+  return 0;
+}
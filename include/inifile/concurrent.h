@@ -0,0 +1,351 @@
+/**************************************************************************************************************
+ *~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * @file: concurrent.h
+ * @description: Thread-safe ini container for mixed read/write workloads.
+ * - The section map is striped into N shards (by section-name hash), each guarded by its own reader-writer lock.
+ * - Every section is guarded by its own reader-writer lock, shard locks are only held while looking up,
+ *   inserting or erasing a section. Operations on different sections therefore never contend.
+ * - Reader-writer lock: std::shared_mutex (C++17), std::shared_timed_mutex (C++14), std::mutex (C++11).
+ *
+ * @license: MIT
+ * @repository: https://github.com/abin-z/inifile
+ *~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ **************************************************************************************************************/
+
+#ifndef INI_FILE_CONCURRENT_H_
+#define INI_FILE_CONCURRENT_H_
+
+#include <inifile/inifile.h>
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifndef INIFILE_CPLUSPLUS
+#if defined(_MSVC_LANG) && _MSVC_LANG > __cplusplus
+#define INIFILE_CPLUSPLUS _MSVC_LANG
+#else
+#define INIFILE_CPLUSPLUS __cplusplus
+#endif
+#endif
+
+#if INIFILE_CPLUSPLUS >= 201402L
+#include <shared_mutex>
+#endif
+
+namespace ini
+{
+
+namespace detail
+{
+#if INIFILE_CPLUSPLUS >= 201703L
+using shared_mutex = std::shared_mutex;
+template <typename Mutex>
+using shared_lock = std::shared_lock<Mutex>;
+#elif INIFILE_CPLUSPLUS >= 201402L
+using shared_mutex = std::shared_timed_mutex;
+template <typename Mutex>
+using shared_lock = std::shared_lock<Mutex>;
+#else
+using shared_mutex = std::mutex;  // C++11 没有读写锁, 退化为互斥锁
+template <typename Mutex>
+using shared_lock = std::unique_lock<Mutex>;
+#endif
+}  // namespace detail
+
+/// @brief Section-sharded thread-safe ini container
+template <typename Hash = std::hash<std::string>, typename Equal = std::equal_to<std::string>,
+          template <typename...> class Map = std::unordered_map>
+class basic_concurrent_inifile
+{
+ public:
+  using inifile_type = basic_inifile<Hash, Equal, Map>;
+  using section_type = basic_section<Hash, Equal, Map>;
+
+  /// @param shard_count Number of shards (at least 1)
+  explicit basic_concurrent_inifile(std::size_t shard_count = 16) :
+    shards_(shard_count == 0 ? 1 : shard_count)
+  {
+  }
+
+  basic_concurrent_inifile(const basic_concurrent_inifile &) = delete;
+  basic_concurrent_inifile &operator=(const basic_concurrent_inifile &) = delete;
+
+  /// @brief Set section key-value, the section is created if it does not exist.
+  template <typename T>
+  void set(std::string sec, std::string key, T &&value)
+  {
+    detail::trim(sec);
+    detail::trim(key);
+    field f(std::forward<T>(value));
+    for (;;)
+    {
+      auto guarded = get_or_create(sec);
+      std::lock_guard<detail::shared_mutex> lock(guarded->mutex);
+      if (guarded->removed) continue;  // section 在此期间被删除, 重新创建
+      guarded->data[key] = std::move(f);
+      return;
+    }
+  }
+
+  /// @brief Returns a copy of the field value, or `default_value` if the section or key does not exist.
+  field get(std::string sec, std::string key, field default_value = field{}) const
+  {
+    detail::trim(sec);
+    auto guarded = find_section(sec);
+    if (!guarded) return default_value;
+    detail::shared_lock<detail::shared_mutex> lock(guarded->mutex);
+    return guarded->data.get(std::move(key), std::move(default_value));
+  }
+
+  bool contains(std::string sec) const
+  {
+    detail::trim(sec);
+    return find_section(sec) != nullptr;
+  }
+
+  bool contains(std::string sec, std::string key) const
+  {
+    detail::trim(sec);
+    auto guarded = find_section(sec);
+    if (!guarded) return false;
+    detail::shared_lock<detail::shared_mutex> lock(guarded->mutex);
+    return guarded->data.contains(std::move(key));
+  }
+
+  /// @brief Remove a key-value pair.
+  /// @return Return true if the key existed
+  bool remove(std::string sec, std::string key)
+  {
+    detail::trim(sec);
+    auto guarded = find_section(sec);
+    if (!guarded) return false;
+    std::lock_guard<detail::shared_mutex> lock(guarded->mutex);
+    return guarded->data.remove(std::move(key));
+  }
+
+  /// @brief Remove a section.
+  /// @return Return true if the section existed
+  bool remove(std::string sec)
+  {
+    detail::trim(sec);
+    shard &sh = shard_for(sec);
+    std::shared_ptr<guarded_section> guarded;
+    {
+      std::lock_guard<detail::shared_mutex> lock(sh.mutex);
+      auto it = sh.sections.find(sec);
+      if (it == sh.sections.end()) return false;
+      guarded = std::move(it->second);
+      sh.sections.erase(it);
+    }
+    std::lock_guard<detail::shared_mutex> lock(guarded->mutex);
+    guarded->removed = true;  // 通知仍持有该 section 的写入者重新查找
+    return true;
+  }
+
+  /// @brief Read a section under its shared lock.
+  /// @param fn Callable with signature `void(const section_type &)`
+  /// @return Return false if the section does not exist
+  template <typename Fn>
+  bool read_section(std::string sec, Fn &&fn) const
+  {
+    detail::trim(sec);
+    auto guarded = find_section(sec);
+    if (!guarded) return false;
+    detail::shared_lock<detail::shared_mutex> lock(guarded->mutex);
+    fn(static_cast<const section_type &>(guarded->data));
+    return true;
+  }
+
+  /// @brief Modify a section under its exclusive lock (several keys are updated atomically).
+  ///        The section is created if it does not exist.
+  /// @param fn Callable with signature `void(section_type &)`
+  template <typename Fn>
+  void update_section(std::string sec, Fn &&fn)
+  {
+    detail::trim(sec);
+    for (;;)
+    {
+      auto guarded = get_or_create(sec);
+      std::lock_guard<detail::shared_mutex> lock(guarded->mutex);
+      if (guarded->removed) continue;
+      fn(guarded->data);
+      return;
+    }
+  }
+
+  /// @brief Number of sections.
+  std::size_t size() const
+  {
+    std::size_t n = 0;
+    for (const shard &sh : shards_)
+    {
+      detail::shared_lock<detail::shared_mutex> lock(sh.mutex);
+      n += sh.sections.size();
+    }
+    return n;
+  }
+
+  /// @brief All section names (unordered).
+  std::vector<std::string> sections() const
+  {
+    std::vector<std::string> result;
+    for (const shard &sh : shards_)
+    {
+      detail::shared_lock<detail::shared_mutex> lock(sh.mutex);
+      for (const auto &pair : sh.sections) result.push_back(pair.first);
+    }
+    return result;
+  }
+
+  /// @brief Copy the content into a plain `basic_inifile`.
+  ///        Every section is copied consistently, the copy is not a global point-in-time snapshot.
+  inifile_type snapshot() const
+  {
+    inifile_type result;
+    for (const shard &sh : shards_)
+    {
+      std::vector<std::pair<std::string, std::shared_ptr<guarded_section>>> sections;
+      {
+        detail::shared_lock<detail::shared_mutex> lock(sh.mutex);
+        sections.assign(sh.sections.begin(), sh.sections.end());
+      }
+      for (const auto &pair : sections)
+      {
+        detail::shared_lock<detail::shared_mutex> lock(pair.second->mutex);
+        if (!pair.second->removed) result[pair.first] = pair.second->data;
+      }
+    }
+    return result;
+  }
+
+  /// @brief Replace the content with `content`.
+  ///        Readers never see an empty or half-cleared container: every incoming section is first replaced
+  ///        as a whole under its exclusive lock, then the sections absent from `content` are removed.
+  ///        While the call runs a reader may see a mix of old and new sections (each one entirely old or
+  ///        entirely new) and, until the final pass, sections that `content` no longer has.
+  void assign(const inifile_type &content)
+  {
+    for (const auto &pair : content)
+    {
+      update_section(pair.first, [&pair](section_type &s) { s = pair.second; });
+    }
+    for (shard &sh : shards_)
+    {
+      std::vector<std::shared_ptr<guarded_section>> stale;
+      {
+        std::lock_guard<detail::shared_mutex> lock(sh.mutex);
+        for (auto it = sh.sections.begin(); it != sh.sections.end();)
+        {
+          if (content.find(it->first) != content.end())
+          {
+            ++it;
+            continue;
+          }
+          stale.push_back(std::move(it->second));
+          it = sh.sections.erase(it);
+        }
+      }
+      for (auto &guarded : stale)
+      {
+        std::lock_guard<detail::shared_mutex> lock(guarded->mutex);
+        guarded->removed = true;  // 通知仍持有该 section 的写入者重新查找
+      }
+    }
+  }
+
+  /// @brief Remove all sections.
+  void clear()
+  {
+    for (shard &sh : shards_)
+    {
+      Map<std::string, std::shared_ptr<guarded_section>, Hash, Equal> removed;
+      {
+        std::lock_guard<detail::shared_mutex> lock(sh.mutex);
+        removed.swap(sh.sections);
+      }
+      for (auto &pair : removed)
+      {
+        std::lock_guard<detail::shared_mutex> lock(pair.second->mutex);
+        pair.second->removed = true;
+      }
+    }
+  }
+
+  /// @brief Load an ini file, replacing the current content (see `assign()` for what readers see meanwhile).
+  /// @return Whether the loading is successful, the content is unchanged on failure
+  bool load(const std::string &filename)
+  {
+    inifile_type content;
+    if (!content.load(filename)) return false;
+    assign(content);
+    return true;
+  }
+
+  /// @brief Save the content (see `snapshot()`) to an ini file.
+  bool save(const std::string &filename) const
+  {
+    return snapshot().save(filename);
+  }
+
+ private:
+  struct guarded_section
+  {
+    mutable detail::shared_mutex mutex;
+    section_type data;
+    bool removed = false;  // 已从分片中删除
+  };
+
+  struct shard
+  {
+    mutable detail::shared_mutex mutex;
+    Map<std::string, std::shared_ptr<guarded_section>, Hash, Equal> sections;
+  };
+
+  shard &shard_for(const std::string &sec)
+  {
+    return shards_[hash_(sec) % shards_.size()];
+  }
+  const shard &shard_for(const std::string &sec) const
+  {
+    return shards_[hash_(sec) % shards_.size()];
+  }
+
+  std::shared_ptr<guarded_section> find_section(const std::string &sec) const
+  {
+    const shard &sh = shard_for(sec);
+    detail::shared_lock<detail::shared_mutex> lock(sh.mutex);
+    auto it = sh.sections.find(sec);
+    return it == sh.sections.end() ? nullptr : it->second;
+  }
+
+  std::shared_ptr<guarded_section> get_or_create(const std::string &sec)
+  {
+    {
+      auto found = find_section(sec);
+      if (found) return found;
+    }
+    shard &sh = shard_for(sec);
+    std::lock_guard<detail::shared_mutex> lock(sh.mutex);
+    std::shared_ptr<guarded_section> &slot = sh.sections[sec];
+    if (!slot) slot = std::make_shared<guarded_section>();
+    return slot;
+  }
+
+ private:
+  Hash hash_;
+  std::vector<shard> shards_;
+};
+
+/// @brief concurrent_inifile class
+using concurrent_inifile = basic_concurrent_inifile<>;
+/// @brief case_insensitive_concurrent_inifile class
+using case_insensitive_concurrent_inifile =
+  basic_concurrent_inifile<detail::case_insensitive_hash, detail::case_insensitive_equal>;
+
+}  // namespace ini
+
+#endif  // INI_FILE_CONCURRENT_H_
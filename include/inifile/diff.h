@@ -0,0 +1,313 @@
+/**************************************************************************************************************
+ *~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * @file: diff.h
+ * @description: Structural diff and three-way merge between inifiles.
+ * - `ini::diff(a, b)` returns the added, removed and modified sections and keys (a -> b).
+ * - `ini::merge3(base, ours, theirs)` merges two independent edits of `base` and reports conflicts.
+ * - Sections sharing copy-on-write storage, or with equal (cached) fingerprints, are treated as identical
+ *   and skipped without comparing their fields.
+ *
+ * @license: MIT
+ * @repository: https://github.com/abin-z/inifile
+ *~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ **************************************************************************************************************/
+
+#ifndef INI_FILE_DIFF_H_
+#define INI_FILE_DIFF_H_
+
+#include <inifile/inifile.h>
+
+#include <string>
+#include <vector>
+
+namespace ini
+{
+
+/// @brief Kind of a change between two inifiles.
+enum class change_kind
+{
+  added,
+  removed,
+  modified
+};
+
+/// @brief A changed section. `modified` means its keys or its comment changed.
+struct section_change
+{
+  std::string section;
+  change_kind kind;
+};
+
+/// @brief A changed key-value pair, with its value before and after the change.
+///        Keys of added/removed sections are reported as added/removed keys as well.
+struct key_change
+{
+  std::string section;
+  std::string key;
+  change_kind kind;
+  std::string old_value;  // empty if the key was added
+  std::string new_value;  // empty if the key was removed
+};
+
+/// @brief A conflict found by `ini::merge3()`: both sides changed the same item in different ways.
+///        `key` is empty for a section-level conflict (the section comment was changed differently, or the section
+///        was removed on one side and modified on the other).
+struct merge_conflict
+{
+  std::string section;
+  std::string key;
+  std::string base_value;   // empty if the key does not exist in base
+  std::string our_value;    // empty if the key does not exist in ours
+  std::string their_value;  // empty if the key does not exist in theirs
+};
+
+/// @brief Result of `ini::merge3()`.
+template <typename Inifile>
+struct merge_result
+{
+  Inifile merged;                         // conflicting items keep the value of `ours`
+  std::vector<merge_conflict> conflicts;
+
+  /// @brief Whether the merge had no conflict.
+  bool clean() const noexcept
+  {
+    return conflicts.empty();
+  }
+};
+
+/// @brief Result of `ini::diff()`.
+struct diff_result
+{
+  std::vector<section_change> sections;
+  std::vector<key_change> keys;
+
+  /// @brief Whether the two inifiles are identical.
+  bool empty() const noexcept
+  {
+    return sections.empty() && keys.empty();
+  }
+};
+
+namespace detail
+{
+/// @brief 查找 section, 不存在时返回 nullptr
+template <typename Inifile>
+const typename Inifile::mapped_type *find_section(const Inifile &inif, const typename Inifile::key_type &name)
+{
+  auto it = inif.find(name);
+  return it == inif.end() ? nullptr : &it->second;
+}
+
+/// @brief 查找 key, 不存在时返回 nullptr
+template <typename Section>
+const typename Section::mapped_type *find_field(const Section *sec, const typename Section::key_type &key)
+{
+  if (!sec) return nullptr;
+  auto it = sec->find(key);
+  return it == sec->end() ? nullptr : &it->second;
+}
+
+/// @brief 两个 section 是否相同(nullptr 表示不存在): 共享存储或指纹相等时不再逐个比较字段
+template <typename Section>
+bool same_section(const Section *a, const Section *b)
+{
+  if (!a || !b) return a == b;
+  return a->shares_storage_with(*b) || a->fingerprint() == b->fingerprint();
+}
+
+template <typename Field>
+bool same_field(const Field *a, const Field *b)
+{
+  if (!a || !b) return a == b;
+  return a->str() == b->str() && a->comment() == b->comment();
+}
+
+/// @brief field 的值(不存在时为空), 使用其他分配器的字符串会复制为 std::string
+template <typename Field>
+std::string value_of(const Field *f)
+{
+  return f ? to_std_string(f->str()) : std::string();
+}
+
+/// @brief 比较两个 section, 将 key 的变化追加到 result 中, 返回 section 是否有变化
+template <typename Section>
+bool diff_section(const typename Section::key_type &name, const Section &from, const Section &to, diff_result &result)
+{
+  bool changed = from.comment() != to.comment();
+  for (const auto &kv : from)
+  {
+    auto it = to.find(kv.first);
+    if (it == to.end())
+    {
+      result.keys.push_back({to_std_string(name), to_std_string(kv.first), change_kind::removed,
+                             to_std_string(kv.second.str()), std::string()});
+      changed = true;
+    }
+    else if (!same_field(&kv.second, &it->second))
+    {
+      result.keys.push_back({to_std_string(name), to_std_string(kv.first), change_kind::modified,
+                             to_std_string(kv.second.str()), to_std_string(it->second.str())});
+      changed = true;
+    }
+  }
+  for (const auto &kv : to)
+  {
+    if (from.find(kv.first) == from.end())
+    {
+      result.keys.push_back({to_std_string(name), to_std_string(kv.first), change_kind::added, std::string(),
+                             to_std_string(kv.second.str())});
+      changed = true;
+    }
+  }
+  return changed;
+}
+
+/// @brief 三方合并一个双方都修改过的 section, base/theirs 为 nullptr 表示不存在
+template <typename Section>
+Section merge_section(const typename Section::key_type &name, const Section *base, const Section &ours, const Section *theirs,
+                      std::vector<merge_conflict> &conflicts)
+{
+  static const Section empty_section;
+  const Section &b = base ? *base : empty_section;
+  const Section &t = theirs ? *theirs : empty_section;
+
+  Section out;
+  if (ours.comment() == t.comment() || t.comment() == b.comment())
+  {
+    out.set_comment(ours.comment());
+  }
+  else if (ours.comment() == b.comment())
+  {
+    out.set_comment(t.comment());
+  }
+  else
+  {
+    conflicts.push_back({to_std_string(name), std::string(), std::string(), std::string(), std::string()});
+    out.set_comment(ours.comment());
+  }
+
+  using field_type = typename Section::mapped_type;
+  auto merge_key = [&](const typename Section::key_type &key, const field_type *o, const field_type *th) {
+    const field_type *bf = find_field(&b, key);
+    const field_type *pick = o;
+    if (same_field(o, th) || same_field(th, bf))
+    {
+      pick = o;
+    }
+    else if (same_field(o, bf))
+    {
+      pick = th;
+    }
+    else
+    {
+      conflicts.push_back({to_std_string(name), to_std_string(key), value_of(bf), value_of(o), value_of(th)});
+    }
+    if (pick) out[key] = *pick;
+  };
+  for (const auto &kv : ours) merge_key(kv.first, &kv.second, find_field(&t, kv.first));
+  for (const auto &kv : t)
+  {
+    if (ours.find(kv.first) == ours.end()) merge_key(kv.first, nullptr, &kv.second);
+  }
+  return out;
+}
+}  // namespace detail
+
+/// @brief Compute the structural difference from `from` to `to`.
+/// @param from Old inifile
+/// @param to New inifile
+/// @return Added, removed and modified sections and keys
+template <typename Hash, typename Equal, template <typename...> class Map, typename Allocator, typename CommentPolicy>
+diff_result diff(const basic_inifile<Hash, Equal, Map, Allocator, CommentPolicy> &from,
+                 const basic_inifile<Hash, Equal, Map, Allocator, CommentPolicy> &to)
+{
+  using section_type = typename basic_inifile<Hash, Equal, Map, Allocator, CommentPolicy>::mapped_type;
+  static const section_type empty_section;
+
+  diff_result result;
+  for (const auto &sec : from)
+  {
+    auto it = to.find(sec.first);
+    if (it == to.end())
+    {
+      result.sections.push_back({detail::to_std_string(sec.first), change_kind::removed});
+      detail::diff_section(sec.first, sec.second, empty_section, result);
+    }
+    else if (detail::same_section(&sec.second, &it->second))
+    {
+      continue;  // 相同的 section 不逐个比较字段
+    }
+    else if (detail::diff_section(sec.first, sec.second, it->second, result))
+    {
+      result.sections.push_back({detail::to_std_string(sec.first), change_kind::modified});
+    }
+  }
+  for (const auto &sec : to)
+  {
+    if (from.find(sec.first) == from.end())
+    {
+      result.sections.push_back({detail::to_std_string(sec.first), change_kind::added});
+      detail::diff_section(sec.first, empty_section, sec.second, result);
+    }
+  }
+  return result;
+}
+
+/// @brief Three-way merge: apply the changes made in `ours` and in `theirs` (both relative to `base`).
+///        An item changed only on one side takes that side's version, an item changed identically on both
+///        sides is taken once. An item changed differently on both sides is a conflict: it is reported and keeps
+///        the version of `ours`. Unchanged sections are copied without copying their data (copy-on-write).
+/// @param base Common ancestor
+/// @param ours First edited version
+/// @param theirs Second edited version
+/// @return The merged inifile and the list of conflicts
+template <typename Hash, typename Equal, template <typename...> class Map, typename Allocator, typename CommentPolicy>
+merge_result<basic_inifile<Hash, Equal, Map, Allocator, CommentPolicy>> merge3(
+  const basic_inifile<Hash, Equal, Map, Allocator, CommentPolicy> &base,
+  const basic_inifile<Hash, Equal, Map, Allocator, CommentPolicy> &ours,
+  const basic_inifile<Hash, Equal, Map, Allocator, CommentPolicy> &theirs)
+{
+  merge_result<basic_inifile<Hash, Equal, Map, Allocator, CommentPolicy>> result;
+  for (const auto &sec : ours)
+  {
+    const auto *b = detail::find_section(base, sec.first);
+    const auto *t = detail::find_section(theirs, sec.first);
+    if (detail::same_section(&sec.second, t) || detail::same_section(t, b))
+    {
+      result.merged[sec.first] = sec.second;  // 只有 ours 修改了(或双方相同)
+    }
+    else if (detail::same_section(&sec.second, b))
+    {
+      if (t) result.merged[sec.first] = *t;  // 只有 theirs 修改了, t 为 nullptr 表示 theirs 删除了该 section
+    }
+    else if (!t)
+    {
+      // theirs 删除了 section, ours 修改了它
+      result.conflicts.push_back({detail::to_std_string(sec.first), std::string(), std::string(), std::string(), std::string()});
+      result.merged[sec.first] = sec.second;
+    }
+    else
+    {
+      result.merged[sec.first] = detail::merge_section(sec.first, b, sec.second, t, result.conflicts);
+    }
+  }
+  for (const auto &sec : theirs)
+  {
+    if (ours.find(sec.first) != ours.end()) continue;
+    const auto *b = detail::find_section(base, sec.first);
+    if (!b)
+    {
+      result.merged[sec.first] = sec.second;  // theirs 新增的 section
+    }
+    else if (!detail::same_section(&sec.second, b))
+    {
+      // ours 删除了 section, theirs 修改了它, 保留 ours 的删除
+      result.conflicts.push_back({detail::to_std_string(sec.first), std::string(), std::string(), std::string(), std::string()});
+    }
+  }
+  return result;
+}
+
+}  // namespace ini
+
+#endif  // INI_FILE_DIFF_H_
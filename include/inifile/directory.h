@@ -0,0 +1,191 @@
+/**************************************************************************************************************
+ *~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * @file: directory.h
+ * @description: Loading a `conf.d` style directory of ini files.
+ * - `ini::load_directory(inif, path, pattern)` parses the matching files concurrently into separate inifiles and
+ *   merges them in lexical filename order (later files override earlier ones). Sections are moved into the
+ *   result, not copied.
+ * - Per-file sizes and parse times are reported in a `directory_load_report`.
+ *
+ * @license: MIT
+ * @repository: https://github.com/abin-z/inifile
+ *~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ **************************************************************************************************************/
+
+#ifndef INI_FILE_DIRECTORY_H_
+#define INI_FILE_DIRECTORY_H_
+
+#include <inifile/include.h>
+#include <inifile/inifile.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+namespace ini
+{
+
+/// @brief Load result of one file of `ini::load_directory()`.
+struct file_load_stat
+{
+  std::string filename;                    // path of the file
+  std::size_t bytes = 0;                   // file size
+  std::chrono::microseconds parse_time{0};  // read + parse time
+  bool ok = false;                         // whether the file was read successfully
+};
+
+/// @brief Report of `ini::load_directory()`, files are listed in merge (lexical) order.
+struct directory_load_report
+{
+  std::vector<file_load_stat> files;
+  std::chrono::microseconds total_time{0};  // wall time of the whole load, including the merge
+};
+
+namespace detail
+{
+/// @brief 通配符匹配, 支持 `*` (任意个字符) 和 `?` (单个字符)
+inline bool wildcard_match(const std::string &pattern, const std::string &name)
+{
+  std::size_t p = 0, n = 0;
+  std::size_t star = std::string::npos, resume = 0;
+  while (n < name.size())
+  {
+    if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == name[n]))
+    {
+      ++p;
+      ++n;
+    }
+    else if (p < pattern.size() && pattern[p] == '*')
+    {
+      star = p++;
+      resume = n;
+    }
+    else if (star != std::string::npos)
+    {
+      p = star + 1;
+      n = ++resume;
+    }
+    else
+    {
+      return false;
+    }
+  }
+  while (p < pattern.size() && pattern[p] == '*') ++p;
+  return p == pattern.size();
+}
+
+/// @brief 列出目录中与 pattern 匹配的普通文件名(不含目录部分)
+/// @return 目录无法打开时返回 false
+inline bool list_directory(const std::string &dir, const std::string &pattern, std::vector<std::string> &names)
+{
+#if defined(_WIN32)
+  struct _finddata_t data;
+  const intptr_t handle = _findfirst((dir + "\\*").c_str(), &data);
+  if (handle == -1) return false;
+  do
+  {
+    if ((data.attrib & _A_SUBDIR) == 0 && wildcard_match(pattern, data.name)) names.push_back(data.name);
+  } while (_findnext(handle, &data) == 0);
+  _findclose(handle);
+#else
+  DIR *d = ::opendir(dir.c_str());
+  if (!d) return false;
+  while (const struct dirent *entry = ::readdir(d))
+  {
+    const std::string name = entry->d_name;
+    if (!wildcard_match(pattern, name)) continue;
+    struct stat st;
+    if (::stat((dir + "/" + name).c_str(), &st) == 0 && S_ISREG(st.st_mode)) names.push_back(name);
+  }
+  ::closedir(d);
+#endif
+  return true;
+}
+}  // namespace detail
+
+/// @brief Load all files of a directory matching `pattern`, replacing the content of `inif`.
+///        Files are parsed concurrently and merged in lexical filename order: keys (and non-empty section
+///        comments) of later files override those of earlier files.
+/// @param inif Output, unchanged if the loading fails
+/// @param dir Directory path
+/// @param pattern File name pattern, `*` and `?` wildcards
+/// @param report Optional per-file statistics
+/// @param threads Maximum number of threads parsing files concurrently (including the calling thread). Every file
+///        is parsed with the allocator of `inif`, so only `std::allocator` is shared between threads; with any other
+///        allocator (e.g. a pmr resource, which is usually not thread-safe) the files are parsed on the calling thread.
+/// @return Return false if the directory cannot be opened or a matching file cannot be read
+template <typename Hash, typename Equal, template <typename...> class Map, typename Allocator, typename CommentPolicy>
+bool load_directory(basic_inifile<Hash, Equal, Map, Allocator, CommentPolicy> &inif, const std::string &dir,
+                    const std::string &pattern = "*.ini", directory_load_report *report = nullptr,
+                    std::size_t threads = 4)
+{
+  using clock = std::chrono::steady_clock;
+  const clock::time_point start = clock::now();
+
+  std::vector<std::string> names;
+  if (!detail::list_directory(dir, pattern, names)) return false;
+  std::sort(names.begin(), names.end());
+
+  std::string prefix = dir;
+  if (!prefix.empty() && !detail::is_path_separator(prefix.back())) prefix += '/';
+  using inifile_type = basic_inifile<Hash, Equal, Map, Allocator, CommentPolicy>;
+  // 有状态的分配器(如 monotonic_buffer_resource)一般不是线程安全的, 所有文件共用 inif 的分配器时只能串行解析
+  if (!std::is_same<detail::char_allocator_t<Allocator>, std::allocator<char>>::value) threads = 1;
+  std::vector<inifile_type> parsed;
+  parsed.reserve(names.size());
+  // 逐个构造: 拷贝构造会经 select_on_container_copy_construction 换掉 pmr 分配器
+  for (std::size_t i = 0; i < names.size(); ++i) parsed.emplace_back(inif.get_allocator());
+  std::vector<file_load_stat> stats(names.size());
+  detail::parallel_for(names.size(), threads == 0 ? 1 : threads, [&](std::size_t i) {
+    file_load_stat &stat = stats[i];
+    stat.filename = prefix + names[i];
+    const clock::time_point begin = clock::now();
+    try
+    {
+      std::string text;
+      if (detail::read_file(stat.filename, text))
+      {
+        stat.bytes = text.size();
+        std::istringstream is(text);
+        parsed[i].read(is);
+        stat.ok = true;
+      }
+    }
+    catch (...)  // 工作线程中不能抛出异常, 按读取失败处理
+    {
+      stat.ok = false;
+    }
+    stat.parse_time = std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - begin);
+  });
+
+  bool ok = true;
+  for (const file_load_stat &stat : stats) ok = ok && stat.ok;
+  if (ok)
+  {
+    inifile_type merged(inif.get_allocator());
+    for (auto &file : parsed) detail::merge_into(merged, std::move(file));
+    inif = std::move(merged);
+  }
+  if (report)
+  {
+    report->files = std::move(stats);
+    report->total_time = std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - start);
+  }
+  return ok;
+}
+
+}  // namespace ini
+
+#endif  // INI_FILE_DIRECTORY_H_
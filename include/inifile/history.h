@@ -0,0 +1,709 @@
+/**************************************************************************************************************
+ *~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * @file: history.h
+ * @description: Persistent (immutable, structurally shared) ini documents and a versioned history.
+ * - `persistent_inifile` stores sections and keys in hash array mapped tries (HAMT). Every modification
+ *   returns a new document that shares all unchanged sections and fields with its predecessor,
+ *   so a new version costs O(changes * log n) memory instead of a full copy.
+ * - `config_history` keeps the last N committed versions for rollback and audit.
+ * - `ini::diff()` of two persistent documents skips shared subtrees by pointer equality.
+ *
+ * @license: MIT
+ * @repository: https://github.com/abin-z/inifile
+ *~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ **************************************************************************************************************/
+
+#ifndef INI_FILE_HISTORY_H_
+#define INI_FILE_HISTORY_H_
+
+#include <inifile/diff.h>
+#include <inifile/inifile.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ini
+{
+
+namespace detail
+{
+inline unsigned popcount32(std::uint32_t x) noexcept
+{
+  x = x - ((x >> 1) & 0x55555555u);
+  x = (x & 0x33333333u) + ((x >> 2) & 0x33333333u);
+  return (((x + (x >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24;
+}
+
+/// @brief 持久化哈希映射(HAMT): 每层使用哈希值的 5 位索引 32 路分支, 修改时只复制根到叶子的路径.
+///        叶子保存哈希值完全相同的条目, 因此哈希冲突不需要额外处理.
+template <typename Key, typename Value, typename Hash = std::hash<Key>, typename Equal = std::equal_to<Key>>
+class persistent_map
+{
+ public:
+  using value_type = std::pair<Key, Value>;
+
+  persistent_map() = default;
+
+  std::size_t size() const noexcept
+  {
+    return size_;
+  }
+
+  bool empty() const noexcept
+  {
+    return size_ == 0;
+  }
+
+  /// @brief 查找 key, 不存在时返回 nullptr
+  const Value *find(const Key &key) const
+  {
+    const std::size_t h = hash_(key);
+    const node *n = root_.get();
+    for (unsigned shift = 0; n != nullptr; shift += kBits)
+    {
+      const std::uint32_t bit = 1u << ((h >> shift) & kMask);
+      if ((n->bitmap & bit) == 0) return nullptr;
+      const slot &s = n->slots[index_of(n->bitmap, bit)];
+      if (s.item)
+      {
+        if (s.item->hash != h) return nullptr;
+        for (const auto &e : s.item->entries)
+        {
+          if (equal_(e.first, key)) return &e.second;
+        }
+        return nullptr;
+      }
+      n = s.child.get();
+    }
+    return nullptr;
+  }
+
+  /// @brief 返回插入或替换 key 之后的新映射, 原映射不变
+  persistent_map set(const Key &key, Value value) const
+  {
+    persistent_map result(*this);
+    bool added = false;
+    result.root_ = insert(root_.get(), 0, hash_(key), key, std::move(value), added);
+    if (added) ++result.size_;
+    return result;
+  }
+
+  /// @brief 返回删除 key 之后的新映射, key 不存在时返回的映射与原映射共享全部结构
+  persistent_map erase(const Key &key) const
+  {
+    if (!root_) return *this;
+    persistent_map result(*this);
+    bool removed = false;
+    result.root_ = remove(root_, 0, hash_(key), key, removed);
+    if (removed) --result.size_;
+    return result;
+  }
+
+  /// @brief 遍历所有条目, fn 的签名为 `void(const Key &, const Value &)`
+  template <typename Fn>
+  void for_each(Fn &&fn) const
+  {
+    if (root_) visit(*root_, fn);
+  }
+
+  /// @brief 两个映射是否共享同一个根(内容一定相同)
+  bool same_root(const persistent_map &other) const noexcept
+  {
+    return root_ == other.root_;
+  }
+
+  /// @brief 比较两个映射, 对每个不共享叶子的 key 调用 `fn(key, old_value, new_value)`,
+  ///        新增/删除的 key 对应的 old_value/new_value 为 nullptr. 共享的子树按指针相等直接跳过.
+  ///        两侧都存在的 key 也可能被报告(值可能相同), 由调用者比较.
+  template <typename Fn>
+  static void diff(const persistent_map &from, const persistent_map &to, Fn &&fn)
+  {
+    if (from.root_ == to.root_) return;
+    if (!from.root_)
+    {
+      to.for_each([&fn](const Key &k, const Value &v) { fn(k, nullptr, &v); });
+      return;
+    }
+    if (!to.root_)
+    {
+      from.for_each([&fn](const Key &k, const Value &v) { fn(k, &v, nullptr); });
+      return;
+    }
+    from.diff_nodes(*from.root_, *to.root_, fn);
+  }
+
+ private:
+  enum : unsigned
+  {
+    kBits = 5,
+    kMask = 31
+  };
+
+  struct leaf
+  {
+    std::size_t hash;
+    std::vector<value_type> entries;  // 哈希值完全相同的条目
+  };
+  struct node;
+  struct slot
+  {
+    std::shared_ptr<const node> child;  // 子节点, 或者
+    std::shared_ptr<const leaf> item;   // 叶子
+  };
+  struct node
+  {
+    std::uint32_t bitmap = 0;
+    std::vector<slot> slots;  // 按位图中的顺序紧凑存放
+  };
+
+  static std::size_t index_of(std::uint32_t bitmap, std::uint32_t bit) noexcept
+  {
+    return popcount32(bitmap & (bit - 1));
+  }
+
+  static std::shared_ptr<const leaf> make_leaf(std::size_t h, const Key &key, Value &&value)
+  {
+    auto l = std::make_shared<leaf>();
+    l->hash = h;
+    l->entries.emplace_back(key, std::move(value));
+    return l;
+  }
+
+  /// @brief 构造同时包含两个不同哈希值叶子的子树
+  static std::shared_ptr<const node> merge(std::shared_ptr<const leaf> a, std::shared_ptr<const leaf> b,
+                                           unsigned shift)
+  {
+    auto n = std::make_shared<node>();
+    const std::uint32_t ia = (a->hash >> shift) & kMask;
+    const std::uint32_t ib = (b->hash >> shift) & kMask;
+    if (ia == ib)
+    {
+      n->bitmap = 1u << ia;
+      n->slots.push_back({merge(std::move(a), std::move(b), shift + kBits), nullptr});
+    }
+    else
+    {
+      n->bitmap = (1u << ia) | (1u << ib);
+      if (ia > ib) std::swap(a, b);
+      n->slots.push_back({nullptr, std::move(a)});
+      n->slots.push_back({nullptr, std::move(b)});
+    }
+    return n;
+  }
+
+  std::shared_ptr<const node> insert(const node *n, unsigned shift, std::size_t h, const Key &key, Value &&value,
+                                     bool &added) const
+  {
+    auto result = n ? std::make_shared<node>(*n) : std::make_shared<node>();
+    const std::uint32_t bit = 1u << ((h >> shift) & kMask);
+    const std::size_t pos = index_of(result->bitmap, bit);
+    if ((result->bitmap & bit) == 0)
+    {
+      result->bitmap |= bit;
+      result->slots.insert(result->slots.begin() + static_cast<std::ptrdiff_t>(pos),
+                           slot{nullptr, make_leaf(h, key, std::move(value))});
+      added = true;
+      return result;
+    }
+    slot &s = result->slots[pos];
+    if (s.child)
+    {
+      s.child = insert(s.child.get(), shift + kBits, h, key, std::move(value), added);
+    }
+    else if (s.item->hash == h)
+    {
+      auto l = std::make_shared<leaf>(*s.item);
+      bool replaced = false;
+      for (auto &e : l->entries)
+      {
+        if (equal_(e.first, key))
+        {
+          e.second = std::move(value);
+          replaced = true;
+          break;
+        }
+      }
+      if (!replaced)
+      {
+        l->entries.emplace_back(key, std::move(value));
+        added = true;
+      }
+      s.item = std::move(l);
+    }
+    else
+    {
+      s.child = merge(std::move(s.item), make_leaf(h, key, std::move(value)), shift + kBits);
+      s.item = nullptr;
+      added = true;
+    }
+    return result;
+  }
+
+  std::shared_ptr<const node> remove(const std::shared_ptr<const node> &n, unsigned shift, std::size_t h,
+                                     const Key &key, bool &removed) const
+  {
+    const std::uint32_t bit = 1u << ((h >> shift) & kMask);
+    if ((n->bitmap & bit) == 0) return n;
+    const std::size_t pos = index_of(n->bitmap, bit);
+    const slot &s = n->slots[pos];
+
+    slot replacement;
+    if (s.child)
+    {
+      replacement.child = remove(s.child, shift + kBits, h, key, removed);
+      if (!removed) return n;
+      // 子节点只剩一个叶子时将其上提, 保持树的紧凑
+      if (replacement.child && replacement.child->slots.size() == 1 && replacement.child->slots[0].item)
+      {
+        replacement.item = replacement.child->slots[0].item;
+        replacement.child = nullptr;
+      }
+    }
+    else
+    {
+      if (s.item->hash != h) return n;
+      auto l = std::make_shared<leaf>(*s.item);
+      for (auto it = l->entries.begin(); it != l->entries.end(); ++it)
+      {
+        if (equal_(it->first, key))
+        {
+          l->entries.erase(it);
+          removed = true;
+          break;
+        }
+      }
+      if (!removed) return n;
+      if (!l->entries.empty()) replacement.item = std::move(l);
+    }
+
+    auto result = std::make_shared<node>(*n);
+    if (replacement.child || replacement.item)
+    {
+      result->slots[pos] = std::move(replacement);
+    }
+    else
+    {
+      result->bitmap &= ~bit;
+      result->slots.erase(result->slots.begin() + static_cast<std::ptrdiff_t>(pos));
+      if (result->slots.empty()) return nullptr;
+    }
+    return result;
+  }
+
+  template <typename Fn>
+  static void visit(const node &n, Fn &&fn)
+  {
+    for (const slot &s : n.slots) visit_slot(s, fn);
+  }
+
+  template <typename Fn>
+  static void visit_slot(const slot &s, Fn &&fn)
+  {
+    if (s.child)
+    {
+      visit(*s.child, fn);
+      return;
+    }
+    for (const auto &e : s.item->entries) fn(e.first, e.second);
+  }
+
+  template <typename Fn>
+  void diff_nodes(const node &from, const node &to, Fn &fn) const
+  {
+    for (unsigned i = 0; i <= kMask; ++i)
+    {
+      const std::uint32_t bit = 1u << i;
+      const bool in_from = (from.bitmap & bit) != 0;
+      const bool in_to = (to.bitmap & bit) != 0;
+      if (!in_from && !in_to) continue;
+      if (!in_to)
+      {
+        visit_slot(from.slots[index_of(from.bitmap, bit)], [&fn](const Key &k, const Value &v) { fn(k, &v, nullptr); });
+        continue;
+      }
+      if (!in_from)
+      {
+        visit_slot(to.slots[index_of(to.bitmap, bit)], [&fn](const Key &k, const Value &v) { fn(k, nullptr, &v); });
+        continue;
+      }
+      const slot &a = from.slots[index_of(from.bitmap, bit)];
+      const slot &b = to.slots[index_of(to.bitmap, bit)];
+      if ((a.child && a.child == b.child) || (a.item && a.item == b.item)) continue;  // 共享的子树
+      if (a.child && b.child)
+      {
+        diff_nodes(*a.child, *b.child, fn);
+        continue;
+      }
+      // 至少一侧是叶子: 收集两侧的条目逐个比较(叶子只包含极少的条目)
+      std::vector<const value_type *> lhs, rhs;
+      collect(a, lhs);
+      collect(b, rhs);
+      std::vector<bool> matched(rhs.size(), false);
+      for (const value_type *l : lhs)
+      {
+        std::size_t j = 0;
+        while (j < rhs.size() && !equal_(l->first, rhs[j]->first)) ++j;
+        if (j == rhs.size())
+        {
+          fn(l->first, &l->second, nullptr);
+          continue;
+        }
+        matched[j] = true;
+        if (l != rhs[j]) fn(l->first, &l->second, &rhs[j]->second);
+      }
+      for (std::size_t j = 0; j < rhs.size(); ++j)
+      {
+        if (!matched[j]) fn(rhs[j]->first, nullptr, &rhs[j]->second);
+      }
+    }
+  }
+
+  static void collect(const slot &s, std::vector<const value_type *> &out)
+  {
+    if (s.child)
+    {
+      for (const slot &c : s.child->slots) collect(c, out);
+      return;
+    }
+    for (const auto &e : s.item->entries) out.push_back(&e);
+  }
+
+ private:
+  std::shared_ptr<const node> root_;
+  std::size_t size_ = 0;
+  Hash hash_;
+  Equal equal_;
+};
+}  // namespace detail
+
+/// @brief Immutable ini document with structural sharing. All modifiers return a new document.
+template <typename Hash = std::hash<std::string>, typename Equal = std::equal_to<std::string>>
+class basic_persistent_inifile
+{
+ public:
+  using fields_type = detail::persistent_map<std::string, field, Hash, Equal>;
+
+  /// @brief An immutable section: key-value pairs and the section comment.
+  struct section_type
+  {
+    fields_type fields;
+    std::shared_ptr<const ini::comment> comments;  // nullptr 表示没有注释
+
+    const ini::comment &comment() const
+    {
+      static const ini::comment empty;
+      return comments ? *comments : empty;
+    }
+  };
+  using sections_type = detail::persistent_map<std::string, section_type, Hash, Equal>;
+
+  basic_persistent_inifile() = default;
+
+  /// @brief Build a persistent document from a `basic_inifile`.
+  template <template <typename...> class Map, typename Allocator>
+  explicit basic_persistent_inifile(const basic_inifile<Hash, Equal, Map, Allocator> &content)
+  {
+    *this = basic_persistent_inifile().assign(content);
+  }
+
+  /// @brief Materialize the document as a mutable `basic_inifile`.
+  template <template <typename...> class Map = std::unordered_map, typename Allocator = std::allocator<char>>
+  basic_inifile<Hash, Equal, Map, Allocator> to_inifile(const Allocator &alloc = Allocator()) const
+  {
+    basic_inifile<Hash, Equal, Map, Allocator> result(alloc);
+    sections_.for_each([&result](const std::string &name, const section_type &sec) {
+      auto &target = result[name];
+      if (sec.comments) target.set_comment(*sec.comments);
+      sec.fields.for_each([&target](const std::string &key, const field &value) { target[key] = value; });
+    });
+    return result;
+  }
+
+  /// @brief Return a document with the content of `content`, sharing every unchanged section and field with `*this`.
+  template <template <typename...> class Map, typename Allocator>
+  basic_persistent_inifile assign(const basic_inifile<Hash, Equal, Map, Allocator> &content) const
+  {
+    basic_persistent_inifile result(*this);
+    // 删除不再存在的 section
+    sections_.for_each([&result, &content](const std::string &name, const section_type &) {
+      if (content.find(name) == content.end()) result.sections_ = result.sections_.erase(name);
+    });
+    for (const auto &sec : content)
+    {
+      const std::string &name = detail::to_std_string(sec.first);  // 其他分配器的 section 名转换为 std::string
+      const section_type *old = sections_.find(name);
+      section_type next = old ? *old : section_type();
+      bool changed = old == nullptr;
+      if (next.comment() != sec.second.comment())
+      {
+        next.comments = sec.second.comment().empty() ? nullptr : std::make_shared<ini::comment>(sec.second.comment());
+        changed = true;
+      }
+      if (old)
+      {
+        old->fields.for_each([&next, &changed, &sec](const std::string &key, const field &) {
+          if (sec.second.find(key) == sec.second.end())
+          {
+            next.fields = next.fields.erase(key);
+            changed = true;
+          }
+        });
+      }
+      for (const auto &kv : sec.second)
+      {
+        const std::string &key = detail::to_std_string(kv.first);
+        const field *f = next.fields.find(key);
+        if (f && f->str() == detail::to_std_string(kv.second.str()) && f->comment() == kv.second.comment())
+          continue;  // 未变化, 继续共享
+        next.fields = next.fields.set(key, field(kv.second));
+        changed = true;
+      }
+      if (changed) result.sections_ = result.sections_.set(name, std::move(next));
+    }
+    return result;
+  }
+
+  /// @brief Return a document with `[sec] key = value` set.
+  template <typename T>
+  basic_persistent_inifile set(std::string sec, std::string key, T &&value) const
+  {
+    detail::trim(sec);
+    detail::trim(key);
+    const section_type *old = sections_.find(sec);
+    section_type next = old ? *old : section_type();
+    const field *f = next.fields.find(key);
+    field value_field = f ? *f : field();  // 与 basic_inifile::set 的赋值语义一致(保留原有注释)
+    value_field = std::forward<T>(value);
+    next.fields = next.fields.set(key, std::move(value_field));
+    basic_persistent_inifile result(*this);
+    result.sections_ = sections_.set(sec, std::move(next));
+    return result;
+  }
+
+  /// @brief Return a document with the key removed (shares everything if it does not exist).
+  basic_persistent_inifile remove(std::string sec, std::string key) const
+  {
+    detail::trim(sec);
+    detail::trim(key);
+    const section_type *old = sections_.find(sec);
+    if (!old || !old->fields.find(key)) return *this;
+    section_type next = *old;
+    next.fields = next.fields.erase(key);
+    basic_persistent_inifile result(*this);
+    result.sections_ = sections_.set(sec, std::move(next));
+    return result;
+  }
+
+  /// @brief Return a document with the section removed.
+  basic_persistent_inifile remove(std::string sec) const
+  {
+    detail::trim(sec);
+    basic_persistent_inifile result(*this);
+    result.sections_ = sections_.erase(sec);
+    return result;
+  }
+
+  bool contains(std::string sec) const
+  {
+    detail::trim(sec);
+    return sections_.find(sec) != nullptr;
+  }
+
+  bool contains(std::string sec, std::string key) const
+  {
+    detail::trim(sec);
+    detail::trim(key);
+    const section_type *s = sections_.find(sec);
+    return s && s->fields.find(key);
+  }
+
+  /// @brief Returns a copy of the field value, or `default_value` if the section or key does not exist.
+  field get(std::string sec, std::string key, field default_value = field{}) const
+  {
+    detail::trim(sec);
+    detail::trim(key);
+    const section_type *s = sections_.find(sec);
+    if (!s) return default_value;
+    const field *f = s->fields.find(key);
+    return f ? *f : default_value;
+  }
+
+  /// @brief Find a section, returns nullptr if it does not exist.
+  const section_type *find(std::string sec) const
+  {
+    detail::trim(sec);
+    return sections_.find(sec);
+  }
+
+  /// @brief Number of sections.
+  std::size_t size() const noexcept
+  {
+    return sections_.size();
+  }
+
+  bool empty() const noexcept
+  {
+    return sections_.empty();
+  }
+
+  const sections_type &sections() const noexcept
+  {
+    return sections_;
+  }
+
+ private:
+  sections_type sections_;
+};
+
+/// @brief Compute the difference of two persistent documents, skipping shared sections and fields.
+template <typename Hash, typename Equal>
+diff_result diff(const basic_persistent_inifile<Hash, Equal> &from, const basic_persistent_inifile<Hash, Equal> &to)
+{
+  using doc = basic_persistent_inifile<Hash, Equal>;
+  using section_type = typename doc::section_type;
+  using fields_type = typename doc::fields_type;
+
+  diff_result result;
+  doc::sections_type::diff(
+    from.sections(), to.sections(),
+    [&result](const std::string &name, const section_type *old_sec, const section_type *new_sec) {
+      static const fields_type no_fields;
+      bool changed = !old_sec || !new_sec || old_sec->comment() != new_sec->comment();
+      fields_type::diff(old_sec ? old_sec->fields : no_fields, new_sec ? new_sec->fields : no_fields,
+                        [&](const std::string &key, const field *old_value, const field *new_value) {
+                          if (!old_value)
+                          {
+                            result.keys.push_back({name, key, change_kind::added, std::string(), new_value->str()});
+                          }
+                          else if (!new_value)
+                          {
+                            result.keys.push_back({name, key, change_kind::removed, old_value->str(), std::string()});
+                          }
+                          else if (old_value->str() != new_value->str() ||
+                                   old_value->comment() != new_value->comment())
+                          {
+                            result.keys.push_back(
+                              {name, key, change_kind::modified, old_value->str(), new_value->str()});
+                          }
+                          else
+                          {
+                            return;
+                          }
+                          changed = true;
+                        });
+      if (changed)
+      {
+        result.sections.push_back(
+          {name, !old_sec ? change_kind::added : (!new_sec ? change_kind::removed : change_kind::modified)});
+      }
+    });
+  return result;
+}
+
+/// @brief Bounded history of committed persistent versions for rollback and audit
+template <typename Hash = std::hash<std::string>, typename Equal = std::equal_to<std::string>>
+class basic_config_history
+{
+ public:
+  using document_type = basic_persistent_inifile<Hash, Equal>;
+
+  /// @brief A committed version.
+  struct version
+  {
+    std::uint64_t id;
+    document_type document;
+  };
+
+  /// @param max_versions Number of versions kept (the oldest are dropped first), 0 keeps every version
+  explicit basic_config_history(std::size_t max_versions = 0) : max_versions_(max_versions) {}
+
+  /// @brief Commit a new version.
+  /// @return Id of the new version
+  std::uint64_t commit(document_type document)
+  {
+    versions_.push_back({++last_id_, std::move(document)});
+    if (max_versions_ != 0 && versions_.size() > max_versions_) versions_.pop_front();
+    return last_id_;
+  }
+
+  /// @brief Commit the content of a `basic_inifile`, sharing everything unchanged since the head version.
+  template <template <typename...> class Map, typename Allocator>
+  std::uint64_t commit(const basic_inifile<Hash, Equal, Map, Allocator> &content)
+  {
+    return commit(head().assign(content));
+  }
+
+  /// @brief Commit an old version again as the new head.
+  /// @return Id of the new version
+  /// @throws `std::out_of_range` if the version is no longer kept
+  std::uint64_t rollback(std::uint64_t id)
+  {
+    return commit(at(id));
+  }
+
+  /// @brief The latest version (empty document if nothing was committed).
+  const document_type &head() const
+  {
+    static const document_type empty;
+    return versions_.empty() ? empty : versions_.back().document;
+  }
+
+  /// @brief Id of the latest version, 0 if nothing was committed.
+  std::uint64_t head_id() const noexcept
+  {
+    return versions_.empty() ? 0 : versions_.back().id;
+  }
+
+  /// @brief Get a kept version.
+  /// @throws `std::out_of_range` if the version is no longer kept
+  const document_type &at(std::uint64_t id) const
+  {
+    if (versions_.empty() || id < versions_.front().id || id > versions_.back().id)
+    {
+      throw std::out_of_range("ini::config_history: version " + std::to_string(id) + " is not kept");
+    }
+    return versions_[static_cast<std::size_t>(id - versions_.front().id)].document;
+  }
+
+  bool contains(std::uint64_t id) const noexcept
+  {
+    return !versions_.empty() && id >= versions_.front().id && id <= versions_.back().id;
+  }
+
+  /// @brief Kept versions, oldest first.
+  const std::deque<version> &versions() const noexcept
+  {
+    return versions_;
+  }
+
+  std::size_t size() const noexcept
+  {
+    return versions_.size();
+  }
+
+ private:
+  std::deque<version> versions_;
+  std::size_t max_versions_;
+  std::uint64_t last_id_ = 0;
+};
+
+/// @brief persistent_inifile class
+using persistent_inifile = basic_persistent_inifile<>;
+/// @brief case_insensitive_persistent_inifile class
+using case_insensitive_persistent_inifile =
+  basic_persistent_inifile<detail::case_insensitive_hash, detail::case_insensitive_equal>;
+/// @brief config_history class
+using config_history = basic_config_history<>;
+/// @brief case_insensitive_config_history class
+using case_insensitive_config_history =
+  basic_config_history<detail::case_insensitive_hash, detail::case_insensitive_equal>;
+
+}  // namespace ini
+
+#endif  // INI_FILE_HISTORY_H_
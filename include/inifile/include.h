@@ -0,0 +1,339 @@
+/**************************************************************************************************************
+ *~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * @file: include.h
+ * @description: Loading ini files split into fragments with `include=` directives.
+ * - A line `include=path` (in any section) includes another ini file, relative paths are resolved against the
+ *   directory of the including file. Included files are merged in the order of their directives, then the
+ *   including file itself is merged on top, so its own keys win. Includes may be nested, cycles are an error.
+ * - `include_loader` parses the files of each include level concurrently on a small thread pool. Every file is
+ *   parsed at most once per load even if it is included several times, and parsed files are cached by path,
+ *   size and mtime, so unchanged fragments are not parsed again by the next load.
+ *
+ * @license: MIT
+ * @repository: https://github.com/abin-z/inifile
+ *~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ **************************************************************************************************************/
+
+#ifndef INI_FILE_INCLUDE_H_
+#define INI_FILE_INCLUDE_H_
+
+#include <inifile/inifile.h>
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace ini
+{
+
+namespace detail
+{
+/// @brief 在最多 threads 个线程上执行 fn(0) ... fn(count - 1), 调用线程也参与执行. fn 不能抛出异常
+template <typename Fn>
+void parallel_for(std::size_t count, std::size_t threads, Fn &&fn)
+{
+  if (threads > count) threads = count;
+  if (threads <= 1)
+  {
+    for (std::size_t i = 0; i < count; ++i) fn(i);
+    return;
+  }
+  std::atomic<std::size_t> next{0};
+  auto worker = [&next, count, &fn]() {
+    for (std::size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1)) fn(i);
+  };
+  std::vector<std::thread> pool;
+  pool.reserve(threads - 1);
+  for (std::size_t t = 1; t < threads; ++t) pool.emplace_back(worker);
+  worker();
+  for (std::thread &th : pool) th.join();
+}
+
+inline bool is_path_separator(char c) noexcept
+{
+  return c == '/' || c == '\\';
+}
+
+inline bool is_absolute_path(const std::string &path) noexcept
+{
+  if (!path.empty() && is_path_separator(path[0])) return true;
+  return path.size() >= 2 && path[1] == ':' && std::isalpha(static_cast<unsigned char>(path[0]));  // "C:"
+}
+
+/// @brief 按字面规范化路径: 合并重复的分隔符, 去掉 "." 并折叠 "name/..", 用于识别同一个文件
+inline std::string normalize_path(const std::string &path)
+{
+  std::string prefix;
+  std::size_t pos = 0;
+  if (path.size() >= 2 && path[1] == ':')
+  {
+    prefix = path.substr(0, 2);
+    pos = 2;
+  }
+  const bool absolute = pos < path.size() && is_path_separator(path[pos]);
+  std::vector<std::string> parts;
+  while (pos < path.size())
+  {
+    std::size_t end = pos;
+    while (end < path.size() && !is_path_separator(path[end])) ++end;
+    std::string part = path.substr(pos, end - pos);
+    pos = end + 1;
+    if (part.empty() || part == ".") continue;
+    if (part == ".." && !parts.empty() && parts.back() != "..")
+    {
+      parts.pop_back();
+      continue;
+    }
+    if (part == ".." && absolute) continue;  // 根目录的上级仍是根目录
+    parts.push_back(std::move(part));
+  }
+  std::string result = prefix;
+  if (absolute) result += '/';
+  for (std::size_t i = 0; i < parts.size(); ++i)
+  {
+    if (i != 0) result += '/';
+    result += parts[i];
+  }
+  if (result.empty()) result = ".";
+  return result;
+}
+
+/// @brief 文件所在目录(带结尾分隔符), 没有目录部分时返回空字符串
+inline std::string parent_directory(const std::string &path)
+{
+  std::size_t pos = path.size();
+  while (pos > 0 && !is_path_separator(path[pos - 1])) --pos;
+  return path.substr(0, pos);
+}
+
+/// @brief 将 src 合并到 dst, src 中的 key 和非空的 section 注释覆盖 dst 中的同名项.
+///        dst 中不存在的 section 直接共享 src 的存储(写时复制), 不复制键值对
+template <typename Inifile>
+void merge_into(Inifile &dst, const Inifile &src)
+{
+  for (const auto &sec : src)
+  {
+    if (!dst.contains(sec.first))
+    {
+      dst[sec.first] = sec.second;
+      continue;
+    }
+    auto &target = dst[sec.first];
+    if (!sec.second.comment().empty()) target.set_comment(sec.second.comment());
+    for (const auto &kv : sec.second) target.set(kv.first, kv.second);
+  }
+}
+
+/// @brief 同上, 但 src 的 section 和键值对被移动而不是复制
+template <typename Inifile>
+void merge_into(Inifile &dst, Inifile &&src)
+{
+  if (dst.empty())
+  {
+    dst = std::move(src);
+    return;
+  }
+  for (auto &sec : src)
+  {
+    if (!dst.contains(sec.first))
+    {
+      dst[sec.first] = std::move(sec.second);
+      continue;
+    }
+    auto &target = dst[sec.first];
+    const auto &source = sec.second;  // 只读访问注释, no_comments 策略下没有可写的注释
+    if (!source.comment().empty()) target.set_comment(source.comment());
+    for (auto &kv : sec.second) target.set(kv.first, std::move(kv.second));
+  }
+}
+}  // namespace detail
+
+/// @brief Loads an ini file and the files it includes (see `include=`), caching parsed files between loads
+template <typename Hash = std::hash<std::string>, typename Equal = std::equal_to<std::string>,
+          template <typename...> class Map = std::unordered_map>
+class basic_include_loader
+{
+ public:
+  using inifile_type = basic_inifile<Hash, Equal, Map>;
+
+  /// @param threads Maximum number of threads parsing files concurrently (including the calling thread)
+  explicit basic_include_loader(std::size_t threads = 4) : threads_(threads == 0 ? 1 : threads) {}
+
+  /// @brief Load `filename` and everything it includes into `out`. Not thread-safe, one load at a time.
+  /// @return Return false if a file cannot be read or the includes form a cycle, `out` is unchanged then
+  bool load(const std::string &filename, inifile_type &out)
+  {
+    parsed_ = 0;
+    const std::string root = detail::normalize_path(filename);
+    std::unordered_map<std::string, std::shared_ptr<const parsed_file>> files;  // 本次加载用到的文件
+    std::vector<std::string> frontier{root};
+    while (!frontier.empty())
+    {
+      // 同一层级中所有未缓存(或已变化)的文件并发解析
+      std::vector<std::shared_ptr<const parsed_file>> results(frontier.size());
+      std::vector<detail::file_stamp> stamps(frontier.size());
+      std::vector<std::size_t> pending;
+      for (std::size_t i = 0; i < frontier.size(); ++i)
+      {
+        stamps[i] = detail::stat_file(frontier[i]);
+        if (!stamps[i].exists) return false;
+        auto cached = cache_.find(frontier[i]);
+        if (cached != cache_.end() && cached->second->stamp == stamps[i])
+        {
+          results[i] = cached->second;
+        }
+        else
+        {
+          pending.push_back(i);
+        }
+      }
+      detail::parallel_for(pending.size(), threads_, [&](std::size_t j) {
+        const std::size_t i = pending[j];
+        results[i] = parse(frontier[i], stamps[i]);
+      });
+
+      for (std::size_t i = 0; i < frontier.size(); ++i)
+      {
+        if (!results[i]) return false;
+        cache_[frontier[i]] = results[i];
+        files.emplace(frontier[i], results[i]);
+      }
+      std::vector<std::string> next;  // 下一层中尚未加载的文件, 保持出现顺序
+      std::unordered_set<std::string> queued;
+      for (const auto &result : results)
+      {
+        for (const std::string &inc : result->includes)
+        {
+          if (files.count(inc) == 0 && queued.insert(inc).second) next.push_back(inc);
+        }
+      }
+      parsed_ += pending.size();
+      frontier.swap(next);
+    }
+
+    inifile_type merged;
+    std::vector<std::string> stack;
+    if (!compose(root, files, merged, stack)) return false;
+    out = std::move(merged);
+    return true;
+  }
+
+  /// @brief Number of files actually parsed (not taken from the cache) by the last `load()`.
+  std::size_t parsed_count() const noexcept
+  {
+    return parsed_;
+  }
+
+  /// @brief Number of cached parsed files.
+  std::size_t cache_size() const noexcept
+  {
+    return cache_.size();
+  }
+
+  void clear_cache() noexcept
+  {
+    cache_.clear();
+  }
+
+ private:
+  struct parsed_file
+  {
+    detail::file_stamp stamp;
+    inifile_type content;               // 不含 include 指令
+    std::vector<std::string> includes;  // 规范化后的路径, 按出现顺序
+  };
+
+  static bool contains(const std::vector<std::string> &paths, const std::string &path)
+  {
+    for (const std::string &p : paths)
+    {
+      if (p == path) return true;
+    }
+    return false;
+  }
+
+  /// @brief 读取并解析一个文件, 提取 include 指令. 失败时返回 nullptr (在工作线程中执行, 不抛出异常)
+  static std::shared_ptr<const parsed_file> parse(const std::string &path, const detail::file_stamp &stamp) noexcept
+  {
+    try
+    {
+      std::string text;
+      if (!detail::read_file(path, text)) return nullptr;
+      auto result = std::make_shared<parsed_file>();
+      result->stamp = stamp;
+      const std::string dir = detail::parent_directory(path);
+      std::string body;
+      body.reserve(text.size());
+      std::istringstream lines(text);
+      std::string line;
+      while (std::getline(lines, line))
+      {
+        std::string trimmed = line;
+        detail::trim(trimmed);
+        const std::size_t eq = trimmed.find('=');
+        if (eq != std::string::npos && trimmed[0] != ';' && trimmed[0] != '#')
+        {
+          std::string key = trimmed.substr(0, eq);
+          detail::trim(key);
+          if (key == "include")
+          {
+            std::string target = trimmed.substr(eq + 1);
+            detail::trim(target);
+            if (!target.empty())
+            {
+              result->includes.push_back(
+                detail::normalize_path(detail::is_absolute_path(target) ? target : dir + target));
+            }
+            continue;
+          }
+        }
+        body.append(line).push_back('\n');
+      }
+      result->content.from_string(body);
+      return result;
+    }
+    catch (...)
+    {
+      return nullptr;
+    }
+  }
+
+  /// @brief 按 include 顺序合并: 先合并被包含的文件, 再合并文件本身
+  static bool compose(const std::string &path,
+                      const std::unordered_map<std::string, std::shared_ptr<const parsed_file>> &files,
+                      inifile_type &out, std::vector<std::string> &stack)
+  {
+    if (contains(stack, path)) return false;  // 循环包含
+    const parsed_file &file = *files.at(path);
+    stack.push_back(path);
+    for (const std::string &inc : file.includes)
+    {
+      if (!compose(inc, files, out, stack)) return false;
+    }
+    stack.pop_back();
+    detail::merge_into(out, file.content);
+    return true;
+  }
+
+ private:
+  std::size_t threads_;
+  std::size_t parsed_ = 0;
+  std::unordered_map<std::string, std::shared_ptr<const parsed_file>> cache_;  // key: 规范化路径
+};
+
+/// @brief include_loader class
+using include_loader = basic_include_loader<>;
+/// @brief case_insensitive_include_loader class
+using case_insensitive_include_loader =
+  basic_include_loader<detail::case_insensitive_hash, detail::case_insensitive_equal>;
+
+}  // namespace ini
+
+#endif  // INI_FILE_INCLUDE_H_
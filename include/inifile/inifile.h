@@ -28,32 +28,58 @@
 #define INI_FILE_H_
 
 #include <algorithm>
+#include <atomic>
 #include <cctype>
 #include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
 #include <cstdlib>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <iterator>
 #include <limits>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <sstream>
 #include <stdexcept>
 #include <string>
 #include <type_traits>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
+#include <sys/stat.h>
+
 #ifdef __cpp_lib_string_view  // If we have std::string_view
 #include <string_view>
 #endif
 
+// C++17: std::pmr polymorphic allocators, see the `ini::pmr` aliases
+#if (__cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)) && defined(__has_include)
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+#endif
+#endif
+
 // Provides custom type converters, users can customize type conversion
 #ifndef INIFILE_TYPE_CONVERTER
 #define INIFILE_TYPE_CONVERTER ini::detail::convert
 #endif
 
+// Define to 1 to collect parse/serialize statistics (see `ini::stats`), compiled out by default
+#ifndef INIFILE_ENABLE_STATS
+#define INIFILE_ENABLE_STATS 0
+#endif
+
+// Define to 1 to count per-key lookup hits/misses (see `ini::access_report`), compiled out by default
+#ifndef INIFILE_ENABLE_ACCESS_COUNTERS
+#define INIFILE_ENABLE_ACCESS_COUNTERS 0
+#endif
+
 namespace ini
 {
 
@@ -64,7 +90,8 @@ static constexpr char whitespaces[] = " \t\n\r\f\v";
 
 /// @brief 除去str两端空白字符
 /// @param str
-inline void trim(std::string &str)
+template <typename Traits, typename Alloc>
+void trim(std::basic_string<char, Traits, Alloc> &str)
 {
   auto lastpos = str.find_last_not_of(whitespaces);
   if (lastpos == std::string::npos)
@@ -76,6 +103,117 @@ inline void trim(std::string &str)
   str.erase(0, str.find_first_not_of(whitespaces));
 }
 
+/// @brief 判断字符是否是空白字符
+inline bool is_whitespace(char c) noexcept
+{
+  return std::char_traits<char>::find(whitespaces, sizeof(whitespaces) - 1, c) != nullptr;
+}
+
+/// @brief 返回去除两端空白字符后的字符串, 两端没有空白时直接返回 str 本身, 不复制也不分配内存
+/// @param str 输入的字符串
+/// @param buffer 需要去除空白时存放结果
+/// @return str 或 buffer 的引用
+template <typename Traits, typename Alloc>
+const std::basic_string<char, Traits, Alloc> &trimmed(const std::basic_string<char, Traits, Alloc> &str,
+                                                      std::basic_string<char, Traits, Alloc> &buffer)
+{
+  if (str.empty() || (!is_whitespace(str.front()) && !is_whitespace(str.back()))) return str;
+  buffer = str;
+  trim(buffer);
+  return buffer;
+}
+
+/// @brief 字符串参数的字符序列, 用于在分配器不同的字符串类型之间转换
+struct char_range
+{
+  const char *data;
+  std::size_t size;
+};
+inline char_range chars_of(const char *str) noexcept
+{
+  return {str, std::char_traits<char>::length(str)};
+}
+template <typename Traits, typename Alloc>
+char_range chars_of(const std::basic_string<char, Traits, Alloc> &str) noexcept
+{
+  return {str.data(), str.size()};
+}
+#ifdef __cpp_lib_string_view
+inline char_range chars_of(std::string_view str) noexcept
+{
+  return {str.data(), str.size()};
+}
+#endif
+
+/// @brief 是否为可以作为 section 名/key 的字符串参数(C 字符串, 任意分配器的 std::basic_string, string_view)
+template <typename T, typename = void>
+struct is_string_like : std::false_type
+{
+};
+template <typename T>
+struct is_string_like<T, decltype((void)chars_of(std::declval<const T &>()))> : std::true_type
+{
+};
+
+/// @brief 容器的 key 类型不是 std::string 时(分配器不同), 为其他字符串类型的参数启用兼容重载;
+///        key 类型就是 std::string 时不启用, 原有的 std::string 接口保持不变
+template <typename Key, typename String>
+using enable_if_foreign_string_t =
+  typename std::enable_if<!std::is_same<String, std::string>::value &&
+                          !std::is_same<typename std::decay<Key>::type, String>::value &&
+                          is_string_like<typename std::decay<Key>::type>::value>::type;
+
+/// @brief 同 enable_if_foreign_string_t, 用于 section 名和 key 两个参数, 其中至少一个是其他字符串类型
+template <typename Sec, typename Key, typename String>
+using enable_if_foreign_strings_t = typename std::enable_if<
+  !std::is_same<String, std::string>::value && is_string_like<typename std::decay<Sec>::type>::value &&
+  is_string_like<typename std::decay<Key>::type>::value &&
+  !(std::is_same<typename std::decay<Sec>::type, String>::value &&
+    std::is_same<typename std::decay<Key>::type, String>::value)>::type;
+
+/// @brief 将其他类型的字符串参数转换为 String 并去除两端空白, 结果存放在 buffer 中
+/// @return buffer 的引用
+template <typename Key, typename String,
+          typename = typename std::enable_if<!std::is_same<Key, String>::value && is_string_like<Key>::value>::type>
+const String &trimmed(const Key &key, String &buffer)
+{
+  const char_range r = chars_of(key);
+  std::size_t first = 0, last = r.size;
+  while (first < last && is_whitespace(r.data[first])) ++first;
+  while (last > first && is_whitespace(r.data[last - 1])) --last;
+  buffer.assign(r.data + first, last - first);
+  return buffer;
+}
+
+/// @brief 转换为 std::string, 用于报告、差异等对外返回 std::string 的接口; 参数本身是 std::string 时不复制
+inline const std::string &to_std_string(const std::string &str) noexcept
+{
+  return str;
+}
+template <typename Traits, typename Alloc>
+std::string to_std_string(const std::basic_string<char, Traits, Alloc> &str)
+{
+  return std::string(str.data(), str.size());
+}
+
+/// @brief 由 std::string 构造使用 alloc 的 String, String 就是 std::string 时直接移动
+template <typename String>
+String make_string(std::string &&str, const typename String::allocator_type &alloc)
+{
+  return String(str.data(), str.size(), alloc);
+}
+template <>
+inline std::string make_string<std::string>(std::string &&str, const std::allocator<char> &)
+{
+  return std::move(str);
+}
+
+/// @brief 分配器 rebind 到 char 后对应的字符串类型, 默认分配器下就是 std::string
+template <typename Allocator>
+using char_allocator_t = typename std::allocator_traits<Allocator>::template rebind_alloc<char>;
+template <typename Allocator>
+using string_t = std::basic_string<char, std::char_traits<char>, char_allocator_t<Allocator>>;
+
 /// @brief 判断字符串是否全是空白字符
 /// @param str 输入的字符串
 /// @return 如果字符串全是空白字符，则返回true，否则返回false
@@ -230,6 +368,264 @@ inline void remove_trailing_cr(std::string &line)
   }
 }
 
+/// @brief FNV-1a 64位哈希, 结果与平台和标准库实现无关, 用于计算内容指纹
+/// @param data 数据首地址
+/// @param size 数据长度
+/// @param h 初始哈希值(可用于链式哈希)
+/// @return 哈希值
+inline std::uint64_t fnv1a_64(const char *data, std::size_t size, std::uint64_t h = 14695981039346656037ULL) noexcept
+{
+  for (std::size_t i = 0; i < size; ++i)
+  {
+    h ^= static_cast<unsigned char>(data[i]);
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+
+/// @brief 64位哈希值混淆(splitmix64 finalizer), 使加法组合的结果分布均匀
+inline std::uint64_t mix64(std::uint64_t h) noexcept
+{
+  h ^= h >> 30;
+  h *= 0xbf58476d1ce4e5b9ULL;
+  h ^= h >> 27;
+  h *= 0x94d049bb133111ebULL;
+  h ^= h >> 31;
+  return h;
+}
+
+/// @brief 将字符串(长度+内容)追加到哈希值中, 带长度可以避免 "ab"+"c" 与 "a"+"bc" 冲突
+template <typename Traits, typename Alloc>
+std::uint64_t hash_append(std::uint64_t h, const std::basic_string<char, Traits, Alloc> &str) noexcept
+{
+  h = mix64(h ^ static_cast<std::uint64_t>(str.size()));
+  return fnv1a_64(str.data(), str.size(), h);
+}
+
+/// @brief 以小端字节序追加无符号整数, 二进制格式与平台字节序无关
+template <typename T>
+inline void put_le(std::string &out, T value)
+{
+  for (std::size_t i = 0; i < sizeof(T); ++i)
+  {
+    out += static_cast<char>(value & 0xFF);
+    value = static_cast<T>(value >> 8);
+  }
+}
+
+/// @brief 读取小端字节序的无符号整数
+template <typename T>
+inline T get_le(const char *data) noexcept
+{
+  T value = 0;
+  for (std::size_t i = sizeof(T); i-- > 0;)
+  {
+    value = static_cast<T>((value << 8) | static_cast<unsigned char>(data[i]));
+  }
+  return value;
+}
+
+/// @brief 以二进制方式一次性读取整个文件
+/// @return 文件不存在或读取失败时返回 false
+inline bool read_file(const std::string &filename, std::string &out)
+{
+  std::ifstream is(filename, std::ios::binary | std::ios::ate);
+  if (!is) return false;
+  const std::streamoff size = is.tellg();
+  if (size < 0) return false;
+  out.resize(static_cast<std::size_t>(size));
+  is.seekg(0, std::ios::beg);
+  if (size > 0) is.read(&out[0], static_cast<std::streamsize>(size));
+  return !is.fail();
+}
+
+/// @brief 以二进制方式写入整个文件
+inline bool write_file(const std::string &filename, const std::string &bytes)
+{
+  std::ofstream os(filename, std::ios::binary | std::ios::trunc);
+  if (!os) return false;
+  os.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+  os.flush();
+  return !os.fail() && !os.bad();
+}
+
+/// @brief 用已写好的临时文件替换目标文件. POSIX 上 rename 原子地覆盖目标;
+///        Windows 上 rename 不会覆盖已存在的文件, 只能先删除目标再重命名
+inline bool replace_file(const std::string &from, const std::string &to)
+{
+  if (std::rename(from.c_str(), to.c_str()) == 0) return true;
+  std::remove(to.c_str());
+  return std::rename(from.c_str(), to.c_str()) == 0;
+}
+
+/// @brief 文件状态戳, 用于判断文件是否发生变化
+struct file_stamp
+{
+  bool exists = false;
+  std::uint64_t size = 0;
+  std::int64_t mtime_ns = 0;
+  std::uint64_t inode = 0;
+
+  bool operator==(const file_stamp &rhs) const noexcept
+  {
+    return exists == rhs.exists && size == rhs.size && mtime_ns == rhs.mtime_ns && inode == rhs.inode;
+  }
+  bool operator!=(const file_stamp &rhs) const noexcept
+  {
+    return !(*this == rhs);
+  }
+};
+
+inline file_stamp stat_file(const std::string &filename)
+{
+  file_stamp stamp;
+#if defined(_WIN32)
+  struct _stat64 st;
+  if (_stat64(filename.c_str(), &st) != 0) return stamp;
+  stamp.mtime_ns = static_cast<std::int64_t>(st.st_mtime) * 1000000000;
+#else
+  struct stat st;
+  if (::stat(filename.c_str(), &st) != 0) return stamp;
+#if defined(__linux__)
+  stamp.mtime_ns = static_cast<std::int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#elif defined(__APPLE__)
+  stamp.mtime_ns = static_cast<std::int64_t>(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+  stamp.mtime_ns = static_cast<std::int64_t>(st.st_mtime) * 1000000000;
+#endif
+#endif
+  stamp.exists = true;
+  stamp.size = static_cast<std::uint64_t>(st.st_size);
+  stamp.inode = static_cast<std::uint64_t>(st.st_ino);
+  return stamp;
+}
+
+/// @brief 容器的桶数量, 没有 bucket_count() 的容器(例如 ordered_map)返回 0 (统计 rehash 次数用)
+template <typename Container>
+auto bucket_count_of(const Container &c, int) -> decltype(static_cast<std::size_t>(c.bucket_count()))
+{
+  return c.bucket_count();
+}
+template <typename Container>
+std::size_t bucket_count_of(const Container &, long)
+{
+  return 0;
+}
+
+/// @brief 保存分配器的基类, 无状态的分配器(例如 std::allocator)通过空基类优化不占用空间
+template <typename Allocator, bool = std::is_empty<Allocator>::value>
+class allocator_holder
+{
+ public:
+  allocator_holder() = default;
+  explicit allocator_holder(const Allocator &alloc) : alloc_(alloc) {}
+
+  Allocator stored_allocator() const noexcept
+  {
+    return alloc_;
+  }
+
+ private:
+  Allocator alloc_;
+};
+
+template <typename Allocator>
+class allocator_holder<Allocator, true>
+{
+ public:
+  allocator_holder() = default;
+  explicit allocator_holder(const Allocator &) {}
+
+  Allocator stored_allocator() const noexcept
+  {
+    return Allocator();
+  }
+};
+
+/// @brief 将分配器 rebind 为 std::unordered_map<Key, T> 的元素类型(detail::ordered_map 内部会再次 rebind)
+template <typename Allocator, typename Key, typename T>
+using map_allocator_t = typename std::allocator_traits<Allocator>::template rebind_alloc<std::pair<const Key, T>>;
+
+/// @brief 可拷贝的访问计数器, 使用 relaxed 原子操作, 允许在 const 查找中并发递增
+class access_counter
+{
+ public:
+  access_counter() = default;
+  access_counter(const access_counter &other) noexcept : count_(other.load()) {}
+  /// @brief 移动时计数随之转移, 源对象清零
+  access_counter(access_counter &&other) noexcept : count_(other.load())
+  {
+    other.reset();
+  }
+  access_counter &operator=(const access_counter &rhs) noexcept
+  {
+    count_.store(rhs.load(), std::memory_order_relaxed);
+    return *this;
+  }
+
+  void increment() const noexcept
+  {
+    count_.fetch_add(1, std::memory_order_relaxed);
+  }
+  std::uint64_t load() const noexcept
+  {
+    return count_.load(std::memory_order_relaxed);
+  }
+  void reset() const noexcept
+  {
+    count_.store(0, std::memory_order_relaxed);
+  }
+
+ private:
+  mutable std::atomic<std::uint64_t> count_{0};
+};
+
+/// @brief 记录查找失败(key 不存在)的次数, 只在未命中时加锁, 命中路径不受影响
+template <typename Key>
+class miss_table
+{
+ public:
+  using container = std::map<Key, std::uint64_t>;
+
+  miss_table() = default;
+  miss_table(const miss_table &other) : misses_(other.snapshot()) {}
+  /// @brief 在 other 的锁内取走其记录, 不复制(noexcept, 与所属对象的移动构造一致)
+  miss_table(miss_table &&other) noexcept
+  {
+    std::lock_guard<std::mutex> lock(other.mutex_);
+    misses_.swap(other.misses_);
+  }
+  miss_table &operator=(const miss_table &rhs)
+  {
+    if (this != &rhs)
+    {
+      container copy = rhs.snapshot();
+      std::lock_guard<std::mutex> lock(mutex_);
+      misses_.swap(copy);
+    }
+    return *this;
+  }
+
+  void add(const Key &key) const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++misses_[key];
+  }
+  container snapshot() const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return misses_;
+  }
+  void reset() const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    misses_.clear();
+  }
+
+ private:
+  mutable std::mutex mutex_;
+  mutable container misses_;
+};
 /**
  * @brief 通用转换模板,未特化的 convert 结构体
  * 由于 SFINAE(替换失败不算错误)原则,未特化的 convert 不能实例化
@@ -593,6 +989,18 @@ struct case_insensitive_hash
     std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return std::tolower(c); });
     return std::hash<std::string>{}(s);
   }
+  /// @brief 其他分配器的字符串(见 key_hash_t), 逐字符转为小写后计算 FNV-1a, 不复制
+  template <typename Traits, typename Alloc>
+  std::size_t operator()(const std::basic_string<char, Traits, Alloc> &s) const noexcept
+  {
+    std::uint64_t h = 14695981039346656037ULL;
+    for (unsigned char c : s)
+    {
+      const char lower = static_cast<char>(std::tolower(c));
+      h = fnv1a_64(&lower, 1, h);
+    }
+    return static_cast<std::size_t>(mix64(h));
+  }
 };
 
 /// @brief 大小写不敏感的比较函数
@@ -604,90 +1012,680 @@ struct case_insensitive_equal
            std::equal(lhs.begin(), lhs.end(), rhs.begin(),
                       [](unsigned char a, unsigned char b) { return std::tolower(a) == std::tolower(b); });
   }
+  template <typename Traits, typename Alloc>
+  bool operator()(const std::basic_string<char, Traits, Alloc> &lhs,
+                  const std::basic_string<char, Traits, Alloc> &rhs) const
+  {
+    return lhs.size() == rhs.size() &&
+           std::equal(lhs.begin(), lhs.end(), rhs.begin(),
+                      [](unsigned char a, unsigned char b) { return std::tolower(a) == std::tolower(b); });
+  }
 };
 
-}  // namespace detail
+/// @brief 任意分配器的字符串的哈希函数(FNV-1a), std::hash 只支持 std::string 和 std::pmr::string
+struct string_hash
+{
+  template <typename Traits, typename Alloc>
+  std::size_t operator()(const std::basic_string<char, Traits, Alloc> &s) const noexcept
+  {
+    return static_cast<std::size_t>(mix64(fnv1a_64(s.data(), s.size())));
+  }
+};
 
-/// @brief Represents a comment block for INI-style configuration, supporting multiple lines.
-class comment
+/// @brief 容器实际使用的哈希/比较函数. key 类型不是 std::string 时(分配器不同), std::hash<std::string> 和
+///        std::equal_to<std::string> 替换为接受该字符串类型的版本, 其他函数对象(例如 case_insensitive_hash)原样使用
+template <typename Hash, typename String>
+using key_hash_t = typename std::conditional<!std::is_same<String, std::string>::value &&
+                                               std::is_same<Hash, std::hash<std::string>>::value,
+                                             string_hash, Hash>::type;
+template <typename Equal, typename String>
+using key_equal_t = typename std::conditional<!std::is_same<String, std::string>::value &&
+                                                std::is_same<Equal, std::equal_to<std::string>>::value,
+                                              std::equal_to<String>, Equal>::type;
+
+/// @brief 获取或插入 key 对应的元素. 分配器无状态时使用 operator[]; 否则先查找, 不存在时用容器的分配器
+///        构造 key 和元素再插入(有状态的分配器不能默认构造, 元素和 key 的字符串都应来自容器的分配器)
+/// @tparam Key `key_type` 或 `const key_type &`
+template <typename Container, typename Key>
+typename Container::mapped_type &find_or_insert(Container &data, Key &&key)
 {
-  using comment_container = std::vector<std::string>;  // 注释容器
+  using key_type = typename Container::key_type;
+  using mapped_type = typename Container::mapped_type;
+  static_assert(std::is_same<typename std::decay<Key>::type, key_type>::value, "key must be the container key_type");
+  if (std::is_empty<typename Container::allocator_type>::value) return data[std::forward<Key>(key)];
+  auto it = data.find(key);
+  if (it != data.end()) return it->second;
+  const typename mapped_type::allocator_type alloc(data.get_allocator());
+  return data.emplace(key_type(std::forward<Key>(key), typename key_type::allocator_type(alloc)), mapped_type(alloc))
+    .first->second;
+}
 
+/**
+ * @brief 保持插入顺序的哈希表, 接口与 std::unordered_map 的常用部分一致
+ *
+ * - 每个元素单独分配一个节点, 节点指针按插入顺序存放在 std::vector 中, 遍历即按顺序扫描指针数组;
+ * - 与 std::unordered_map 一样, 插入和删除其他元素不会让已有元素的引用/指针失效(只有迭代器会失效);
+ * - 另有一个开放寻址(线性探测)的索引表, 保存元素下标和哈希值, 查找为 O(1);
+ * - 删除元素为 O(n)(需要移动后续指针并重建索引, 但不会重新计算哈希), 配置数据很少删除;
+ * - Allocator 可以是任意元素类型的分配器(例如与 std::unordered_map 相同的 `std::pair<const Key, T>`), 内部会 rebind.
+ *   拷贝/移动赋值时分配器保留在目标对象中, 分配器不相等时逐个拷贝元素.
+ */
+template <typename Key, typename T, typename Hash = std::hash<Key>, typename Equal = std::equal_to<Key>,
+          typename Allocator = std::allocator<std::pair<const Key, T>>>
+class ordered_map
+{
  public:
-  using const_iterator = typename comment_container::const_iterator;
-  using const_reverse_iterator = typename comment_container::const_reverse_iterator;
+  using key_type = Key;
+  using mapped_type = T;
+  using value_type = std::pair<const Key, T>;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using hasher = Hash;
+  using key_equal = Equal;
+  using allocator_type = Allocator;
 
-  comment() = default;
-  ~comment() = default;
+ private:
+  using node_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<value_type>;
+  using node_traits = std::allocator_traits<node_allocator>;
+  using node_pointer = typename node_traits::pointer;
+  using entry_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<node_pointer>;
+  using entry_container = std::vector<node_pointer, entry_allocator>;
 
-  /// @brief Constructs a comment from a single string (can be multi-line).
-  /// @param str Input string, lines separated by '\n'.
-  /// @param symbol Comment symbol to use (';' or '#').
-  explicit comment(const std::string &str, char symbol = ';')
-  {
-    add(str, symbol);
-  }
-  /// @brief Constructs a comment from a vector of lines.
-  explicit comment(const std::vector<std::string> &vec, char symbol = ';')
+  struct slot
   {
-    for (const auto &item : vec) add(item, symbol);
-  }
-  /// @brief Constructs a comment from an initializer list of lines.
-  comment(std::initializer_list<std::string> list, char symbol = ';')
+    std::size_t index;  // 元素下标 + 1, 0 表示空槽
+    std::size_t hash;   // 缓存哈希值, 扩容/删除时无需重新计算
+  };
+  using slot_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<slot>;
+  using slot_container = std::vector<slot, slot_allocator>;
+
+  /// @brief 按插入顺序遍历元素的迭代器, 包装节点指针数组的迭代器
+  template <bool Const>
+  class basic_iterator
+  {
+    using base_iterator = typename std::conditional<Const, typename entry_container::const_iterator,
+                                                    typename entry_container::iterator>::type;
+
+   public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = typename ordered_map::value_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = typename std::conditional<Const, const value_type *, value_type *>::type;
+    using reference = typename std::conditional<Const, const value_type &, value_type &>::type;
+
+    basic_iterator() = default;
+    explicit basic_iterator(base_iterator it) : it_(it) {}
+    /// @brief iterator 可以隐式转换为 const_iterator
+    template <bool C = Const, typename = typename std::enable_if<C>::type>
+    basic_iterator(const basic_iterator<false> &other) : it_(other.base())  // NOLINT(google-explicit-constructor)
+    {
+    }
+
+    const base_iterator &base() const noexcept
+    {
+      return it_;
+    }
+
+    reference operator*() const
+    {
+      return **it_;
+    }
+    pointer operator->() const
+    {
+      return &**it_;
+    }
+    reference operator[](difference_type n) const
+    {
+      return *it_[n];
+    }
+
+    basic_iterator &operator++()
+    {
+      ++it_;
+      return *this;
+    }
+    basic_iterator operator++(int)
+    {
+      basic_iterator tmp(*this);
+      ++it_;
+      return tmp;
+    }
+    basic_iterator &operator--()
+    {
+      --it_;
+      return *this;
+    }
+    basic_iterator operator--(int)
+    {
+      basic_iterator tmp(*this);
+      --it_;
+      return tmp;
+    }
+    basic_iterator &operator+=(difference_type n)
+    {
+      it_ += n;
+      return *this;
+    }
+    basic_iterator &operator-=(difference_type n)
+    {
+      it_ -= n;
+      return *this;
+    }
+    friend basic_iterator operator+(basic_iterator it, difference_type n)
+    {
+      return it += n;
+    }
+    friend basic_iterator operator+(difference_type n, basic_iterator it)
+    {
+      return it += n;
+    }
+    friend basic_iterator operator-(basic_iterator it, difference_type n)
+    {
+      return it -= n;
+    }
+    friend difference_type operator-(const basic_iterator &lhs, const basic_iterator &rhs)
+    {
+      return lhs.it_ - rhs.it_;
+    }
+
+    friend bool operator==(const basic_iterator &lhs, const basic_iterator &rhs)
+    {
+      return lhs.it_ == rhs.it_;
+    }
+    friend bool operator!=(const basic_iterator &lhs, const basic_iterator &rhs)
+    {
+      return lhs.it_ != rhs.it_;
+    }
+    friend bool operator<(const basic_iterator &lhs, const basic_iterator &rhs)
+    {
+      return lhs.it_ < rhs.it_;
+    }
+    friend bool operator>(const basic_iterator &lhs, const basic_iterator &rhs)
+    {
+      return lhs.it_ > rhs.it_;
+    }
+    friend bool operator<=(const basic_iterator &lhs, const basic_iterator &rhs)
+    {
+      return lhs.it_ <= rhs.it_;
+    }
+    friend bool operator>=(const basic_iterator &lhs, const basic_iterator &rhs)
+    {
+      return lhs.it_ >= rhs.it_;
+    }
+
+   private:
+    base_iterator it_{};
+  };
+
+ public:
+  using iterator = basic_iterator<false>;
+  using const_iterator = basic_iterator<true>;
+
+  ordered_map() = default;
+  explicit ordered_map(const Allocator &alloc) : entries_(entry_allocator(alloc)), slots_(slot_allocator(alloc)) {}
+  ordered_map(size_type n, const Hash &hash, const Equal &equal, const Allocator &alloc) :
+    entries_(entry_allocator(alloc)), slots_(slot_allocator(alloc)), hash_(hash), equal_(equal)
   {
-    for (const auto &item : list) add(item, symbol);
+    if (n != 0) reserve(n);
   }
-  /// @brief Swaps the internal comment data with another instance.
-  void swap(comment &other) noexcept
+  ordered_map(const ordered_map &other) :
+    ordered_map(other,
+                std::allocator_traits<Allocator>::select_on_container_copy_construction(other.get_allocator()))
   {
-    using std::swap;
-    swap(comments_, other.comments_);
   }
-  friend void swap(comment &lhs, comment &rhs) noexcept
+  ordered_map(const ordered_map &other, const Allocator &alloc) :
+    entries_(entry_allocator(alloc)), slots_(slot_allocator(alloc)), hash_(other.hash_), equal_(other.equal_)
   {
-    lhs.swap(rhs);
+    copy_from(other);
   }
-  /// @brief Copy constructor.
-  comment(const comment &other) :
-    comments_(other.comments_ ? detail::make_unique<comment_container>(*other.comments_) : nullptr)
+  ordered_map(ordered_map &&other) noexcept :
+    entries_(std::move(other.entries_)),
+    slots_(std::move(other.slots_)),
+    hash_(std::move(other.hash_)),
+    equal_(std::move(other.equal_))
   {
+    other.entries_.clear();  // 节点的所有权已转移
+    other.slots_.clear();
   }
-  /// @brief Move constructor.
-  comment(comment &&other) noexcept : comments_(std::move(other.comments_))
+  ~ordered_map()
   {
-    other.comments_.reset();  // 显式清空, 跨平台行为一致
+    clear();
   }
-  /// @brief Copy assignment.
-  comment &operator=(const comment &rhs)
+
+  /// @brief 拷贝赋值, 保留当前对象的分配器
+  ordered_map &operator=(const ordered_map &rhs)
   {
-    comment temp(rhs);  // copy ctor
-    swap(temp);         // noexcept swap
+    if (this != &rhs)
+    {
+      clear();
+      hash_ = rhs.hash_;
+      equal_ = rhs.equal_;
+      copy_from(rhs);
+    }
     return *this;
   }
-  /// @brief Move assignment.
-  comment &operator=(comment &&rhs) noexcept
+  /// @brief 移动赋值, 保留当前对象的分配器; 分配器不相等时逐个拷贝元素
+  ordered_map &operator=(ordered_map &&rhs)
   {
-    comment temp(std::move(rhs));  // move ctor
-    swap(temp);                    // noexcept swap
+    if (this == &rhs) return *this;
+    if (get_allocator() != rhs.get_allocator()) return *this = static_cast<const ordered_map &>(rhs);
+    clear();
+    entries_.swap(rhs.entries_);
+    slots_.swap(rhs.slots_);
+    hash_ = std::move(rhs.hash_);
+    equal_ = std::move(rhs.equal_);
     return *this;
   }
-  /// @brief Checks if the comment is empty.
-  bool empty() const noexcept
+
+  allocator_type get_allocator() const
   {
-    return !comments_ || comments_->empty();
+    return allocator_type(entries_.get_allocator());
   }
-  /// @brief Clears the comment.
+
+  void swap(ordered_map &other) noexcept
+  {
+    using std::swap;
+    swap(entries_, other.entries_);
+    swap(slots_, other.slots_);
+    swap(hash_, other.hash_);
+    swap(equal_, other.equal_);
+  }
+  friend void swap(ordered_map &lhs, ordered_map &rhs) noexcept
+  {
+    lhs.swap(rhs);
+  }
+
+  T &operator[](const key_type &key)
+  {
+    return try_emplace(key_type(key))->second;
+  }
+  T &operator[](key_type &&key)
+  {
+    return try_emplace(std::move(key))->second;
+  }
+
+  /// @brief 插入 key 不存在的元素, key 已存在时不做修改
+  /// @return 元素位置以及是否插入
+  template <typename K, typename V>
+  std::pair<iterator, bool> emplace(K &&key, V &&value)
+  {
+    key_type k(std::forward<K>(key));
+    const std::size_t hash = hash_(k);
+    const std::size_t pos = lookup(k, hash);
+    if (pos != npos) return {begin() + static_cast<difference_type>(pos), false};
+    if ((entries_.size() + 1) * 2 > slots_.size()) rehash((std::max)(slots_.size() * 2, std::size_t(16)));
+    entries_.push_back(node_pointer());  // 先占位, 节点创建失败时不会泄漏
+    try
+    {
+      entries_.back() = make_node(std::move(k), std::forward<V>(value));
+    }
+    catch (...)
+    {
+      entries_.pop_back();
+      throw;
+    }
+    place(slots_, slot{entries_.size(), hash});
+    return {std::prev(end()), true};
+  }
+
+  T &at(const key_type &key)
+  {
+    auto it = find(key);
+    if (it == end()) throw std::out_of_range("ordered_map::at: key not found");
+    return it->second;
+  }
+  const T &at(const key_type &key) const
+  {
+    auto it = find(key);
+    if (it == end()) throw std::out_of_range("ordered_map::at: key not found");
+    return it->second;
+  }
+
+  iterator find(const key_type &key)
+  {
+    const std::size_t pos = lookup(key, hash_(key));
+    return pos == npos ? end() : begin() + static_cast<difference_type>(pos);
+  }
+  const_iterator find(const key_type &key) const
+  {
+    const std::size_t pos = lookup(key, hash_(key));
+    return pos == npos ? end() : begin() + static_cast<difference_type>(pos);
+  }
+
+  size_type count(const key_type &key) const
+  {
+    return lookup(key, hash_(key)) == npos ? 0 : 1;
+  }
+
+  iterator erase(const_iterator first, const_iterator last)
+  {
+    const std::size_t from = static_cast<std::size_t>(first.base() - entries_.cbegin());
+    const std::size_t removed = static_cast<std::size_t>(last - first);
+    if (removed == 0) return begin() + static_cast<difference_type>(from);
+    for (auto it = first.base(); it != last.base(); ++it) destroy_node(*it);
+    auto it = entries_.erase(first.base(), last.base());
+    reindex_after_erase(from, removed);
+    return iterator(it);
+  }
+  iterator erase(const_iterator pos)
+  {
+    return erase(pos, std::next(pos));
+  }
+  iterator erase(iterator pos)
+  {
+    return erase(const_iterator(pos));
+  }
+  size_type erase(const key_type &key)
+  {
+    auto it = find(key);
+    if (it == end()) return 0;
+    erase(it);
+    return 1;
+  }
+
+  void clear() noexcept
+  {
+    for (node_pointer p : entries_) destroy_node(p);
+    entries_.clear();
+    slots_.clear();
+  }
+
+  void reserve(size_type n)
+  {
+    entries_.reserve(n);
+    if (n * 2 > slots_.size()) rehash(n * 2);
+  }
+
+  size_type size() const noexcept
+  {
+    return entries_.size();
+  }
+  bool empty() const noexcept
+  {
+    return entries_.empty();
+  }
+
+  iterator begin() noexcept
+  {
+    return iterator(entries_.begin());
+  }
+  const_iterator begin() const noexcept
+  {
+    return const_iterator(entries_.begin());
+  }
+  iterator end() noexcept
+  {
+    return iterator(entries_.end());
+  }
+  const_iterator end() const noexcept
+  {
+    return const_iterator(entries_.end());
+  }
+  const_iterator cbegin() const noexcept
+  {
+    return begin();
+  }
+  const_iterator cend() const noexcept
+  {
+    return end();
+  }
+
+ private:
+  static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+  /// @brief 使用容器的分配器创建一个节点
+  template <typename... Args>
+  node_pointer make_node(Args &&...args)
+  {
+    node_allocator alloc(entries_.get_allocator());
+    node_pointer p = node_traits::allocate(alloc, 1);
+    try
+    {
+      node_traits::construct(alloc, std::addressof(*p), std::forward<Args>(args)...);
+    }
+    catch (...)
+    {
+      node_traits::deallocate(alloc, p, 1);
+      throw;
+    }
+    return p;
+  }
+
+  void destroy_node(node_pointer p) noexcept
+  {
+    node_allocator alloc(entries_.get_allocator());
+    node_traits::destroy(alloc, std::addressof(*p));
+    node_traits::deallocate(alloc, p, 1);
+  }
+
+  /// @brief 逐个拷贝 other 的元素(当前对象为空), 索引表直接复用
+  void copy_from(const ordered_map &other)
+  {
+    entries_.reserve(other.entries_.size());
+    for (node_pointer p : other.entries_)
+    {
+      entries_.push_back(node_pointer());
+      try
+      {
+        entries_.back() = make_node(*p);
+      }
+      catch (...)
+      {
+        entries_.pop_back();
+        clear();
+        throw;
+      }
+    }
+    slots_.assign(other.slots_.begin(), other.slots_.end());
+  }
+
+  /// @brief 查找 key 对应的元素下标, 不存在时返回 npos
+  std::size_t lookup(const key_type &key, std::size_t hash) const
+  {
+    if (slots_.empty()) return npos;
+    const std::size_t mask = slots_.size() - 1;
+    for (std::size_t i = hash & mask;; i = (i + 1) & mask)
+    {
+      const slot &s = slots_[i];
+      if (s.index == 0) return npos;
+      if (s.hash == hash && equal_(entries_[s.index - 1]->first, key)) return s.index - 1;
+    }
+  }
+
+  /// @brief 查找或插入(值初始化) key 对应的元素
+  iterator try_emplace(key_type &&key)
+  {
+    return emplace(std::move(key), T()).first;
+  }
+
+  static void place(slot_container &slots, const slot &s)
+  {
+    const std::size_t mask = slots.size() - 1;
+    std::size_t i = s.hash & mask;
+    while (slots[i].index != 0) i = (i + 1) & mask;
+    slots[i] = s;
+  }
+
+  /// @brief 重建索引表, 容量向上取整为2的幂
+  void rehash(std::size_t capacity)
+  {
+    std::size_t size = 16;
+    while (size < capacity) size *= 2;
+    slot_container slots(size, slot{0, 0}, slots_.get_allocator());
+    for (const slot &s : slots_)
+    {
+      if (s.index != 0) place(slots, s);
+    }
+    slots_.swap(slots);
+  }
+
+  /// @brief 删除 [from, from + removed) 范围的元素后修正索引表(使用缓存的哈希值, 不重新计算)
+  void reindex_after_erase(std::size_t from, std::size_t removed)
+  {
+    slot_container slots(slots_.size(), slot{0, 0}, slots_.get_allocator());
+    for (slot s : slots_)
+    {
+      if (s.index == 0 || (s.index - 1 >= from && s.index - 1 < from + removed)) continue;
+      if (s.index - 1 >= from + removed) s.index -= removed;
+      place(slots, s);
+    }
+    slots_.swap(slots);
+  }
+
+ private:
+  entry_container entries_;  // 按插入顺序存放的节点指针, 节点本身不会移动
+  slot_container slots_;     // 开放寻址索引表, 大小为2的幂
+  Hash hash_;
+  Equal equal_;
+};
+
+}  // namespace detail
+
+// 先声明模板类 basic_inifile, 声明友元的时候需要
+// 声明完整的类型, 否则编译器会报错
+template <typename, typename, template <typename...> class, typename, typename>
+class basic_inifile;
+template <typename, typename, template <typename...> class, typename, typename>
+class basic_section;
+
+/// @brief Represents a comment block for INI-style configuration, supporting multiple lines.
+/// @tparam Allocator Allocator (rebound to `char`) for the comment lines and their container, `ini::comment` uses
+///         `std::allocator<char>`. The allocator stays with the object on assignment, `swap()` requires equal
+///         allocators.
+template <typename Allocator = std::allocator<char>>
+class basic_comment : private detail::allocator_holder<detail::char_allocator_t<Allocator>>
+{
+  template <typename, typename, template <typename...> class, typename, typename>
+  friend class basic_inifile;
+  template <typename>
+  friend class basic_comment;
+
+ public:
+  using allocator_type = detail::char_allocator_t<Allocator>;
+  using string_type = detail::string_t<Allocator>;  // 注释行, 默认分配器下为 std::string
+
+ private:
+  using holder = detail::allocator_holder<allocator_type>;
+  using comment_container = std::vector<  // 注释容器
+    string_type, typename std::allocator_traits<allocator_type>::template rebind_alloc<string_type>>;
+  using container_allocator = typename std::allocator_traits<allocator_type>::template rebind_alloc<comment_container>;
+  using container_traits = std::allocator_traits<container_allocator>;
+
+ public:
+  using const_iterator = typename comment_container::const_iterator;
+  using const_reverse_iterator = typename comment_container::const_reverse_iterator;
+
+  basic_comment() = default;
+  /// @brief Constructs an empty comment whose lines will be allocated with `alloc`.
+  explicit basic_comment(const allocator_type &alloc) : holder(alloc) {}
+  ~basic_comment()
+  {
+    clear();
+  }
+
+  /// @brief Constructs a comment from a single string (can be multi-line).
+  /// @param str Input string, lines separated by '\n'.
+  /// @param symbol Comment symbol to use (';' or '#').
+  explicit basic_comment(const std::string &str, char symbol = ';', const allocator_type &alloc = allocator_type()) :
+    holder(alloc)
+  {
+    add(str, symbol);
+  }
+  /// @brief Constructs a comment from a vector of lines.
+  explicit basic_comment(const std::vector<std::string> &vec, char symbol = ';',
+                         const allocator_type &alloc = allocator_type()) :
+    holder(alloc)
+  {
+    for (const auto &item : vec) add(item, symbol);
+  }
+  /// @brief Constructs a comment from an initializer list of lines.
+  basic_comment(std::initializer_list<std::string> list, char symbol = ';',
+                const allocator_type &alloc = allocator_type()) :
+    holder(alloc)
+  {
+    for (const auto &item : list) add(item, symbol);
+  }
+  /// @brief Converting constructor: copies the lines of a comment using another allocator.
+  template <typename OtherAllocator>
+  explicit basic_comment(const basic_comment<OtherAllocator> &other, const allocator_type &alloc = allocator_type()) :
+    holder(alloc)
+  {
+    add(other);
+  }
+  /// @brief Swaps the internal comment data with another instance, the allocators must compare equal.
+  void swap(basic_comment &other) noexcept
+  {
+    using std::swap;
+    swap(comments_, other.comments_);
+  }
+  friend void swap(basic_comment &lhs, basic_comment &rhs) noexcept
+  {
+    lhs.swap(rhs);
+  }
+  /// @brief Copy constructor.
+  basic_comment(const basic_comment &other) :
+    holder(std::allocator_traits<allocator_type>::select_on_container_copy_construction(other.get_allocator()))
+  {
+    add(other);
+  }
+  /// @brief Allocator-extended copy constructor.
+  basic_comment(const basic_comment &other, const allocator_type &alloc) : holder(alloc)
+  {
+    add(other);
+  }
+  /// @brief Move constructor.
+  basic_comment(basic_comment &&other) noexcept : holder(other.get_allocator()), comments_(other.comments_)
+  {
+    other.comments_ = nullptr;  // 显式清空, 跨平台行为一致
+  }
+  /// @brief Allocator-extended move constructor, the lines are copied if the allocators differ.
+  basic_comment(basic_comment &&other, const allocator_type &alloc) : holder(alloc)
+  {
+    add(std::move(other));
+  }
+  /// @brief Copy assignment.
+  basic_comment &operator=(const basic_comment &rhs)
+  {
+    basic_comment temp(rhs, get_allocator());  // copy ctor
+    swap(temp);                                // noexcept swap
+    return *this;
+  }
+  /// @brief Move assignment.
+  basic_comment &operator=(basic_comment &&rhs) noexcept(std::is_empty<allocator_type>::value)
+  {
+    basic_comment temp(std::move(rhs), get_allocator());  // move ctor, 分配器不同时复制
+    swap(temp);                                           // noexcept swap
+    return *this;
+  }
+  /// @brief Get the allocator used for the comment lines.
+  allocator_type get_allocator() const noexcept
+  {
+    return this->stored_allocator();
+  }
+  /// @brief Checks if the comment is empty.
+  bool empty() const noexcept
+  {
+    return !comments_ || comments_->empty();
+  }
+  /// @brief Clears the comment.
   void clear() noexcept
   {
-    comments_.reset();
+    if (!comments_) return;
+    container_allocator alloc(get_allocator());
+    comments_->~comment_container();
+    container_traits::deallocate(alloc, comments_, 1);
+    comments_ = nullptr;
   }
   /// @brief Returns a copy of the internal comment lines.
   std::vector<std::string> to_vector() const
   {
-    return comments_ ? *comments_ : comment_container{};
+    std::vector<std::string> result;
+    result.reserve(view().size());
+    for (const auto &line : view()) result.push_back(detail::to_std_string(line));
+    return result;
   }
   /// @brief Returns a const reference to the internal comment lines.
-  const std::vector<std::string> &view() const
+  const comment_container &view() const
   {
     return comments_ ? *comments_ : empty_comments();  // 避免返回空引用
   }
@@ -700,20 +1698,34 @@ class comment
     add_comments_from_string(str, symbol);
   }
   /// @brief Appends comment lines from another comment.
-  void add(const comment &other)
+  void add(const basic_comment &other)
   {
-    if (other.empty()) return;
-    ensure_comments_initialized();
-    comments_->insert(comments_->end(), other.comments_->begin(), other.comments_->end());
+    add_lines(other);
+  }
+  /// @brief Appends comment lines from a comment using another allocator.
+  template <typename OtherAllocator>
+  void add(const basic_comment<OtherAllocator> &other)
+  {
+    add_lines(other);
   }
 
   /// @brief Moves comment lines from another comment.
-  void add(comment &&other)  // NOLINT(cppcoreguidelines-rvalue-reference-param-not-moved)
+  void add(basic_comment &&other)  // NOLINT(cppcoreguidelines-rvalue-reference-param-not-moved)
   {
     if (other.empty()) return;
-    ensure_comments_initialized();
-    comments_->insert(comments_->end(), std::make_move_iterator(other.comments_->begin()),
-                      std::make_move_iterator(other.comments_->end()));
+    if (!(get_allocator() == other.get_allocator()))  // 分配器不同, 只能复制
+    {
+      add_lines(other);
+    }
+    else if (empty())
+    {
+      swap(other);  // 直接接管 other 的注释容器
+    }
+    else
+    {
+      comments_->insert(comments_->end(), std::make_move_iterator(other.comments_->begin()),
+                        std::make_move_iterator(other.comments_->end()));
+    }
     other.clear();  // 清空 other 的 comments_，防止重复使用
   }
   /// @brief Appends comment lines from an initializer list.
@@ -732,35 +1744,42 @@ class comment
     }
     else
     {
-      comments_.reset();  // 不需要保留空注释
+      clear();  // 不需要保留空注释
     }
   }
   /// @brief Replaces current comment content with another comment (copy).
-  void set(const comment &other)
+  void set(const basic_comment &other)
+  {
+    basic_comment temp(other, get_allocator());  // copy
+    swap(temp);                                  // noexcept swap
+  }
+  /// @brief Replaces current comment content with a comment using another allocator (copy).
+  template <typename OtherAllocator>
+  void set(const basic_comment<OtherAllocator> &other)
   {
-    comment temp(other);  // copy
-    swap(temp);           // noexcept swap
+    basic_comment temp(other, get_allocator());
+    swap(temp);
   }
   /// @brief Replaces current comment content with another comment (move).
-  void set(comment &&other) noexcept
+  void set(basic_comment &&other) noexcept(std::is_empty<allocator_type>::value)
   {
-    comment temp(std::move(other));  // move
-    swap(temp);                      // noexcept swap
+    basic_comment temp(std::move(other), get_allocator());  // move
+    swap(temp);                                             // noexcept swap
   }
   /// @brief Replaces current comment content with an initializer list.
   void set(std::initializer_list<std::string> list, char symbol = ';')
   {
-    set(comment(list, symbol));
+    set(basic_comment(list, symbol, get_allocator()));
   }
 
   // Iterators for read-only access
   const_iterator begin() const
   {
-    return comments_ ? comments_->cbegin() : empty_comments().cbegin();
+    return view().cbegin();
   }
   const_iterator end() const
   {
-    return comments_ ? comments_->cend() : empty_comments().cend();
+    return view().cend();
   }
   const_iterator cbegin() const
   {
@@ -772,11 +1791,11 @@ class comment
   }
   const_reverse_iterator rbegin() const
   {
-    return comments_ ? comments_->crbegin() : empty_comments().crbegin();
+    return view().crbegin();
   }
   const_reverse_iterator rend() const
   {
-    return comments_ ? comments_->crend() : empty_comments().crend();
+    return view().crend();
   }
   const_reverse_iterator crbegin() const
   {
@@ -787,22 +1806,48 @@ class comment
     return rend();
   }
   /// @brief Compares two comments for equality.
-  bool operator==(const comment &rhs) const
+  bool operator==(const basic_comment &rhs) const
   {
     if (comments_ && rhs.comments_) return *comments_ == *rhs.comments_;
     return !comments_ && !rhs.comments_;
   }
+  /// @brief Compares with a comment using another allocator, the lines are compared.
+  template <typename OtherAllocator>
+  bool operator==(const basic_comment<OtherAllocator> &rhs) const
+  {
+    if (!comments_ || !rhs.comments_) return !comments_ && !rhs.comments_;
+    using other_string = typename basic_comment<OtherAllocator>::string_type;
+    return comments_->size() == rhs.comments_->size() &&
+           std::equal(begin(), end(), rhs.begin(), [](const string_type &a, const other_string &b) {
+             return a.size() == b.size() && std::char_traits<char>::compare(a.data(), b.data(), a.size()) == 0;
+           });
+  }
   /// @brief Compares two comments for inequality.
-  bool operator!=(const comment &rhs) const
+  template <typename OtherAllocator>
+  bool operator!=(const basic_comment<OtherAllocator> &rhs) const
   {
     return !(*this == rhs);
   }
 
  private:
-  /// @brief 初始化 comments_, 确保不为nullptr
+  /// @brief 初始化 comments_, 确保不为nullptr. 容器对象和注释行都使用本对象的分配器
   void ensure_comments_initialized()
   {
-    if (!comments_) comments_ = detail::make_unique<comment_container>();
+    if (comments_) return;
+    container_allocator alloc(get_allocator());
+    comment_container *p = container_traits::allocate(alloc, 1);
+    ::new (static_cast<void *>(p)) comment_container(typename comment_container::allocator_type(get_allocator()));
+    comments_ = p;
+  }
+
+  /// @brief 逐行复制 other 的注释, 新的注释行使用本对象的分配器
+  template <typename Other>
+  void add_lines(const Other &other)
+  {
+    if (other.empty()) return;
+    ensure_comments_initialized();
+    comments_->reserve(comments_->size() + other.view().size());
+    for (const auto &line : other) comments_->push_back(string_type(line.data(), line.size(), get_allocator()));
   }
 
   static std::string format_comment_line(std::string comment, char symbol)
@@ -828,7 +1873,8 @@ class comment
     while (std::getline(stream, line))
     {
       if (detail::is_all_whitespace(line)) continue;
-      comments_->emplace_back(format_comment_line(std::move(line), symbol));
+      comments_->push_back(
+        detail::make_string<string_type>(format_comment_line(std::move(line), symbol), get_allocator()));
     }
   }
 
@@ -841,10 +1887,14 @@ class comment
   }
 
  private:
-  std::unique_ptr<comment_container> comments_{nullptr};  // 行级注释容器, 使用unique_ptr主要考虑内存占用更小
+  comment_container *comments_ = nullptr;  // 行级注释容器, 使用指针主要考虑内存占用更小
 };
 
-inline std::ostream &operator<<(std::ostream &os, const comment &c)
+/// @brief comment lines using `std::allocator`, the comment type of `ini::field` and `ini::section`
+using comment = basic_comment<>;
+
+template <typename Allocator>
+std::ostream &operator<<(std::ostream &os, const basic_comment<Allocator> &c)
 {
   for (const auto &line : c.view())
   {
@@ -853,74 +1903,270 @@ inline std::ostream &operator<<(std::ostream &os, const comment &c)
   return os;
 }
 
-// 先声明模板类 basic_inifile, 声明友元的时候需要
-// 声明完整的类型, 否则编译器会报错
-template <typename, typename>
-class basic_inifile;
+/// @brief Comment policy (default): `[section]` and `key=value` comments are parsed, stored and written.
+struct keep_comments
+{
+  static constexpr bool enabled = true;
+};
+
+/// @brief Comment policy: comments are dropped. `field` and the section storage carry no comment member,
+///        the parser skips comment lines without allocating, and the comment setters are no-ops.
+struct no_comments
+{
+  static constexpr bool enabled = false;
+};
+
+namespace detail
+{
+/// @brief field 和 section 共享存储中的注释, 作为基类时利用空基类优化, 禁用注释时不占空间
+template <bool Enabled, typename Allocator>
+class comment_slot
+{
+ public:
+  using comment_type = basic_comment<Allocator>;
+
+  comment_slot() = default;
+  explicit comment_slot(const Allocator &alloc) : comments_(alloc) {}
+  comment_slot(const comment_slot &other, const Allocator &alloc) : comments_(other.comments_, alloc) {}
+  comment_slot(comment_slot &&other, const Allocator &alloc) : comments_(std::move(other.comments_), alloc) {}
+
+  const comment_type &stored_comment() const noexcept
+  {
+    return comments_;
+  }
+  /// @brief 可写的注释, 禁用注释时为 nullptr
+  comment_type *writable_comment() noexcept
+  {
+    return &comments_;
+  }
+  void swap_comment(comment_slot &other) noexcept
+  {
+    comments_.swap(other.comments_);
+  }
+
+ private:
+  comment_type comments_;
+};
+
+template <typename Allocator>
+class comment_slot<false, Allocator>
+{
+ public:
+  using comment_type = basic_comment<Allocator>;
+
+  comment_slot() = default;
+  explicit comment_slot(const Allocator &) {}
+  comment_slot(const comment_slot &, const Allocator &) {}
+  comment_slot(comment_slot &&, const Allocator &) {}
+
+  const comment_type &stored_comment() const noexcept
+  {
+    static const comment_type empty;
+    return empty;
+  }
+  comment_type *writable_comment() noexcept
+  {
+    return nullptr;
+  }
+  void swap_comment(comment_slot &) noexcept {}
+};
+
+/// @brief field 的值与 T 之间的转换. 值的字符串类型就是 std::string 时直接使用 convert<T>; 否则(分配器不同)
+///        经由 std::string 临时对象转换, 因此 decode 结果不能指向临时对象(const char*/string_view 单独处理)
+template <typename T, typename String, bool = std::is_same<String, std::string>::value>
+struct value_codec : convert<T>
+{
+};
+template <typename T, typename String>
+struct value_codec<T, String, false>
+{
+  static void decode(const String &value, T &result)
+  {
+    convert<T>::decode(std::string(value.data(), value.size()), result);
+  }
+  static void encode(const T &value, String &result)
+  {
+    std::string temp;
+    convert<T>::encode(value, temp);
+    result.assign(temp.data(), temp.size());
+  }
+};
+template <typename String>
+struct value_codec<std::string, String, false>
+{
+  static void decode(const String &value, std::string &result)
+  {
+    result.assign(value.data(), value.size());
+  }
+  static void encode(const std::string &value, String &result)
+  {
+    result.assign(value.data(), value.size());
+  }
+};
+template <typename String>
+struct value_codec<const char *, String, false>
+{
+  static void decode(const String &value, const char *&result)
+  {
+    result = value.c_str();
+  }
+  static void encode(const char *value, String &result)
+  {
+    result = value;
+  }
+};
+#ifdef __cpp_lib_string_view
+template <typename String>
+struct value_codec<std::string_view, String, false>
+{
+  static void decode(const String &value, std::string_view &result)
+  {
+    result = std::string_view(value.data(), value.size());
+  }
+  static void encode(const std::string_view value, String &result)
+  {
+    result.assign(value.data(), value.size());
+  }
+};
+#endif
+}  // namespace detail
 
 /// @brief ini field value
-class field
+/// @tparam CommentPolicy `keep_comments` (default) or `no_comments`, see `basic_inifile`.
+/// @tparam Allocator Allocator (rebound to `char`) for the value and comment strings, handed down by the
+///         section that stores the field. The allocator stays with the object on assignment, `swap()` requires
+///         equal allocators.
+template <typename CommentPolicy, typename Allocator = std::allocator<char>>
+class basic_field : private detail::comment_slot<CommentPolicy::enabled, detail::char_allocator_t<Allocator>>
 {
-  friend std::ostream &operator<<(std::ostream &os, const field &data);
+  using comment_slot = detail::comment_slot<CommentPolicy::enabled, detail::char_allocator_t<Allocator>>;
+  template <typename, typename, template <typename...> class, typename, typename>
+  friend class basic_inifile;
+  template <typename, typename, template <typename...> class, typename, typename>
+  friend class basic_section;
 
  public:
+  using allocator_type = detail::char_allocator_t<Allocator>;
+  using string_type = detail::string_t<Allocator>;                    // 默认分配器下为 std::string
+  using comment_type = typename comment_slot::comment_type;           // 默认分配器下为 ini::comment
+
   /// 默认构造函数,使用编译器生成的默认实现.
-  field() = default;
+  basic_field() = default;
+  /// @brief Constructs an empty field whose value and comment are allocated with `alloc`.
+  explicit basic_field(const allocator_type &alloc) : comment_slot(alloc), value_(alloc) {}
 
   /// 参数构造函数：通过传入字符串初始化 value_
   /// 使用 pass-by-value 统一接收左值/右值，结合 std::move 实现高效构造
-  explicit field(std::string value) : value_(std::move(value)) {}
+  explicit basic_field(string_type value) : value_(std::move(value)) {}
 
   /// 默认析构函数,使用编译器生成的默认实现.
-  ~field() = default;
+  ~basic_field() = default;
 
-  /// @brief 成员swap函数
-  void swap(field &other) noexcept
+  /// @brief 成员swap函数, 访问计数属于 key 所在的位置, 不参与交换(赋值不会改变目标 key 的计数)
+  void swap(basic_field &other) noexcept
   {
     using std::swap;
     swap(value_, other.value_);
-    swap(comments_, other.comments_);
+    this->swap_comment(other);
   }
 
   // 友元 swap(非成员函数)(std::swap 支持)
-  friend void swap(field &lhs, field &rhs) noexcept
+  friend void swap(basic_field &lhs, basic_field &rhs) noexcept
   {
     lhs.swap(rhs);
   }
 
   /// 移动构造函数
-  field(field &&other) noexcept : value_(std::move(other.value_)), comments_(std::move(other.comments_))
+  basic_field(basic_field &&other) noexcept :
+    comment_slot(std::move(other)),
+    value_(std::move(other.value_))
+#if INIFILE_ENABLE_ACCESS_COUNTERS
+    ,
+    hits_(std::move(other.hits_))
+#endif
+  {
+    other.value_.clear();  // 显式清空, 跨平台行为一致(注释对象移动后已为空)
+  }
+
+  /// @brief Allocator-extended move constructor, the value and comment are copied if the allocators differ.
+  basic_field(basic_field &&other, const allocator_type &alloc) :
+    comment_slot(std::move(other), alloc),
+    value_(std::move(other.value_), alloc)
+#if INIFILE_ENABLE_ACCESS_COUNTERS
+    ,
+    hits_(std::move(other.hits_))
+#endif
   {
-    other.value_.clear();     // 显式清空, 跨平台行为一致
-    other.comments_.clear();  // 显式清空, 跨平台行为一致
+    other.value_.clear();
   }
 
-  /// 移动赋值运算符
-  field &operator=(field &&rhs) noexcept
+  /// 移动赋值运算符, 保留当前对象的分配器
+  basic_field &operator=(basic_field &&rhs) noexcept(std::is_empty<allocator_type>::value)
   {
-    field temp(std::move(rhs));  // move ctor
-    swap(temp);                  // noexcept swap
+    basic_field temp(std::move(rhs), get_allocator());  // move ctor, 分配器不同时复制
+    swap(temp);                                         // noexcept swap
     return *this;
   }
 
   /// 重写拷贝构造函数,深拷贝 other 对象.
-  field(const field &other) : value_(other.value_), comments_(other.comments_) {}
+  basic_field(const basic_field &other) :
+    comment_slot(other),
+    value_(other.value_)
+#if INIFILE_ENABLE_ACCESS_COUNTERS
+    ,
+    hits_(other.hits_)
+#endif
+  {
+  }
+
+  /// @brief Allocator-extended copy constructor.
+  basic_field(const basic_field &other, const allocator_type &alloc) :
+    comment_slot(other, alloc),
+    value_(other.value_, alloc)
+#if INIFILE_ENABLE_ACCESS_COUNTERS
+    ,
+    hits_(other.hits_)
+#endif
+  {
+  }
 
-  /// 重写拷贝赋值(copy-and-swap 方式)
-  field &operator=(const field &rhs)  // `rhs` pass by reference
+  /// @brief Converting constructor: copies the value and comment of a field using another allocator.
+  template <typename OtherAllocator>
+  explicit basic_field(const basic_field<CommentPolicy, OtherAllocator> &other,
+                       const allocator_type &alloc = allocator_type()) :
+    comment_slot(alloc),
+    value_(other.str().data(), other.str().size(), alloc)
   {
-    field temp(rhs);  // 使用拷贝构造函数创建一个临时对象, 这里会分配内存
-    swap(temp);       // 利用拷贝构造+swap, 确保异常安全,也能处理自赋值问题
+    set_comment(other.comment());
+  }
+
+  /// 重写拷贝赋值(copy-and-swap 方式), 保留当前对象的分配器
+  basic_field &operator=(const basic_field &rhs)  // `rhs` pass by reference
+  {
+    basic_field temp(rhs, get_allocator());  // 使用拷贝构造函数创建一个临时对象, 这里会分配内存
+    swap(temp);                              // 利用拷贝构造+swap, 确保异常安全,也能处理自赋值问题
+    return *this;
+  }
+
+  /// @brief Assigns the value and comment of a field using another allocator.
+  template <typename OtherAllocator>
+  basic_field &operator=(const basic_field<CommentPolicy, OtherAllocator> &rhs)
+  {
+    basic_field temp(rhs, get_allocator());
+    swap(temp);
     return *this;
   }
 
   /// @brief Template constructor: allows construction of `field` objects from values ​​of other types.
   /// @tparam T Other type T
   /// @param other Other type value
-  template <typename T>
-  field(const T &other)  // NOLINT(google-explicit-constructor)
+  /// @note Disabled for allocators and `std::allocator_arg_t`, so that uses-allocator construction (pmr containers)
+  ///       picks the allocator constructors instead of encoding the allocator as a value.
+  template <typename T, typename = typename std::enable_if<!std::is_same<T, std::allocator_arg_t>::value &&
+                                                           !std::is_convertible<const T &, allocator_type>::value>::type>
+  basic_field(const T &other)  // NOLINT(google-explicit-constructor)
   {
-    detail::convert<T>::encode(other, value_);  // 将传入的值编码成字符串并存储到 value_ 中
+    codec<T>::encode(other, value_);  // 将传入的值编码成字符串并存储到 value_ 中
   }
 
   /// @brief Template copy assignment operator. Allows values ​​of other types to be assigned to `field` objects.
@@ -928,10 +2174,10 @@ class field
   /// @param rhs Other type value
   /// @return `field` reference
   template <typename T>
-  field &operator=(const T &rhs)
+  basic_field &operator=(const T &rhs)
   {
-    detail::convert<T>::encode(rhs, value_);  // 将右侧值编码成字符串并存储到 value_ 中
-    return *this;                             // 返回当前对象的引用,支持链式赋值
+    codec<T>::encode(rhs, value_);  // 将右侧值编码成字符串并存储到 value_ 中
+    return *this;                   // 返回当前对象的引用,支持链式赋值
   }
 
   /// @brief Converts an ini field to target type T. If the conversion fails, exception will be thrown.
@@ -942,9 +2188,9 @@ class field
   template <typename T>
   T as() const
   {
-    T result;                                    // 用于存储转换后的结果
-    detail::convert<T>::decode(value_, result);  // 将 value_ 字符串解码为目标类型 T
-    return result;                               // 返回转换结果
+    T result;                          // 用于存储转换后的结果
+    codec<T>::decode(value_, result);  // 将 value_ 字符串解码为目标类型 T
+    return result;                     // 返回转换结果
   }
 
   /// @brief Converts an ini field to target type T and stores the result in the given output variable.
@@ -956,8 +2202,8 @@ class field
   template <typename T>
   T &as_to(T &out) const
   {
-    detail::convert<T>::decode(value_, out);  // 将 value_ 字符串解码为目标类型 T, 并存储到 out 中
-    return out;                               // 返回转换后的引用
+    codec<T>::decode(value_, out);  // 将 value_ 字符串解码为目标类型 T, 并存储到 out 中
+    return out;                     // 返回转换后的引用
   }
 
   /// @brief Type conversion operator: allows field objects to be converted to the target type T.
@@ -977,9 +2223,9 @@ class field
   /// @param value The value to be stored.
   /// @return Reference to the current field (for chaining).
   template <typename T>
-  field &set(const T &value)
+  basic_field &set(const T &value)
   {
-    detail::convert<T>::encode(value, value_);  // 将值编码为字符串存储到 value_ 中
+    codec<T>::encode(value, value_);  // 将值编码为字符串存储到 value_ 中
     return *this;
   }
 
@@ -988,24 +2234,30 @@ class field
   /// @param symbol Comment symbol, default is `;`. Only `;` and `#` are supported.
   void set_comment(const std::string &str, char symbol = ';')
   {
-    comments_.set(str, symbol);
+    if (comment_type *c = this->writable_comment()) c->set(str, symbol);
   }
   /// @brief Overwrite the current comment with another comment (copy).
-  void set_comment(const comment &other)
+  void set_comment(const comment_type &other)
+  {
+    if (comment_type *c = this->writable_comment()) c->set(other);
+  }
+  /// @brief Overwrite the current comment with a comment using another allocator (copy).
+  template <typename OtherAllocator>
+  void set_comment(const basic_comment<OtherAllocator> &other)
   {
-    comments_.set(other);
+    if (comment_type *c = this->writable_comment()) c->set(other);
   }
   /// @brief Overwrite the current comment with another comment (move).
-  void set_comment(comment &&other) noexcept
+  void set_comment(comment_type &&other) noexcept(std::is_empty<allocator_type>::value)
   {
-    comments_.set(std::move(other));
+    if (comment_type *c = this->writable_comment()) c->set(std::move(other));
   }
   /// @brief Set the comment from an initializer list of strings.
   /// @param list List of comment lines.
   /// @param symbol Comment symbol, default is `;`. Only `;` and `#` are supported.
   void set_comment(std::initializer_list<std::string> list, char symbol = ';')
   {
-    comments_.set(list, symbol);
+    if (comment_type *c = this->writable_comment()) c->set(list, symbol);
   }
 
   /// @brief Add `key=value` comments by appending to the existing ones.
@@ -1013,43 +2265,50 @@ class field
   /// @param symbol Comment symbol, default is `;`. Only `;` and `#` are supported.
   void add_comment(const std::string &str, char symbol = ';')
   {
-    comments_.add(str, symbol);
+    if (comment_type *c = this->writable_comment()) c->add(str, symbol);
   }
   /// @brief Append comments from another comment object (copy).
-  void add_comment(const comment &other)
+  void add_comment(const comment_type &other)
+  {
+    if (comment_type *c = this->writable_comment()) c->add(other);
+  }
+  /// @brief Append comments from a comment object using another allocator (copy).
+  template <typename OtherAllocator>
+  void add_comment(const basic_comment<OtherAllocator> &other)
   {
-    comments_.add(other);
+    if (comment_type *c = this->writable_comment()) c->add(other);
   }
   /// @brief Append comments from another comment object (move).
-  void add_comment(comment &&other) noexcept
+  void add_comment(comment_type &&other) noexcept
   {
-    comments_.add(std::move(other));
+    if (comment_type *c = this->writable_comment()) c->add(std::move(other));
   }
   /// @brief Append comments from an initializer list of strings.
   /// @param list List of comment lines.
   /// @param symbol Comment symbol, default is `;`. Only `;` and `#` are supported.
   void add_comment(std::initializer_list<std::string> list, char symbol = ';')
   {
-    comments_.add(list, symbol);
+    if (comment_type *c = this->writable_comment()) c->add(list, symbol);
   }
 
   /// @brief Get a const reference to the comment associated with this field.
   /// @return Const reference to the internal `comment` object.
-  const ini::comment &comment() const
+  const comment_type &comment() const
   {
-    return comments_;
+    return this->stored_comment();
   }
   /// @brief Get a mutable reference to the comment associated with this field.
   /// @return Reference to the internal `comment` object.
-  ini::comment &comment()
+  comment_type &comment()
   {
-    return comments_;
+    static_assert(CommentPolicy::enabled, "comments are not stored under the no_comments policy");
+    return *this->writable_comment();
   }
 
   /// @brief Clear `key=value` comment
   void clear_comment()
   {
-    comments_.clear();
+    if (comment_type *c = this->writable_comment()) c->clear();
   }
 
   bool empty() const noexcept
@@ -1057,23 +2316,99 @@ class field
     return value_.empty();
   }
 
+  /// @brief Get a const reference to the underlying string value, without conversion or copy.
+  const string_type &str() const noexcept
+  {
+    return value_;
+  }
+
+  /// @brief Get the allocator used for the value and comment strings.
+  allocator_type get_allocator() const noexcept
+  {
+    return value_.get_allocator();
+  }
+
+  /// @brief Compute a 64-bit fingerprint of the field value and its comment.
+  /// @return Fingerprint, equal fields always produce equal fingerprints.
+  std::uint64_t fingerprint() const noexcept
+  {
+    std::uint64_t h = detail::hash_append(0, value_);
+    for (const auto &line : this->stored_comment()) h = detail::hash_append(h, line);
+    return h;
+  }
+
  private:
-  std::string value_;      // 存储字符串值,用于存储读取的 INI 文件字段值
-  ini::comment comments_;  // key-value 键值对的注释
+  template <typename T>
+  using codec = detail::value_codec<T, string_type>;
+
+  string_type value_;  // 存储字符串值,用于存储读取的 INI 文件字段值, 注释存放在基类 comment_slot 中
+#if INIFILE_ENABLE_ACCESS_COUNTERS
+  detail::access_counter hits_;  // get/at/contains/operator[] 命中次数
+#endif
+
+  friend std::ostream &operator<<(std::ostream &os, const basic_field &data)
+  {
+    return os << data.value_;
+  }
 };
 
-inline std::ostream &operator<<(std::ostream &os, const field &data)
+/// @brief ini field value with comment storage, the value type of `ini::inifile` and `ini::section`
+using field = basic_field<keep_comments>;
+
+/// @brief Lookup counts of one key, see `access_report`.
+struct key_access
 {
-  return os << data.value_;
-}
+  std::string section;
+  std::string key;
+  std::uint64_t hits;    // lookups that found the key
+  std::uint64_t misses;  // lookups of the key while it did not exist
+};
+
+/// @brief Per-key lookup counts returned by `report_access()`. `get`, `at`, `contains` and `operator[]` are
+///        counted when `INIFILE_ENABLE_ACCESS_COUNTERS` is defined to 1 before including inifile.h, otherwise
+///        the counters are compiled out and reports are empty. Hits are relaxed atomic increments stored next
+///        to the value, misses take a lock. Parsing and `set()` are not counted.
+struct access_report
+{
+  /// @brief Whether lookups are counted (`INIFILE_ENABLE_ACCESS_COUNTERS`)
+  static constexpr bool enabled() noexcept
+  {
+    return INIFILE_ENABLE_ACCESS_COUNTERS != 0;
+  }
+
+  std::vector<key_access> hot;      // up to top-N existing keys with hits, most hits first
+  std::vector<key_access> unused;   // existing keys that were never found by a lookup
+  std::vector<key_access> missing;  // keys looked up but absent (they may have been added since), most misses first
+};
 
 /// @brief ini basic_section class
-template <typename Hash = std::hash<std::string>, typename Equal = std::equal_to<std::string>>
-class basic_section
+/// @tparam Map Associative container template used to store key-value pairs, `std::unordered_map` by default,
+///         `detail::ordered_map` keeps insertion order.
+/// @tparam Allocator Allocator (of any value type, rebound internally) for the key-value container, the
+///         shared section storage and the key, value and comment strings (`key_type` is
+///         `std::basic_string<char, std::char_traits<char>, Allocator rebound to char>`, i.e. `std::string` for
+///         `std::allocator`). Must be default constructible. Lookups also accept other string types, which are
+///         converted with a default constructed allocator. The allocator stays with the object on swap and
+///         assignment.
+/// @tparam CommentPolicy `keep_comments` (default) or `no_comments`, see `basic_inifile`.
+template <typename Hash = std::hash<std::string>, typename Equal = std::equal_to<std::string>,
+          template <typename...> class Map = std::unordered_map, typename Allocator = std::allocator<char>,
+          typename CommentPolicy = keep_comments>
+class basic_section : private detail::allocator_holder<Allocator>
 {
-  using data_container = std::unordered_map<std::string, field, Hash, Equal>;  // 数据容器类型
+  using field = basic_field<CommentPolicy, Allocator>;  // 随注释策略和分配器变化的 field 类型
+  using string_type = detail::string_t<Allocator>;        // 默认分配器下为 std::string
+  using comment_type = typename field::comment_type;
+  using comment_slot = detail::comment_slot<CommentPolicy::enabled, detail::char_allocator_t<Allocator>>;
+  using map_allocator = detail::map_allocator_t<Allocator, string_type, field>;
+  using data_container = Map<string_type, field, detail::key_hash_t<Hash, string_type>,
+                             detail::key_equal_t<Equal, string_type>, map_allocator>;  // 数据容器类型
+  using allocator_traits = std::allocator_traits<Allocator>;
+  template <typename Key>
+  using enable_if_foreign_t = detail::enable_if_foreign_string_t<Key, string_type>;
 
  public:
+  using allocator_type = Allocator;
   using key_type = typename data_container::key_type;
   using mapped_type = typename data_container::mapped_type;
   using value_type = typename data_container::value_type;
@@ -1086,9 +2421,7 @@ class basic_section
   /// @brief 成员swap函数
   void swap(basic_section &other) noexcept
   {
-    using std::swap;
-    swap(data_, other.data_);
-    swap(comments_, other.comments_);
+    impl_.swap(other.impl_);
   }
 
   // 友元 swap函数(非成员函数)
@@ -1099,38 +2432,88 @@ class basic_section
 
   // 默认构造
   basic_section() = default;
+  /// @brief Constructs an empty section whose storage is allocated with `alloc` (nothing is allocated yet).
+  explicit basic_section(const allocator_type &alloc) : detail::allocator_holder<Allocator>(alloc) {}
   // 默认析构函数
   ~basic_section() = default;
-  /// 重写拷贝构造函数, 深拷贝
-  basic_section(const basic_section &other) : data_(other.data_), comments_(other.comments_) {}
-  /// 重写拷贝赋值函数(copy and swap方式)
+  /// 重写拷贝构造函数, 写时复制: 只增加引用计数, 直到其中一方被修改时才真正复制.
+  /// 若 other 曾通过非 const 接口交出过内部引用/迭代器, 则必须立即深拷贝
+  basic_section(const basic_section &other) :
+    detail::allocator_holder<Allocator>(allocator_traits::select_on_container_copy_construction(other.get_allocator())),
+    impl_(other.impl_ && !other.impl_->shareable ? make_impl(other.impl_->data, other.impl_->comments) : other.impl_)
+#if INIFILE_ENABLE_ACCESS_COUNTERS
+    ,
+    misses_(other.misses_)
+#endif
+  {
+  }
+  /// @brief Allocator-extended copy constructor, the storage is shared only if the allocators compare equal.
+  basic_section(const basic_section &other, const allocator_type &alloc) :
+    detail::allocator_holder<Allocator>(alloc),
+    impl_(other.impl_ && (!other.impl_->shareable || !(alloc == other.get_allocator()))
+            ? make_impl(other.impl_->data, other.impl_->comments)
+            : other.impl_)
+#if INIFILE_ENABLE_ACCESS_COUNTERS
+    ,
+    misses_(other.misses_)
+#endif
+  {
+  }
+  /// 重写拷贝赋值函数(copy and swap方式), 保留当前对象的分配器
   basic_section &operator=(const basic_section &rhs)
   {
-    basic_section temp(rhs);  // copy ctor
-    swap(temp);               // noexcept swap
+    basic_section temp(rhs, get_allocator());  // copy ctor
+    swap(temp);                                // noexcept swap
     return *this;
   }
   // 移动构造函数
-  basic_section(basic_section &&other) noexcept : data_(std::move(other.data_)), comments_(std::move(other.comments_))
+  basic_section(basic_section &&other) noexcept :
+    detail::allocator_holder<Allocator>(other.get_allocator()),
+    impl_(std::move(other.impl_))
+#if INIFILE_ENABLE_ACCESS_COUNTERS
+    ,
+    misses_(std::move(other.misses_))
+#endif
   {
-    other.data_.clear();      // 显式清空, 跨平台行为一致
-    other.comments_.clear();  // 显式清空, 跨平台行为一致
+    other.impl_.reset();  // 显式清空, 跨平台行为一致
   }
-  // 移动赋值函数, 默认的不能处理移动自赋值情况
-  basic_section &operator=(basic_section &&rhs) noexcept
+  /// @brief Allocator-extended move constructor, the storage is copied if the allocators differ.
+  basic_section(basic_section &&other, const allocator_type &alloc) :
+    detail::allocator_holder<Allocator>(alloc),
+    impl_(alloc == other.get_allocator() || !other.impl_ ? std::move(other.impl_)
+                                                          : make_impl(other.impl_->data, other.impl_->comments))
+#if INIFILE_ENABLE_ACCESS_COUNTERS
+    ,
+    misses_(std::move(other.misses_))
+#endif
+  {
+    other.impl_.reset();
+  }
+  // 移动赋值函数, 默认的不能处理移动自赋值情况. 保留当前对象的分配器, 分配器不同时复制
+  basic_section &operator=(basic_section &&rhs) noexcept(std::is_empty<Allocator>::value)
   {
-    basic_section temp(std::move(rhs));  // move ctor
-    swap(temp);                          // noexcept swap
+    basic_section temp(std::move(rhs), get_allocator());  // move ctor
+    swap(temp);                                           // noexcept swap
     return *this;
   }
 
   /// @brief Get or insert a field reference. If the key does not exist, insert a default constructed field object
   /// @param key key name
   /// @return Return the field reference corresponding to the key
-  field &operator[](std::string key)
+  field &operator[](key_type key)
   {
     detail::trim(key);
-    return data_[std::move(key)];
+    data_container &data = leak().data;
+    count_access(data, key);
+    return detail::find_or_insert(data, std::move(key));
+  }
+  /// @brief Compatibility overload for other string types when `key_type` is not `std::string`.
+  template <typename Key, typename = enable_if_foreign_t<Key>>
+  field &operator[](const Key &key)
+  {
+    key_type buffer;
+    detail::trimmed(key, buffer);
+    return (*this)[std::move(buffer)];
   }
 
   /// @brief Set key-value pairs
@@ -1139,30 +2522,48 @@ class basic_section
   /// @param value field value
   /// @return Reference to the inserted or updated field
   template <typename T>
-  field &set(std::string key, T &&value)
+  field &set(key_type key, T &&value)
   {
     detail::trim(key);
-    return data_[std::move(key)] = std::forward<T>(value);
+    return detail::find_or_insert(leak().data, std::move(key)) = std::forward<T>(value);
+  }
+  /// @brief Compatibility overload for other string types when `key_type` is not `std::string`.
+  template <typename Key, typename T, typename = enable_if_foreign_t<Key>>
+  field &set(const Key &key, T &&value)
+  {
+    key_type buffer;
+    detail::trimmed(key, buffer);
+    return set(std::move(buffer), std::forward<T>(value));
   }
   /// @brief Set multiple key-value pairs
   /// @param args initializer_list of multiple key-value pairs
   void set(std::initializer_list<std::pair<std::string, field>> args)
   {
+    data_container &data = mutate().data;
     for (auto &&pair : args)
     {
-      std::string key = pair.first;                    // 拷贝 key，准备去除空白
-      detail::trim(key);                               // trim 去除前后空白，避免 key 带空格导致查找异常
-      data_[std::move(key)] = std::move(pair.second);  // 插入键值对
+      key_type key(pair.first.data(), pair.first.size());          // 拷贝 key，准备去除空白
+      detail::trim(key);                                           // trim 去除前后空白，避免 key 带空格导致查找异常
+      detail::find_or_insert(data, std::move(key)) = pair.second;  // 插入键值对
     }
   }
 
   /// @brief key exists
   /// @param key
   /// @return returns true if exists
-  bool contains(std::string key) const
+  bool contains(const key_type &key) const
   {
-    detail::trim(key);
-    return data_.find(key) != data_.end();
+    key_type buffer;
+    const key_type &k = detail::trimmed(key, buffer);
+    count_access(data(), k);
+    return data().find(k) != data().end();
+  }
+  /// @brief Compatibility overload for other string types when `key_type` is not `std::string`.
+  template <typename Key, typename = enable_if_foreign_t<Key>>
+  bool contains(const Key &key) const
+  {
+    key_type buffer;
+    return contains(detail::trimmed(key, buffer));
   }
 
   /// @brief Returns a reference to the field value of the specified key.
@@ -1170,39 +2571,67 @@ class basic_section
   /// @param key key - an exception will be thrown if the key does not exist
   /// @return field value reference
   /// @throws `std::out_of_range` if key does not exist
-  field &at(std::string key)
+  field &at(const key_type &key)
   {
-    detail::trim(key);
-    return data_.at(key);
+    key_type buffer;
+    const key_type &k = detail::trimmed(key, buffer);
+    data_container &data = leak().data;
+    count_access(data, k);
+    return data.at(k);
   }
   // const overloading function
-  const field &at(std::string key) const
+  const field &at(const key_type &key) const
   {
-    detail::trim(key);
-    return data_.at(key);
+    key_type buffer;
+    const key_type &k = detail::trimmed(key, buffer);
+    count_access(data(), k);
+    return data().at(k);
+  }
+  /// @brief Compatibility overloads for other string types when `key_type` is not `std::string`.
+  template <typename Key, typename = enable_if_foreign_t<Key>>
+  field &at(const Key &key)
+  {
+    key_type buffer;
+    return at(detail::trimmed(key, buffer));
+  }
+  template <typename Key, typename = enable_if_foreign_t<Key>>
+  const field &at(const Key &key) const
+  {
+    key_type buffer;
+    return at(detail::trimmed(key, buffer));
   }
 
   /// @brief Get the value corresponding to key. If key does not exist, return default_value.
   /// @param key key
   /// @param default_value default value - return default value when key does not exist
-  /// @return field value (a copy)
-  field get(std::string key, field default_value = field{}) const
-  {
-    detail::trim(key);
-    if (data_.find(key) != data_.end())
+  /// @return field value (a copy, prefer `at()` or `find()` on hot paths to avoid copying the value)
+  field get(const key_type &key, field default_value = field{}) const
+  {
+    key_type buffer;
+    const key_type &k = detail::trimmed(key, buffer);
+    count_access(data(), k);
+    auto it = data().find(k);
+    if (it != data().end())
     {
-      return data_.at(key);
+      return it->second;
     }
     return default_value;
   }
+  /// @brief Compatibility overload for other string types when `key_type` is not `std::string`.
+  template <typename Key, typename = enable_if_foreign_t<Key>>
+  field get(const Key &key, field default_value = field{}) const
+  {
+    key_type buffer;
+    return get(detail::trimmed(key, buffer), std::move(default_value));
+  }
 
   /// @brief Get all keys in the section.
   /// @return A vector containing all keys.
   std::vector<key_type> keys() const
   {
     std::vector<key_type> result;
-    result.reserve(data_.size());
-    for (const auto &pair : data_)
+    result.reserve(data().size());
+    for (const auto &pair : data())
     {
       result.emplace_back(pair.first);
     }
@@ -1214,8 +2643,8 @@ class basic_section
   std::vector<mapped_type> values() const
   {
     std::vector<mapped_type> result;
-    result.reserve(data_.size());
-    for (const auto &pair : data_)
+    result.reserve(data().size());
+    for (const auto &pair : data())
     {
       result.emplace_back(pair.second);
     }
@@ -1226,178 +2655,537 @@ class basic_section
   /// @return A vector containing all key-value pairs, each pair is a `std::pair<std::string, ini::field>`.
   std::vector<value_type> items() const
   {
-    return {data_.begin(), data_.end()};
+    return {data().begin(), data().end()};
   }
 
   /// @brief Remove the specified key-value pairs
   /// @param key key
   /// @return Return true if the deletion is successful, return false if it is not found
-  bool remove(std::string key)
+  bool remove(key_type key)
   {
     detail::trim(key);
-    return data_.erase(key) != 0;
+    return mutate().data.erase(key) != 0;
+  }
+  /// @brief Compatibility overload for other string types when `key_type` is not `std::string`.
+  template <typename Key, typename = enable_if_foreign_t<Key>>
+  bool remove(const Key &key)
+  {
+    key_type buffer;
+    return mutate().data.erase(detail::trimmed(key, buffer)) != 0;
   }
 
   /// @brief Clear all key-value pairs
   void clear() noexcept
   {
-    data_.clear();
+    if (!impl_) return;
+    if (impl_.use_count() == 1)
+    {
+      impl_->data.clear();
+      impl_->invalidate_fingerprint();
+      return;
+    }
+    auto fresh = make_impl();  // 不复制即将被清空的键值对
+    fresh->comments = impl_->comments;
+    impl_ = std::move(fresh);
   }
 
   size_type size() const noexcept
   {
-    return data_.size();
+    return data().size();
   }
 
   bool empty() const noexcept
   {
-    return data_.empty();
+    return data().empty();
   }
 
-  iterator find(key_type key)
+  iterator find(const key_type &key)
   {
-    detail::trim(key);
-    return data_.find(key);
+    key_type buffer;
+    return leak().data.find(detail::trimmed(key, buffer));
   }
-  const_iterator find(key_type key) const
+  const_iterator find(const key_type &key) const
   {
-    detail::trim(key);
-    return data_.find(key);
+    key_type buffer;
+    return data().find(detail::trimmed(key, buffer));
+  }
+  /// @brief Compatibility overloads for other string types when `key_type` is not `std::string`.
+  template <typename Key, typename = enable_if_foreign_t<Key>>
+  iterator find(const Key &key)
+  {
+    key_type buffer;
+    return leak().data.find(detail::trimmed(key, buffer));
+  }
+  template <typename Key, typename = enable_if_foreign_t<Key>>
+  const_iterator find(const Key &key) const
+  {
+    key_type buffer;
+    return data().find(detail::trimmed(key, buffer));
   }
 
-  size_type count(key_type key) const
+  size_type count(const key_type &key) const
   {
-    detail::trim(key);
-    return data_.count(key);
+    key_type buffer;
+    return data().count(detail::trimmed(key, buffer));
+  }
+  template <typename Key, typename = enable_if_foreign_t<Key>>
+  size_type count(const Key &key) const
+  {
+    key_type buffer;
+    return data().count(detail::trimmed(key, buffer));
+  }
+
+  /// @brief Reserve space for at least `n` key-value pairs, so that inserting them does not rehash.
+  void reserve(size_type n)
+  {
+    mutate().data.reserve(n);
   }
 
   iterator erase(iterator pos)
   {
-    return data_.erase(pos);
+    return leak().data.erase(pos);  // 非 const 迭代器只能来自已独占的数据
   }
   iterator erase(const_iterator pos)
   {
-    return data_.erase(pos);
+    return erase(pos, std::next(pos));
   }
   iterator erase(const_iterator first, const_iterator last)
   {
-    return data_.erase(first, last);
+    if (!impl_ || impl_.use_count() == 1) return leak().data.erase(first, last);
+    // 迭代器指向共享的数据: 先复制一份, 再按 key 删除
+    const std::shared_ptr<impl> shared = impl_;  // 保证 first/last 在复制期间有效
+    std::vector<key_type> keys;
+    for (auto it = first; it != last; ++it) keys.push_back(it->first);
+    data_container &data = leak().data;
+    for (const auto &key : keys) data.erase(key);
+    return last == shared->data.end() ? data.end() : data.find(last->first);
   }
   size_type erase(key_type key)
   {
     detail::trim(key);
-    return data_.erase(key);
+    return mutate().data.erase(key);
+  }
+  template <typename Key, typename = enable_if_foreign_t<Key>>
+  size_type erase(const Key &key)
+  {
+    key_type buffer;
+    return mutate().data.erase(detail::trimmed(key, buffer));
   }
 
-  iterator begin() noexcept
+  iterator begin()
   {
-    return data_.begin();
+    return leak().data.begin();
   }
   const_iterator begin() const noexcept
   {
-    return data_.begin();
+    return data().begin();
+  }
+
+  iterator end()
+  {
+    return leak().data.end();
+  }
+  const_iterator end() const noexcept
+  {
+    return data().end();
+  }
+
+  const_iterator cbegin() const noexcept
+  {
+    return data().cbegin();
+  }
+  const_iterator cend() const noexcept
+  {
+    return data().cend();
+  }
+
+  /// @brief Get the allocator used for the key-value container, the section storage and the strings.
+  allocator_type get_allocator() const noexcept
+  {
+    return this->stored_allocator();
+  }
+
+  /// @brief Set `[section]` comment, overwriting the original comment.
+  /// @param str Comment content, Multi-line comments are allowed, lines separated by `\n`.
+  /// @param symbol Comment symbol, default is `;`, Only `;` and `#` are supported.
+  void set_comment(const std::string &str, char symbol = ';')
+  {
+    if (comment_type *c = writable_comment()) c->set(str, symbol);
+  }
+  /// @brief Overwrite the current comment with another comment (copy).
+  void set_comment(const comment_type &other)
+  {
+    if (comment_type *c = writable_comment()) c->set(other);
+  }
+  /// @brief Overwrite the current comment with a comment using another allocator (copy).
+  template <typename OtherAllocator>
+  void set_comment(const basic_comment<OtherAllocator> &other)
+  {
+    if (comment_type *c = writable_comment()) c->set(other);
+  }
+  /// @brief Overwrite the current comment with another comment (move).
+  void set_comment(comment_type &&other) noexcept(std::is_empty<Allocator>::value)
+  {
+    if (comment_type *c = writable_comment()) c->set(std::move(other));
+  }
+  /// @brief Set the comment from an initializer list of strings.
+  /// @param list List of comment lines.
+  /// @param symbol Comment symbol, default is `;`. Only `;` and `#` are supported.
+  void set_comment(std::initializer_list<std::string> list, char symbol = ';')
+  {
+    if (comment_type *c = writable_comment()) c->set(list, symbol);
+  }
+
+  /// @brief Add `[section]` comments and then append them.
+  /// @param str Comment content, Multi-line comments are allowed, lines separated by `\n`.
+  /// @param symbol Comment symbol, default is `;`, Only `;` and `#` are supported.
+  void add_comment(const std::string &str, char symbol = ';')
+  {
+    if (comment_type *c = writable_comment()) c->add(str, symbol);
+  }
+  /// @brief Append comments from another comment object (copy).
+  void add_comment(const comment_type &other)
+  {
+    if (comment_type *c = writable_comment()) c->add(other);
+  }
+  /// @brief Append comments from a comment object using another allocator (copy).
+  template <typename OtherAllocator>
+  void add_comment(const basic_comment<OtherAllocator> &other)
+  {
+    if (comment_type *c = writable_comment()) c->add(other);
+  }
+  /// @brief Append comments from another comment object (move).
+  void add_comment(comment_type &&other) noexcept
+  {
+    if (comment_type *c = writable_comment()) c->add(std::move(other));
+  }
+  /// @brief Append comments from an initializer list of strings.
+  /// @param list List of comment lines.
+  /// @param symbol Comment symbol, default is `;`. Only `;` and `#` are supported.
+  void add_comment(std::initializer_list<std::string> list, char symbol = ';')
+  {
+    if (comment_type *c = writable_comment()) c->add(list, symbol);
+  }
+
+  /// @brief Get a const reference to the comment associated with this field.
+  /// @return Const reference to the internal `comment` object.
+  const comment_type &comment() const
+  {
+    return impl_ ? impl_->comments.stored_comment() : empty_impl().comments.stored_comment();
+  }
+  /// @brief Get a mutable reference to the comment associated with this field.
+  /// @return Reference to the internal `comment` object.
+  comment_type &comment()
+  {
+    static_assert(CommentPolicy::enabled, "comments are not stored under the no_comments policy");
+    return *leak().comments.writable_comment();
+  }
+
+  /// @brief Clear `[section]` comment
+  void clear_comment()
+  {
+    if (!impl_) return;
+    if (comment_type *c = writable_comment()) c->clear();
+  }
+
+  /// @brief Compute a 64-bit fingerprint of all key-value pairs and the section comment.
+  ///        The result does not depend on the iteration order of the underlying container.
+  ///        It is cached in the shared storage until the next modification, so copies of an unmodified
+  ///        section (e.g. a baseline) compute it only once.
+  /// @return Fingerprint, sections with the same content always produce equal fingerprints.
+  std::uint64_t fingerprint() const noexcept
+  {
+    // 交出过可变引用的数据可能在外部被修改, 不使用缓存
+    const bool cacheable = impl_ && impl_->shareable;
+    if (cacheable && impl_->fingerprint_valid.load(std::memory_order_acquire))
+    {
+      return impl_->fingerprint.load(std::memory_order_relaxed);
+    }
+    const std::uint64_t h = compute_fingerprint();
+    if (cacheable)
+    {
+      impl_->fingerprint.store(h, std::memory_order_relaxed);
+      impl_->fingerprint_valid.store(true, std::memory_order_release);
+    }
+    return h;
+  }
+
+  /// @brief Whether the two sections currently share the same copy-on-write storage,
+  ///        in which case their content is identical.
+  bool shares_storage_with(const basic_section &other) const noexcept
+  {
+    return impl_ == other.impl_;
+  }
+
+  /// @brief Report lookup counts of this section (see `access_report`), `section` of the entries is empty.
+  /// @param top_n Maximum number of entries in `hot`
+  ini::access_report report_access(std::size_t top_n = 10) const
+  {
+    ini::access_report report;
+    collect_access(string_type(), report);
+    finish_report(report, top_n);
+    return report;
+  }
+
+  /// @brief Reset the lookup counts of this section.
+  void reset_access_counts() const
+  {
+#if INIFILE_ENABLE_ACCESS_COUNTERS
+    for (const auto &kv : data()) kv.second.hits_.reset();
+    misses_.reset();
+#endif
+  }
+
+ private:
+  /// @brief 统计一次 key 查找(未启用 INIFILE_ENABLE_ACCESS_COUNTERS 时为空操作, 不产生额外的查找)
+  void count_access(const data_container &data, const key_type &key) const
+  {
+#if INIFILE_ENABLE_ACCESS_COUNTERS
+    auto it = data.find(key);
+    if (it != data.end())
+      it->second.hits_.increment();
+    else
+      misses_.add(detail::to_std_string(key));
+#else
+    (void)data;
+    (void)key;
+#endif
   }
 
-  iterator end() noexcept
+  /// @brief 将本 section 的计数追加到 report 中(尚未排序)
+  void collect_access(const key_type &name, ini::access_report &report) const
   {
-    return data_.end();
+#if INIFILE_ENABLE_ACCESS_COUNTERS
+    const auto misses = misses_.snapshot();
+    for (const auto &kv : data())
+    {
+      key_access entry{detail::to_std_string(name), detail::to_std_string(kv.first), kv.second.hits_.load(), 0};
+      auto miss_it = misses.find(entry.key);
+      if (miss_it != misses.end()) entry.misses = miss_it->second;
+      (entry.hits != 0 ? report.hot : report.unused).push_back(std::move(entry));
+    }
+    for (const auto &miss : misses)
+    {
+      if (!contains_key(miss.first))
+      {
+        report.missing.push_back(key_access{detail::to_std_string(name), miss.first, 0, miss.second});
+      }
+    }
+#else
+    (void)name;
+    (void)report;
+#endif
   }
-  const_iterator end() const noexcept
+
+  /// @brief 排序并截取 hot 的前 top_n 项, 计数相同时按 section/key 排序, 结果确定
+  static void finish_report(ini::access_report &report, std::size_t top_n)
   {
-    return data_.end();
+    auto by_name = [](const key_access &a, const key_access &b) {
+      return a.section != b.section ? a.section < b.section : a.key < b.key;
+    };
+    std::sort(report.hot.begin(), report.hot.end(), [&by_name](const key_access &a, const key_access &b) {
+      return a.hits != b.hits ? a.hits > b.hits : by_name(a, b);
+    });
+    if (report.hot.size() > top_n) report.hot.resize(top_n);
+    std::sort(report.unused.begin(), report.unused.end(), by_name);
+    std::sort(report.missing.begin(), report.missing.end(), [&by_name](const key_access &a, const key_access &b) {
+      return a.misses != b.misses ? a.misses > b.misses : by_name(a, b);
+    });
   }
 
-  const_iterator cbegin() const noexcept
+  /// @brief 不计入访问计数的存在性检查, 接受 std::string(访问计数中记录的 key)
+  bool contains_key(const std::string &key) const
   {
-    return data_.cbegin();
+    key_type buffer;
+    return data().find(detail::trimmed(key, buffer)) != data().end();
   }
-  const_iterator cend() const noexcept
+
+  std::uint64_t compute_fingerprint() const noexcept
   {
-    return data_.cend();
+    std::uint64_t h = 0;
+    for (const auto &line : comment()) h = detail::hash_append(h, line);
+    std::uint64_t entries = 0;  // 使用加法组合, 与迭代顺序无关
+    for (const auto &kv : data())
+    {
+      entries += detail::mix64(detail::hash_append(kv.second.fingerprint(), kv.first));
+    }
+    return detail::mix64(h ^ entries);
   }
 
-  /// @brief Set `[section]` comment, overwriting the original comment.
-  /// @param str Comment content, Multi-line comments are allowed, lines separated by `\n`.
-  /// @param symbol Comment symbol, default is `;`, Only `;` and `#` are supported.
-  void set_comment(const std::string &str, char symbol = ';')
+  template <typename, typename, template <typename...> class, typename, typename>
+  friend class basic_inifile;
+
+  /// @brief 共享存储, 多个 section 副本在被修改之前共享同一份数据
+  struct impl
   {
-    comments_.set(str, symbol);
-  }
-  /// @brief Overwrite the current comment with another comment (copy).
-  void set_comment(const comment &other)
+    impl() = default;
+    explicit impl(const map_allocator &alloc) :
+      data(0, typename data_container::hasher(), typename data_container::key_equal(), alloc),
+      comments(detail::char_allocator_t<Allocator>(alloc))
+    {
+    }
+    impl(const data_container &d, const comment_slot &c, const map_allocator &alloc) :
+      data(copy_data(d, alloc)),
+      comments(c, detail::char_allocator_t<Allocator>(alloc))
+    {
+    }
+
+    /// @brief 数据被修改, 缓存的指纹失效
+    void invalidate_fingerprint() noexcept
+    {
+      fingerprint_valid.store(false, std::memory_order_relaxed);
+    }
+
+    data_container data;     // key-value pairs
+    comment_slot comments;   // section-level comments, empty under the no_comments policy
+    bool shareable = true;   // 交出过可变引用/迭代器后为 false, 拷贝时必须深拷贝
+    mutable std::atomic<std::uint64_t> fingerprint{0};  // fingerprint() 的缓存, 共享的副本在多个线程中只读访问
+    mutable std::atomic<bool> fingerprint_valid{false};
+  };
+
+  /// @brief 使用 section 的分配器创建共享存储(对象与引用计数一次分配)
+  template <typename... Args>
+  std::shared_ptr<impl> make_impl(const Args &...args) const
   {
-    comments_.set(other);
+    const Allocator alloc = get_allocator();
+    return std::allocate_shared<impl>(alloc, args..., map_allocator(alloc));
   }
-  /// @brief Overwrite the current comment with another comment (move).
-  void set_comment(comment &&other) noexcept
+
+  /// @brief 使用 alloc 复制键值对. 有状态的分配器需要逐个复制, 容器的拷贝不会把分配器传给 key 和 field 的字符串
+  static data_container copy_data(const data_container &d, const map_allocator &alloc)
   {
-    comments_.set(std::move(other));
+    if (std::is_empty<Allocator>::value) return data_container(d, alloc);
+    data_container data(0, typename data_container::hasher(), typename data_container::key_equal(), alloc);
+    data.reserve(d.size());
+    const detail::char_allocator_t<Allocator> a(alloc);
+    for (const auto &kv : d) data.emplace(key_type(kv.first, a), field(kv.second, a));
+    return data;
   }
-  /// @brief Set the comment from an initializer list of strings.
-  /// @param list List of comment lines.
-  /// @param symbol Comment symbol, default is `;`. Only `;` and `#` are supported.
-  void set_comment(std::initializer_list<std::string> list, char symbol = ';')
+
+  static const impl &empty_impl()
   {
-    comments_.set(list, symbol);
+    static const impl empty;
+    return empty;
   }
 
-  /// @brief Add `[section]` comments and then append them.
-  /// @param str Comment content, Multi-line comments are allowed, lines separated by `\n`.
-  /// @param symbol Comment symbol, default is `;`, Only `;` and `#` are supported.
-  void add_comment(const std::string &str, char symbol = ';')
+  const data_container &data() const noexcept
   {
-    comments_.add(str, symbol);
+    return impl_ ? impl_->data : empty_impl().data;
   }
-  /// @brief Append comments from another comment object (copy).
-  void add_comment(const comment &other)
+
+  /// @brief 获取独占的可写数据(写时复制), 不会交出引用
+  impl &mutate()
   {
-    comments_.add(other);
+    if (!impl_)
+    {
+      impl_ = make_impl();
+    }
+    else if (impl_.use_count() != 1)
+    {
+      impl_ = make_impl(impl_->data, impl_->comments);
+    }
+    else
+    {
+      // 与其他线程中最后一个副本的析构同步, 之后才能原地修改
+      std::atomic_thread_fence(std::memory_order_acquire);
+      impl_->invalidate_fingerprint();
+    }
+    return *impl_;
   }
-  /// @brief Append comments from another comment object (move).
-  void add_comment(comment &&other) noexcept
+
+  /// @brief 获取独占的可写数据, 并标记为不可共享(调用者会持有内部引用或迭代器)
+  impl &leak()
   {
-    comments_.add(std::move(other));
+    impl &i = mutate();
+    i.shareable = false;
+    return i;
   }
-  /// @brief Append comments from an initializer list of strings.
-  /// @param list List of comment lines.
-  /// @param symbol Comment symbol, default is `;`. Only `;` and `#` are supported.
-  void add_comment(std::initializer_list<std::string> list, char symbol = ';')
+
+  /// @brief 可写的 section 注释(写时复制), 禁用注释时返回 nullptr 且不触发复制
+  comment_type *writable_comment()
   {
-    comments_.add(list, symbol);
+    return CommentPolicy::enabled ? mutate().comments.writable_comment() : nullptr;
   }
 
-  /// @brief Get a const reference to the comment associated with this field.
-  /// @return Const reference to the internal `comment` object.
-  const ini::comment &comment() const
+  /// @brief 内部代码(例如解析)不再持有引用时调用, 允许之后的拷贝共享数据
+  void share() noexcept
   {
-    return comments_;
+    if (impl_) impl_->shareable = true;
   }
-  /// @brief Get a mutable reference to the comment associated with this field.
-  /// @return Reference to the internal `comment` object.
-  ini::comment &comment()
+
+  std::shared_ptr<impl> impl_;  // nullptr 表示空 section
+#if INIFILE_ENABLE_ACCESS_COUNTERS
+  detail::miss_table<std::string> misses_;  // 不存在的 key 的查找次数, 与 field 的计数一样不参与 swap
+#endif
+};
+
+/// @brief Statistics filled by the `read()`, `load()`, `write()` and `save()` overloads taking a `stats &`.
+///        Collected only when `INIFILE_ENABLE_STATS` is defined to 1 before including inifile.h, otherwise the
+///        instrumentation is compiled out and those overloads leave the object untouched. Counters accumulate
+///        over calls until `reset()`.
+/// - `estimated_allocations`/`estimated_allocated_bytes` are not measured heap usage: `read()` derives them from
+///   its own containers (map nodes, bucket arrays, section storage, long keys/values) using `sizeof`, and
+///   allocations inside the standard library or the stream are not observed. `write()` does not update them.
+/// - `write()` streams directly into the ostream, formatting and writing interleave and are both timed as
+///   `io_time` (`scan_time` is not updated by `write()`).
+/// - Rehashes are detected through `bucket_count()`, containers without it (`detail::ordered_map`) report none.
+struct stats
+{
+  /// @brief Whether statistics are collected (`INIFILE_ENABLE_STATS`)
+  static constexpr bool enabled() noexcept
   {
-    return comments_;
+    return INIFILE_ENABLE_STATS != 0;
   }
 
-  /// @brief Clear `[section]` comment
-  void clear_comment()
+  std::uint64_t bytes = 0;                      // bytes read or written
+  std::uint64_t lines = 0;                      // lines read or written, including blank and comment lines
+  std::uint64_t sections = 0;                   // sections created by read() / written by write()
+  std::uint64_t keys = 0;                       // key=value lines
+  std::uint64_t comment_lines = 0;              // comment lines
+  std::uint64_t estimated_allocations = 0;      // estimated (not measured) number of heap allocations, read only
+  std::uint64_t estimated_allocated_bytes = 0;  // estimated (not measured) bytes allocated, read only
+  std::uint64_t rehashes = 0;                   // bucket array growths of the section and key maps
+  std::chrono::nanoseconds io_time{0};          // reading/writing the stream (and opening the file)
+  std::chrono::nanoseconds scan_time{0};        // trimming and splitting lines (read only)
+  std::chrono::nanoseconds insert_time{0};      // map lookups and insertions (read only)
+
+  void reset() noexcept
   {
-    comments_.clear();
+    *this = stats();
   }
-
- private:
-  data_container data_;    // key-value pairs
-  ini::comment comments_;  // section-level comments
 };
 
 /// @brief ini file class
-template <typename Hash = std::hash<std::string>, typename Equal = std::equal_to<std::string>>
+/// @tparam Map Associative container template used to store sections and key-value pairs,
+///         `std::unordered_map` by default, `detail::ordered_map` keeps insertion order.
+/// @tparam Allocator Allocator (of any value type, rebound internally) for the section container and the section
+///         names, handed down to every section (see `basic_section`), so keys, values and comments use it too.
+///         Must be default constructible. `swap()` requires equal allocators unless the allocator propagates on
+///         swap, as for standard containers.
+/// @tparam CommentPolicy `keep_comments` (default) keeps `[section]` and `key=value` comments. `no_comments`
+///         drops them: fields and sections carry no comment storage, comment lines are skipped while parsing
+///         and the comment setters do nothing. `write()` then emits no comments.
+template <typename Hash = std::hash<std::string>, typename Equal = std::equal_to<std::string>,
+          template <typename...> class Map = std::unordered_map, typename Allocator = std::allocator<char>,
+          typename CommentPolicy = keep_comments>
 class basic_inifile
 {
-  using section = basic_section<Hash, Equal>;  // 在 basic_inifile 内部定义 section 别名
-  using data_container = std::unordered_map<std::string, section, Hash, Equal>;  // 数据容器类型
+  using field = basic_field<CommentPolicy, Allocator>;  // 随注释策略和分配器变化的 field 类型
+  using section = basic_section<Hash, Equal, Map, Allocator, CommentPolicy>;  // 在 basic_inifile 内部定义 section 别名
+  using string_type = detail::string_t<Allocator>;                            // 默认分配器下为 std::string
+  using comment_type = typename field::comment_type;
+  using map_allocator = detail::map_allocator_t<Allocator, string_type, section>;
+  using data_container = Map<string_type, section, detail::key_hash_t<Hash, string_type>,
+                             detail::key_equal_t<Equal, string_type>, map_allocator>;  // 数据容器类型
+  using hasher = typename data_container::hasher;
+  using key_equal = typename data_container::key_equal;
+  template <typename Key>
+  using enable_if_foreign_t = detail::enable_if_foreign_string_t<Key, string_type>;
+  template <typename Sec, typename Key>
+  using enable_if_foreign_pair_t = detail::enable_if_foreign_strings_t<Sec, Key, string_type>;
 
  public:
+  using allocator_type = Allocator;
   using key_type = typename data_container::key_type;
   using mapped_type = typename data_container::mapped_type;
   using value_type = typename data_container::value_type;
@@ -1420,6 +3208,8 @@ class basic_inifile
 
   // 构造函数
   basic_inifile() = default;
+  /// @brief Constructs an empty inifile whose sections are allocated with `alloc`.
+  explicit basic_inifile(const allocator_type &alloc) : data_(0, hasher(), key_equal(), map_allocator(alloc)) {}
   // 析构函数
   ~basic_inifile() = default;
 
@@ -1429,25 +3219,67 @@ class basic_inifile
   basic_inifile &operator=(const basic_inifile &rhs) = default;
 
   // 移动构造
-  basic_inifile(basic_inifile &&other) noexcept : data_(std::move(other.data_))
+  basic_inifile(basic_inifile &&other) noexcept :
+    data_(std::move(other.data_))
+#if INIFILE_ENABLE_ACCESS_COUNTERS
+    ,
+    misses_(std::move(other.misses_))
+#endif
   {
     other.data_.clear();  // 显式清空, 跨平台行为一致
   };
-  // 移动赋值 (move and swap)
-  basic_inifile &operator=(basic_inifile &&rhs) noexcept
+  // 移动赋值 (move and swap), 分配器不相等时逐个移动元素
+  basic_inifile &operator=(basic_inifile &&rhs) noexcept(std::is_empty<Allocator>::value)
   {
-    basic_inifile temp(std::move(rhs));  // move ctor
-    swap(temp);                          // noexcept swap
+    if (std::is_empty<Allocator>::value || get_allocator() == rhs.get_allocator())
+    {
+      basic_inifile temp(std::move(rhs));  // move ctor
+      swap(temp);                          // noexcept swap
+    }
+    else if (this != &rhs)
+    {
+      data_ = move_data(std::move(rhs.data_), data_.get_allocator());
+      rhs.data_.clear();
+    }
     return *this;
   };
 
+  /// @brief Allocator-extended copy constructor.
+  basic_inifile(const basic_inifile &other, const allocator_type &alloc) :
+    data_(copy_data(other.data_, map_allocator(alloc)))
+  {
+  }
+  /// @brief Allocator-extended move constructor, the sections are copied if the allocators differ.
+  basic_inifile(basic_inifile &&other, const allocator_type &alloc) : data_(0, hasher(), key_equal(), map_allocator(alloc))
+  {
+    if (alloc == other.get_allocator())
+      data_.swap(other.data_);
+    else
+      data_ = move_data(std::move(other.data_), data_.get_allocator());
+    other.data_.clear();
+  }
+
+  /// @brief Get the allocator used for the section container and handed down to the sections.
+  allocator_type get_allocator() const noexcept
+  {
+    return allocator_type(data_.get_allocator());
+  }
+
   /// @brief Get or insert a field. If section_name does not exist, insert a default constructed section object
   /// @param sec section name
   /// @return Returns the section reference corresponding to the key
-  section &operator[](std::string sec)
+  section &operator[](key_type sec)
   {
     detail::trim(sec);
-    return data_[std::move(sec)];
+    return section_at(data_, std::move(sec));
+  }
+  /// @brief Compatibility overload for other string types when `key_type` is not `std::string`.
+  template <typename Sec, typename = enable_if_foreign_t<Sec>>
+  section &operator[](const Sec &sec)
+  {
+    key_type buffer;
+    detail::trimmed(sec, buffer);
+    return section_at(data_, std::move(buffer));
   }
 
   /// @brief Set section key-value
@@ -1457,72 +3289,115 @@ class basic_inifile
   /// @param value Field value
   /// @return Reference to the inserted or updated field
   template <typename T>
-  field &set(std::string sec, std::string key, T &&value)
+  field &set(key_type sec, key_type key, T &&value)
   {
     detail::trim(sec);
     detail::trim(key);
-    return data_[std::move(sec)][std::move(key)] = std::forward<T>(value);
+    return section_at(data_, std::move(sec))[std::move(key)] = std::forward<T>(value);
+  }
+  /// @brief Compatibility overload for other string types when `key_type` is not `std::string`.
+  template <typename Sec, typename Key, typename T, typename = enable_if_foreign_pair_t<Sec, Key>>
+  field &set(const Sec &sec, const Key &key, T &&value)
+  {
+    key_type sec_buffer, key_buffer;
+    return set(key_type(detail::trimmed(sec, sec_buffer)), key_type(detail::trimmed(key, key_buffer)),
+               std::forward<T>(value));
   }
 
   /// @brief Check if the specified section exists
   /// @param sec section name
   /// @return Return true if it exists, otherwise return false
-  bool contains(std::string sec) const
+  bool contains(const key_type &sec) const
   {
-    detail::trim(sec);
-    return data_.find(sec) != data_.end();
+    key_type buffer;
+    return data_.find(detail::trimmed(sec, buffer)) != data_.end();
+  }
+  /// @brief Compatibility overload for other string types when `key_type` is not `std::string`.
+  template <typename Sec, typename = enable_if_foreign_t<Sec>>
+  bool contains(const Sec &sec) const
+  {
+    key_type buffer;
+    return data_.find(detail::trimmed(sec, buffer)) != data_.end();
   }
 
   /// @brief Check if the specified key exists in the specified section
   /// @param sec section name
   /// @param key key
   /// @return Return true if it exists, otherwise return false
-  bool contains(std::string sec, std::string key) const
+  bool contains(const key_type &sec, const key_type &key) const
   {
-    detail::trim(sec);
-    auto sec_it = data_.find(sec);
+    key_type buffer;
+    const key_type &s = detail::trimmed(sec, buffer);
+    auto sec_it = data_.find(s);
     if (sec_it != data_.end())
     {
-      return sec_it->second.contains(std::move(key));
+      return sec_it->second.contains(key);
     }
+    count_missing_section(s, key);
     return false;
   }
+  /// @brief Compatibility overload for other string types when `key_type` is not `std::string`.
+  template <typename Sec, typename Key, typename = enable_if_foreign_pair_t<Sec, Key>>
+  bool contains(const Sec &sec, const Key &key) const
+  {
+    key_type sec_buffer, key_buffer;
+    return contains(detail::trimmed(sec, sec_buffer), detail::trimmed(key, key_buffer));
+  }
 
   /// @brief Returns a reference to the specified section.
   ///        If section does not exist, an exception of type `std::out_of_range` will be thrown.
   /// @param sec section-name - an exception will be thrown if the section does not exist
   /// @return section reference
   /// @throws `std::out_of_range` if section does not exist
-  section &at(std::string sec)
+  section &at(const key_type &sec)
   {
-    detail::trim(sec);
-    return data_.at(sec);
+    key_type buffer;
+    return data_.at(detail::trimmed(sec, buffer));
   }
   // const overloading function
-  const section &at(std::string sec) const
+  const section &at(const key_type &sec) const
   {
-    detail::trim(sec);
-    return data_.at(sec);
+    key_type buffer;
+    return data_.at(detail::trimmed(sec, buffer));
+  }
+  /// @brief Compatibility overloads for other string types when `key_type` is not `std::string`.
+  template <typename Sec, typename = enable_if_foreign_t<Sec>>
+  section &at(const Sec &sec)
+  {
+    key_type buffer;
+    return data_.at(detail::trimmed(sec, buffer));
+  }
+  template <typename Sec, typename = enable_if_foreign_t<Sec>>
+  const section &at(const Sec &sec) const
+  {
+    key_type buffer;
+    return data_.at(detail::trimmed(sec, buffer));
   }
 
   /// @brief Returns the field value of the specified section and the specified key
   /// @param sec section name
   /// @param key key
   /// @param default_value default value - the default value will be returned if the key does not exist
-  /// @return field value(a copy)
-  field get(std::string sec, std::string key, field default_value = field{}) const
+  /// @return field value(a copy, prefer `at()` or `find()` on hot paths to avoid copying the value)
+  field get(const key_type &sec, const key_type &key, field default_value = field{}) const
   {
-    detail::trim(sec);
-    auto sec_it = data_.find(sec);
+    key_type buffer;
+    const key_type &s = detail::trimmed(sec, buffer);
+    auto sec_it = data_.find(s);
     if (sec_it != data_.end())
     {
-      if (sec_it->second.contains(key))
-      {
-        return sec_it->second.at(std::move(key));
-      }
+      return sec_it->second.get(key, std::move(default_value));
     }
+    count_missing_section(s, key);
     return default_value;
   }
+  /// @brief Compatibility overload for other string types when `key_type` is not `std::string`.
+  template <typename Sec, typename Key, typename = enable_if_foreign_pair_t<Sec, Key>>
+  field get(const Sec &sec, const Key &key, field default_value = field{}) const
+  {
+    key_type sec_buffer, key_buffer;
+    return get(detail::trimmed(sec, sec_buffer), detail::trimmed(key, key_buffer), std::move(default_value));
+  }
 
   /// @brief Get all section names in the INI file.
   /// @return A vector containing all section names.
@@ -1540,11 +3415,18 @@ class basic_inifile
   /// @brief Remove the specified seciton
   /// @param sec section-name
   /// @return Return true if the deletion is successful, return false if it is not found
-  bool remove(std::string sec)
+  bool remove(key_type sec)
   {
     detail::trim(sec);
     return data_.erase(sec) != 0;
   }
+  /// @brief Compatibility overload for other string types when `key_type` is not `std::string`.
+  template <typename Sec, typename = enable_if_foreign_t<Sec>>
+  bool remove(const Sec &sec)
+  {
+    key_type buffer;
+    return data_.erase(detail::trimmed(sec, buffer)) != 0;
+  }
 
   void clear() noexcept
   {
@@ -1553,108 +3435,668 @@ class basic_inifile
 
   size_type size() const noexcept
   {
-    return data_.size();
+    return data_.size();
+  }
+
+  bool empty() const noexcept
+  {
+    return data_.empty();
+  }
+
+  iterator find(const key_type &key)
+  {
+    key_type buffer;
+    return data_.find(detail::trimmed(key, buffer));
+  }
+  const_iterator find(const key_type &key) const
+  {
+    key_type buffer;
+    return data_.find(detail::trimmed(key, buffer));
+  }
+  /// @brief Compatibility overloads for other string types when `key_type` is not `std::string`.
+  template <typename Key, typename = enable_if_foreign_t<Key>>
+  iterator find(const Key &key)
+  {
+    key_type buffer;
+    return data_.find(detail::trimmed(key, buffer));
+  }
+  template <typename Key, typename = enable_if_foreign_t<Key>>
+  const_iterator find(const Key &key) const
+  {
+    key_type buffer;
+    return data_.find(detail::trimmed(key, buffer));
+  }
+
+  size_type count(const key_type &key) const
+  {
+    key_type buffer;
+    return data_.count(detail::trimmed(key, buffer));
+  }
+  template <typename Key, typename = enable_if_foreign_t<Key>>
+  size_type count(const Key &key) const
+  {
+    key_type buffer;
+    return data_.count(detail::trimmed(key, buffer));
+  }
+
+  /// @brief Reserve space for at least `n` sections, so that inserting them does not rehash.
+  void reserve(size_type n)
+  {
+    data_.reserve(n);
+  }
+
+  iterator erase(iterator pos)
+  {
+    return data_.erase(pos);
+  }
+  iterator erase(const_iterator pos)
+  {
+    return data_.erase(pos);
+  }
+  iterator erase(const_iterator first, const_iterator last)
+  {
+    return data_.erase(first, last);
+  }
+  size_type erase(key_type key)
+  {
+    detail::trim(key);
+    return data_.erase(key);
+  }
+  template <typename Key, typename = enable_if_foreign_t<Key>>
+  size_type erase(const Key &key)
+  {
+    key_type buffer;
+    return data_.erase(detail::trimmed(key, buffer));
+  }
+
+  iterator begin() noexcept
+  {
+    return data_.begin();
+  }
+  const_iterator begin() const noexcept
+  {
+    return data_.begin();
+  }
+
+  iterator end() noexcept
+  {
+    return data_.end();
+  }
+  const_iterator end() const noexcept
+  {
+    return data_.end();
+  }
+
+  const_iterator cbegin() const noexcept
+  {
+    return data_.cbegin();
+  }
+  const_iterator cend() const noexcept
+  {
+    return data_.cend();
+  }
+
+  /// @brief Read ini information from istream
+  /// @param is istream
+  void read(std::istream &is)
+  {
+    read_impl(is, nullptr);
+  }
+
+  /// @brief Read ini information from istream and accumulate parse statistics into `st`
+  ///        (left untouched unless `INIFILE_ENABLE_STATS` is enabled)
+  void read(std::istream &is, stats &st)
+  {
+    read_impl(is, &st);
+  }
+
+  /// @brief Write ini information to ostream
+  /// @param os ostream
+  void write(std::ostream &os) const
+  {
+    bool first_section = true;
+
+    // 先处理空 section(无 section 的键值对)
+    auto it = data_.find("");
+    if (it != data_.end())
+    {
+      for (const auto &kv : it->second)
+      {
+        write_comment(os, kv.second.comment());  // 添加kv注释
+        os << kv.first << "=" << kv.second << "\n";
+      }
+      first_section = false;
+    }
+
+    // 处理非空 section
+    for (const auto &sec : data_)
+    {
+      // 空 section 已经写过了
+      if (sec.first.empty()) continue;
+
+      if (!first_section) os << "\n";  // Section 之间插入空行
+      first_section = false;
+      write_comment(os, sec.second.comment());  // 添加section注释
+      os << "[" << sec.first << "]\n";
+      for (const auto &kv : sec.second)
+      {
+        write_comment(os, kv.second.comment());  // 添加kv注释
+        os << kv.first << "=" << kv.second << "\n";
+      }
+    }
+  }
+
+  /// @brief Write ini information to ostream and accumulate serialize statistics into `st`
+  ///        (left untouched unless `INIFILE_ENABLE_STATS` is enabled)
+  void write(std::ostream &os, stats &st) const
+  {
+#if INIFILE_ENABLE_STATS
+    // 直接流式写出并计时, 格式化与写出交织在一起, 全部计入 io_time, 不额外生成整份文本
+    const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    write(os);
+    st.io_time += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin);
+    // 按 write() 的输出格式累计字节数和行数
+    auto count_comment = [&st](const comment_type &c) {
+      for (const auto &line : c.view())
+      {
+        st.bytes += line.size() + 1;
+        ++st.lines;
+        ++st.comment_lines;
+      }
+    };
+    std::uint64_t blocks = 0;  // 无名 section 和每个具名 section 各为一块, 块之间有一个空行
+    for (const auto &sec : data_)
+    {
+      if (!sec.first.empty())
+      {
+        ++st.sections;
+        count_comment(sec.second.comment());
+        st.bytes += sec.first.size() + 3;  // "[name]\n"
+        ++st.lines;
+      }
+      ++blocks;
+      st.keys += sec.second.size();
+      st.lines += sec.second.size();
+      for (const auto &kv : sec.second)
+      {
+        count_comment(kv.second.comment());
+        st.bytes += kv.first.size() + kv.second.str().size() + 2;  // "key=value\n"
+      }
+    }
+    if (blocks > 1)
+    {
+      st.bytes += blocks - 1;
+      st.lines += blocks - 1;
+    }
+#else
+    (void)st;
+    write(os);
+#endif
+  }
+
+  /// @brief Read ini information from string
+  /// @param str ini string
+  void from_string(const std::string &str)
+  {
+    std::istringstream is(str);
+    read(is);
   }
 
-  bool empty() const noexcept
+  /// @brief Convert the inifile object to a corresponding string
+  /// @return ini string
+  std::string to_string() const
   {
-    return data_.empty();
+    std::ostringstream ss;
+    write(ss);
+    return ss.str();
   }
 
-  iterator find(key_type key)
+  /// @brief Load ini information from ini file
+  /// @param filename Read file path
+  /// @return Whether the loading is successful, return `true` if successful
+  bool load(const std::string &filename)
   {
-    detail::trim(key);
-    return data_.find(key);
+    std::ifstream is(filename);
+    if (!is) return false;
+
+    read(is);
+    // 仅当 fail() 不是由于 EOF 造成的,并且没有发生 bad(),才认为读取成功
+    return (!is.fail() || is.eof()) && !is.bad();
   }
-  const_iterator find(key_type key) const
+
+  /// @brief Save ini information to ini file
+  /// @param filename Save file path
+  /// @return Whether the save is successful, return `true` if successful
+  bool save(const std::string &filename) const
   {
-    detail::trim(key);
-    return data_.find(key);
+    std::ofstream os(filename);
+    if (!os) return false;
+
+    write(os);
+    os.flush();
+    return !os.fail() && !os.bad();
   }
 
-  size_type count(key_type key) const
+  /// @brief Load ini information from ini file and accumulate parse statistics into `st`
+  ///        (left untouched unless `INIFILE_ENABLE_STATS` is enabled)
+  /// @return Whether the loading is successful, return `true` if successful
+  bool load(const std::string &filename, stats &st)
   {
-    detail::trim(key);
-    return data_.count(key);
+#if INIFILE_ENABLE_STATS
+    const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    std::ifstream is(filename);
+    st.io_time += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin);
+    if (!is) return false;
+
+    read(is, st);
+    return (!is.fail() || is.eof()) && !is.bad();
+#else
+    (void)st;
+    return load(filename);
+#endif
   }
 
-  iterator erase(iterator pos)
+  /// @brief Save ini information to ini file and accumulate serialize statistics into `st`
+  ///        (left untouched unless `INIFILE_ENABLE_STATS` is enabled)
+  /// @return Whether the save is successful, return `true` if successful
+  bool save(const std::string &filename, stats &st) const
   {
-    return data_.erase(pos);
+#if INIFILE_ENABLE_STATS
+    using clock = std::chrono::steady_clock;
+    clock::time_point begin = clock::now();
+    std::ofstream os(filename);
+    st.io_time += std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - begin);
+    if (!os) return false;
+
+    write(os, st);
+    begin = clock::now();
+    os.flush();
+    st.io_time += std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - begin);
+    return !os.fail() && !os.bad();
+#else
+    (void)st;
+    return save(filename);
+#endif
   }
-  iterator erase(const_iterator pos)
+
+  /// @brief Save ini information while preserving the layout of the existing ini file: the file is read again
+  ///        and patched against the current content instead of being re-serialized from scratch.
+  ///        Unchanged lines are copied byte-for-byte, so formatting, ordering, blank lines, comments and
+  ///        line endings (LF/CRLF) of untouched content are preserved. Changed values and comments are
+  ///        re-rendered at their position, removed keys/sections are dropped, new keys are appended to the end of
+  ///        their section and new sections are appended to the end of the file.
+  ///        This is a layout-preserving save, not incremental I/O: no line positions or dirty state are tracked,
+  ///        the whole file is read, scanned and rewritten, so the cost is O(file size) even for a one-value change.
+  ///        The patched text is written to `<filename>.tmp` and renamed over the file, so a crash or a full disk
+  ///        leaves the old file intact. A file whose content would not change is not written.
+  ///        If the file does not exist yet, this is equivalent to `save()`.
+  /// @param filename Save file path (also the source file being patched)
+  /// @return Whether the save is successful, return `true` if successful
+  bool save_incremental(const std::string &filename) const
   {
-    return data_.erase(pos);
+    std::string source;
+    {
+      std::ifstream is(filename, std::ios::binary);
+      if (!is) return save(filename);
+      source.assign(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>());
+      if (is.bad()) return false;
+    }
+    const std::string patched = patch(source);
+    if (patched == source) return true;  // 内容未变, 不重写文件
+    // 先写临时文件再重命名: 原地覆盖在写到一半时崩溃会留下新旧内容混杂的文件
+    const std::string tmp = filename + ".tmp";
+    if (!detail::write_file(tmp, patched) || !detail::replace_file(tmp, filename))
+    {
+      std::remove(tmp.c_str());
+      return false;
+    }
+    return true;
   }
-  iterator erase(const_iterator first, const_iterator last)
+
+  /// @brief Report per-key lookup counts of all sections (see `access_report`).
+  ///        Lookups of keys in sections that do not exist are listed in `missing`.
+  /// @param top_n Maximum number of entries in `hot`
+  ini::access_report report_access(std::size_t top_n = 10) const
   {
-    return data_.erase(first, last);
+    ini::access_report report;
+#if INIFILE_ENABLE_ACCESS_COUNTERS
+    for (const auto &sec : data_) sec.second.collect_access(sec.first, report);
+    for (const auto &miss : misses_.snapshot())
+    {
+      report.missing.push_back(key_access{miss.first.first, miss.first.second, 0, miss.second});
+    }
+#endif
+    section::finish_report(report, top_n);
+    return report;
   }
-  size_type erase(key_type key)
+
+  /// @brief Reset the lookup counts of all sections.
+  void reset_access_counts() const
   {
-    detail::trim(key);
-    return data_.erase(key);
+#if INIFILE_ENABLE_ACCESS_COUNTERS
+    for (const auto &sec : data_) sec.second.reset_access_counts();
+    misses_.reset();
+#endif
   }
 
-  iterator begin() noexcept
+  /// @brief Compute a 64-bit fingerprint of the whole ini content (sections, key-value pairs and comments).
+  ///        The result does not depend on the iteration order of the underlying container.
+  /// @return Fingerprint, inifiles with the same content always produce equal fingerprints.
+  std::uint64_t fingerprint() const noexcept
   {
-    return data_.begin();
+    std::uint64_t h = 0;  // 使用加法组合, 与迭代顺序无关
+    for (const auto &sec : data_)
+    {
+      h += detail::mix64(detail::hash_append(sec.second.fingerprint(), sec.first));
+    }
+    return detail::mix64(h ^ static_cast<std::uint64_t>(data_.size()));
   }
-  const_iterator begin() const noexcept
+
+  /// @brief Save ini information to ini file only if the content differs from the file on disk.
+  ///        The existing file is parsed and compared by `fingerprint()`, an unchanged file is not rewritten
+  ///        (its mtime is left untouched).
+  /// @param filename Save file path
+  /// @return Whether the file is up to date, return `true` if saved successfully or nothing has changed
+  bool save_if_changed(const std::string &filename) const
   {
-    return data_.begin();
+    basic_inifile on_disk;
+    if (on_disk.load(filename) && on_disk.fingerprint() == fingerprint()) return true;
+    return save(filename);
   }
 
-  iterator end() noexcept
+  /// @brief Save ini information to ini file only if the content differs from the last saved fingerprint.
+  ///        The file is not read at all, `last_fingerprint` is updated after a successful save.
+  /// @param filename Save file path
+  /// @param last_fingerprint Fingerprint of the last saved content, maintained by the caller
+  /// @return Whether the file is up to date, return `true` if saved successfully or nothing has changed
+  bool save_if_changed(const std::string &filename, std::uint64_t &last_fingerprint) const
   {
-    return data_.end();
+    const std::uint64_t current = fingerprint();
+    if (current == last_fingerprint) return true;
+    if (!save(filename)) return false;
+    last_fingerprint = current;
+    return true;
   }
-  const_iterator end() const noexcept
+
+  /// @brief Save ini information in the compiled binary format (header, string table, section/key/comment
+  ///        index arrays). The file is loaded by `load_binary()` with one read and no text parsing or trimming.
+  /// @param filename Save file path
+  /// @return Whether the save is successful, return `true` if successful
+  bool save_binary(const std::string &filename) const
   {
-    return data_.end();
+    const std::string bytes = to_binary(0);
+    return !bytes.empty() && detail::write_file(filename, bytes);
   }
 
-  const_iterator cbegin() const noexcept
+  /// @brief Load ini information saved by `save_binary()`.
+  /// @param filename Binary file path
+  /// @return Whether the loading is successful, the content is unchanged if the file is missing or invalid
+  bool load_binary(const std::string &filename)
   {
-    return data_.cbegin();
+    std::string bytes;
+    return detail::read_file(filename, bytes) && from_binary(bytes, nullptr);
   }
-  const_iterator cend() const noexcept
+
+  /// @brief Load ini information from ini file, optionally through a binary cache.
+  ///        With `use_binary_cache`, the sidecar cache (see `binary_cache_filename()`) is loaded instead of
+  ///        parsing the text when its recorded fingerprint matches the source file. Otherwise the source is
+  ///        parsed and the cache is (re)written for the next process.
+  /// @param filename Read file path
+  /// @param use_binary_cache Whether to use the sidecar binary cache
+  /// @return Whether the loading is successful, return `true` if successful
+  bool load(const std::string &filename, bool use_binary_cache)
   {
-    return data_.cend();
+    if (!use_binary_cache) return load(filename);
+    std::string source;
+    if (!detail::read_file(filename, source)) return false;
+    const std::uint64_t source_fingerprint =
+      detail::mix64(detail::fnv1a_64(source.data(), source.size()) ^ static_cast<std::uint64_t>(source.size()));
+
+    const std::string cache = binary_cache_filename(filename);
+    std::string bytes;
+    if (detail::read_file(cache, bytes) && from_binary(bytes, &source_fingerprint)) return true;
+
+    std::istringstream is(source);
+    read(is);
+    // 缓存写入失败不影响加载结果. 先写入唯一的临时文件再重命名,
+    // 多个进程同时重建缓存时, 读者不会看到写了一半的缓存文件
+    bytes = to_binary(source_fingerprint);
+    if (bytes.empty()) return true;
+    const std::string tmp = cache + ".tmp" + std::to_string(detail::mix64(static_cast<std::uint64_t>(
+                                               std::chrono::steady_clock::now().time_since_epoch().count()) ^
+                                             reinterpret_cast<std::uintptr_t>(&bytes)));
+    if (!detail::write_file(tmp, bytes) || !detail::replace_file(tmp, cache)) std::remove(tmp.c_str());
+    return true;
+  }
+
+  /// @brief Sidecar binary cache file used by `load(filename, true)`: `config.ini` -> `config.inic`,
+  ///        other names get the `.inic` suffix appended.
+  static std::string binary_cache_filename(const std::string &filename)
+  {
+    static const std::string ext = ".ini";
+    if (filename.size() >= ext.size() && filename.compare(filename.size() - ext.size(), ext.size(), ext) == 0)
+    {
+      return filename + "c";
+    }
+    return filename + ".inic";
   }
 
-  /// @brief Read ini information from istream
-  /// @param is istream
-  void read(std::istream &is)
-  {
+ private:
+  /// 二进制格式(小端字节序):
+  ///   header : "INIC" u32 版本 | u64 源文件指纹 | u32 section数 | u32 key数 | u32 注释行数 | u32 保留 | u64 字符串表大小
+  ///   section: u32 名称偏移 | u32 名称长度 | u32 首个key | u32 key数 | u32 首个注释行 | u32 注释行数
+  ///   key    : u32 key偏移 | u32 key长度 | u32 值偏移 | u32 值长度 | u32 首个注释行 | u32 注释行数
+  ///   comment: u32 偏移 | u32 长度
+  ///   字符串表: 所有字符串按顺序拼接
+  enum : std::uint32_t
+  {
+    binary_version = 1,
+    binary_header_size = 40,
+    binary_section_size = 24,
+    binary_key_size = 24,
+    binary_comment_size = 8
+  };
+
+  /// @brief 序列化为二进制格式, 字符串表超过 4GB 时返回空字符串
+  std::string to_binary(std::uint64_t source_fingerprint) const
+  {
+    std::string strings, sections, keys, comments;
+    std::uint32_t key_count = 0;
+    std::uint32_t comment_count = 0;
+    auto add_string = [&strings](detail::char_range str, std::string &out) {
+      detail::put_le(out, static_cast<std::uint32_t>(strings.size()));
+      detail::put_le(out, static_cast<std::uint32_t>(str.size));
+      strings.append(str.data, str.size);
+    };
+    auto add_comments = [&](const comment_type &c, std::string &out) {
+      detail::put_le(out, comment_count);
+      detail::put_le(out, static_cast<std::uint32_t>(c.view().size()));
+      for (const auto &line : c.view())
+      {
+        add_string(detail::chars_of(line), comments);
+        ++comment_count;
+      }
+    };
+    for (const auto &sec : data_)
+    {
+      add_string(detail::chars_of(sec.first), sections);
+      detail::put_le(sections, key_count);
+      detail::put_le(sections, static_cast<std::uint32_t>(sec.second.size()));
+      add_comments(sec.second.comment(), sections);
+      for (const auto &kv : sec.second)
+      {
+        add_string(detail::chars_of(kv.first), keys);
+        add_string(detail::chars_of(kv.second.value_), keys);
+        add_comments(kv.second.comment(), keys);
+        ++key_count;
+      }
+    }
+    if (strings.size() > 0xFFFFFFFFu) return std::string();
+
+    std::string out("INIC");
+    detail::put_le(out, static_cast<std::uint32_t>(binary_version));
+    detail::put_le(out, source_fingerprint);
+    detail::put_le(out, static_cast<std::uint32_t>(data_.size()));
+    detail::put_le(out, key_count);
+    detail::put_le(out, comment_count);
+    detail::put_le(out, static_cast<std::uint32_t>(0));
+    detail::put_le(out, static_cast<std::uint64_t>(strings.size()));
+    out.reserve(out.size() + sections.size() + keys.size() + comments.size() + strings.size());
+    out += sections;
+    out += keys;
+    out += comments;
+    out += strings;
+    return out;
+  }
+
+  /// @brief 从二进制格式加载, 先完整校验再替换当前内容
+  /// @param expected_source 非空时要求文件头中的源文件指纹与之相等
+  bool from_binary(const std::string &bytes, const std::uint64_t *expected_source)
+  {
+    if (bytes.size() < binary_header_size || bytes.compare(0, 4, "INIC") != 0) return false;
+    const char *p = bytes.data();
+    if (detail::get_le<std::uint32_t>(p + 4) != binary_version) return false;
+    if (expected_source && detail::get_le<std::uint64_t>(p + 8) != *expected_source) return false;
+    const std::uint32_t section_count = detail::get_le<std::uint32_t>(p + 16);
+    const std::uint32_t key_count = detail::get_le<std::uint32_t>(p + 20);
+    const std::uint32_t comment_count = detail::get_le<std::uint32_t>(p + 24);
+    const std::uint64_t strings_size = detail::get_le<std::uint64_t>(p + 32);
+    const std::uint64_t expected_size = binary_header_size + std::uint64_t(section_count) * binary_section_size +
+                                        std::uint64_t(key_count) * binary_key_size +
+                                        std::uint64_t(comment_count) * binary_comment_size + strings_size;
+    if (expected_size != bytes.size()) return false;
+
+    const char *section_table = p + binary_header_size;
+    const char *key_table = section_table + std::size_t(section_count) * binary_section_size;
+    const char *comment_table = key_table + std::size_t(key_count) * binary_key_size;
+    const char *strings = comment_table + std::size_t(comment_count) * binary_comment_size;
+
+    auto u32 = [](const char *entry, int index) { return detail::get_le<std::uint32_t>(entry + index * 4); };
+    auto valid_string = [&](const char *entry) {
+      return u32(entry, 0) <= strings_size && u32(entry, 1) <= strings_size - u32(entry, 0);
+    };
+    auto valid_range = [](std::uint32_t first, std::uint32_t count, std::uint32_t total) {
+      return first <= total && count <= total - first;
+    };
+    for (std::uint32_t i = 0; i < section_count; ++i)
+    {
+      const char *e = section_table + std::size_t(i) * binary_section_size;
+      if (!valid_string(e) || !valid_range(u32(e, 2), u32(e, 3), key_count) ||
+          !valid_range(u32(e, 4), u32(e, 5), comment_count))
+        return false;
+    }
+    for (std::uint32_t i = 0; i < key_count; ++i)
+    {
+      const char *e = key_table + std::size_t(i) * binary_key_size;
+      if (!valid_string(e) || !valid_string(e + 8) || !valid_range(u32(e, 4), u32(e, 5), comment_count))
+        return false;
+    }
+    for (std::uint32_t i = 0; i < comment_count; ++i)
+    {
+      if (!valid_string(comment_table + std::size_t(i) * binary_comment_size)) return false;
+    }
+
+    const typename string_type::allocator_type alloc(data_.get_allocator());
+    auto make_comment = [&](std::uint32_t first, std::uint32_t count, comment_type *target) {
+      if (count == 0 || !target) return;  // no_comments 策略下丢弃注释
+      comment_type &out = *target;
+      out.ensure_comments_initialized();
+      out.comments_->reserve(count);
+      for (std::uint32_t i = first; i < first + count; ++i)
+      {
+        const char *e = comment_table + std::size_t(i) * binary_comment_size;
+        out.comments_->push_back(string_type(strings + u32(e, 0), u32(e, 1), out.get_allocator()));
+      }
+    };
+    data_container data(0, hasher(), key_equal(), data_.get_allocator());
+    data.reserve(section_count);
+    for (std::uint32_t i = 0; i < section_count; ++i)
+    {
+      const char *e = section_table + std::size_t(i) * binary_section_size;
+      section &sec = section_at(data, key_type(strings + u32(e, 0), u32(e, 1), alloc));
+      auto &storage = sec.leak();
+      make_comment(u32(e, 4), u32(e, 5), storage.comments.writable_comment());
+      storage.data.reserve(u32(e, 3));
+      for (std::uint32_t k = u32(e, 2); k < u32(e, 2) + u32(e, 3); ++k)
+      {
+        const char *ke = key_table + std::size_t(k) * binary_key_size;
+        field &f = detail::find_or_insert(storage.data, key_type(strings + u32(ke, 0), u32(ke, 1), alloc));
+        f.value_.assign(strings + u32(ke, 2), u32(ke, 3));
+        make_comment(u32(ke, 4), u32(ke, 5), f.writable_comment());
+      }
+      sec.share();
+    }
+    data_.swap(data);
+    return true;
+  }
+
+#if INIFILE_ENABLE_STATS
+#define INIFILE_STATS(...) \
+  do                       \
+  {                        \
+    if (st)                \
+    {                      \
+      __VA_ARGS__;         \
+    }                      \
+  } while (0)
+#else
+#define INIFILE_STATS(...) \
+  do                       \
+  {                        \
+  } while (0)
+#endif
+
+  /// @brief 解析 istream, st 不为空时累计统计信息(未启用 INIFILE_ENABLE_STATS 时统计代码不参与编译)
+  void read_impl(std::istream &is, stats *st)
+  {
+#if INIFILE_ENABLE_STATS
+    using clock = std::chrono::steady_clock;
+    clock::time_point mark = st ? clock::now() : clock::time_point();
+    auto lap = [&mark](std::chrono::nanoseconds &target) {  // 将上次计时以来的时间计入 target
+      const clock::time_point now = clock::now();
+      target += std::chrono::duration_cast<std::chrono::nanoseconds>(now - mark);
+      mark = now;
+    };
+    std::size_t sections_before = 0, buckets_before = 0, keys_before = 0, key_buckets_before = 0;
+    bool had_storage = false;
+#else
+    (void)st;
+#endif
     data_.clear();
     std::string line;
-    std::string current_section;
-    comment comments;  // 注释类
+    key_type current_section(data_.get_allocator());
+    comment_type comments(data_.get_allocator());  // 注释类
     while (std::getline(is, line))
     {
+      INIFILE_STATS(lap(st->io_time); st->bytes += line.size() + (is.eof() ? 0 : 1); ++st->lines);
       detail::trim(line);
       if (line.empty())  // 跳过空行
       {
+        INIFILE_STATS(lap(st->scan_time));
         continue;
       }
       if (line[0] == ';' || line[0] == '#')  // 添加注释行
       {
-        comments.add(line, line[0]);
+        if (CommentPolicy::enabled) comments.add(line, line[0]);  // no_comments 策略下直接跳过, 不分配内存
+        INIFILE_STATS(++st->comment_lines; lap(st->scan_time));
         continue;
       }
       if (line.front() == '[' && line.back() == ']')  // 处理section
       {
-        current_section = line.substr(1, line.size() - 2);
+        current_section.assign(line.data() + 1, line.size() - 2);
         detail::trim(current_section);
+        INIFILE_STATS(lap(st->scan_time));
         if (!current_section.empty())
         {
-          data_[current_section];  // 添加没有key=value的section
-          if (!comments.empty())   // 添加注释
+          INIFILE_STATS(sections_before = data_.size(); buckets_before = detail::bucket_count_of(data_, 0));
+          section &sec = section_at(data_, current_section);  // 添加没有key=value的section
+          if (!comments.empty())                  // 添加注释
           {
             // After set_comment, comments.clear() should be called, but it is not necessary after using std::move
-            data_[current_section].set_comment(std::move(comments));
+            sec.set_comment(std::move(comments));
           }
+          INIFILE_STATS(record_section(*st, sections_before, buckets_before, current_section);
+                        lap(st->insert_time));
         }
       }
       else  // 处理key=value
@@ -1662,105 +4104,136 @@ class basic_inifile
         auto pos = line.find('=');
         if (pos != std::string::npos)
         {
-          std::string key = line.substr(0, pos);
+          key_type key(line.data(), pos, current_section.get_allocator());
           std::string value = line.substr(pos + 1);
           detail::trim(key);
           detail::trim(value);
-          data_[current_section][key] = value;  // 允许section为空字符串
-          if (!comments.empty())                // 添加注释
+          INIFILE_STATS(lap(st->scan_time); ++st->keys; sections_before = data_.size();
+                        buckets_before = detail::bucket_count_of(data_, 0));
+          section &sec = section_at(data_, current_section);  // 允许section为空字符串
+          INIFILE_STATS(record_section(*st, sections_before, buckets_before, current_section);
+                        had_storage = sec.impl_ != nullptr; keys_before = sec.size();
+                        key_buckets_before = had_storage ? detail::bucket_count_of(sec.impl_->data, 0) : 0);
+          field &f = detail::find_or_insert(sec.leak().data, key);  // 解析不计入访问计数
+          f = value;
+          if (!comments.empty())  // 添加注释
           {
             // set_comment后应该调用comments.clear()的, 但使用std::move后就不需要了
-            data_[current_section][key].set_comment(std::move(comments));
+            f.set_comment(std::move(comments));
           }
+          INIFILE_STATS(record_key(*st, sec, had_storage, keys_before, key_buckets_before, key, value);
+                        lap(st->insert_time));
+        }
+        else
+        {
+          INIFILE_STATS(lap(st->scan_time));
         }
       }
     }
+    for (auto &sec : data_) sec.second.share();  // 解析完成, 没有外部引用, 拷贝时可以共享
   }
+#undef INIFILE_STATS
 
-  /// @brief Write ini information to ostream
-  /// @param os ostream
-  void write(std::ostream &os) const
+#if INIFILE_ENABLE_STATS
+  /// @brief 字符串超出短字符串优化(SSO)容量时的堆内存
+  template <typename String>
+  static void record_string(stats &st, const String &str)
   {
-    bool first_section = true;
+    static const std::size_t sso_capacity = String().capacity();
+    if (str.size() <= sso_capacity) return;
+    ++st.estimated_allocations;
+    st.estimated_allocated_bytes += str.size() + 1;
+  }
 
-    // 先处理空 section(无 section 的键值对)
-    auto it = data_.find("");
-    if (it != data_.end())
+  /// @brief 记录一次 section 查找/插入: 新节点、section 名的堆内存以及桶数组扩容
+  void record_section(stats &st, std::size_t size_before, std::size_t buckets_before, const key_type &name) const
+  {
+    if (data_.size() != size_before)
     {
-      for (const auto &kv : it->second)
-      {
-        write_comment(os, kv.second.comment());  // 添加kv注释
-        os << kv.first << "=" << kv.second << "\n";
-      }
-      first_section = false;
+      ++st.sections;
+      ++st.estimated_allocations;
+      // 节点 + 链表指针/哈希
+      st.estimated_allocated_bytes += sizeof(typename data_container::value_type) + 2 * sizeof(void *);
+      record_string(st, name);
     }
-
-    // 处理非空 section
-    for (const auto &sec : data_)
+    const std::size_t buckets = detail::bucket_count_of(data_, 0);
+    if (buckets != buckets_before)
     {
-      // 空 section 已经写过了
-      if (sec.first.empty()) continue;
-
-      if (!first_section) os << "\n";  // Section 之间插入空行
-      first_section = false;
-      write_comment(os, sec.second.comment());  // 添加section注释
-      os << "[" << sec.first << "]\n";
-      for (const auto &kv : sec.second)
-      {
-        write_comment(os, kv.second.comment());  // 添加kv注释
-        os << kv.first << "=" << kv.second << "\n";
-      }
+      ++st.rehashes;
+      ++st.estimated_allocations;
+      st.estimated_allocated_bytes += buckets * sizeof(void *);
     }
   }
 
-  /// @brief Read ini information from string
-  /// @param str ini string
-  void from_string(const std::string &str)
+  /// @brief 记录一次 key 插入/赋值: section 存储、新节点、key/value 的堆内存以及桶数组扩容
+  static void record_key(stats &st, const section &sec, bool had_storage, std::size_t size_before,
+                         std::size_t buckets_before, const key_type &key, const std::string &value)
   {
-    std::istringstream is(str);
-    read(is);
+    if (!had_storage)  // 第一个 key 创建了 section 的共享存储
+    {
+      ++st.estimated_allocations;
+      st.estimated_allocated_bytes += sizeof(typename section::impl) + 2 * sizeof(long);  // 对象 + 引用计数控制块
+    }
+    if (sec.size() != size_before)
+    {
+      ++st.estimated_allocations;
+      st.estimated_allocated_bytes += sizeof(typename section::value_type) + 2 * sizeof(void *);
+      record_string(st, key);
+    }
+    record_string(st, value);
+    const std::size_t buckets = detail::bucket_count_of(sec.impl_->data, 0);
+    if (buckets != buckets_before)
+    {
+      ++st.rehashes;
+      ++st.estimated_allocations;
+      st.estimated_allocated_bytes += buckets * sizeof(void *);
+    }
   }
+#endif
 
-  /// @brief Convert the inifile object to a corresponding string
-  /// @return ini string
-  std::string to_string() const
+  /// @brief 获取或插入 section. 有状态的分配器不能默认构造, 新 section 需要显式传入容器的分配器
+  template <typename Name>
+  static section &section_at(data_container &data, Name &&name)
   {
-    std::ostringstream ss;
-    write(ss);
-    return ss.str();
+    return detail::find_or_insert(data, std::forward<Name>(name));
   }
 
-  /// @brief Load ini information from ini file
-  /// @param filename Read file path
-  /// @return Whether the loading is successful, return `true` if successful
-  bool load(const std::string &filename)
+  /// @brief 使用 alloc 复制 section. 有状态的分配器需要逐个复制, 容器的拷贝不会把分配器传给 section 和 section 名
+  static data_container copy_data(const data_container &other, const map_allocator &alloc)
   {
-    std::ifstream is(filename);
-    if (!is) return false;
-
-    read(is);
-    // 仅当 fail() 不是由于 EOF 造成的,并且没有发生 bad(),才认为读取成功
-    return (!is.fail() || is.eof()) && !is.bad();
+    if (std::is_empty<Allocator>::value) return data_container(other, alloc);
+    data_container data(0, hasher(), key_equal(), alloc);
+    data.reserve(other.size());
+    const Allocator a(alloc);
+    for (const auto &sec : other) data.emplace(key_type(sec.first, a), section(sec.second, a));
+    return data;
   }
-
-  /// @brief Save ini information to ini file
-  /// @param filename Save file path
-  /// @return Whether the save is successful, return `true` if successful
-  bool save(const std::string &filename) const
+  /// @brief 分配器不同时的移动: 逐个移动 section, 其内容复制到 alloc 中
+  static data_container move_data(data_container &&other, const map_allocator &alloc)
   {
-    std::ofstream os(filename);
-    if (!os) return false;
+    data_container data(0, hasher(), key_equal(), alloc);
+    data.reserve(other.size());
+    const Allocator a(alloc);
+    for (auto &sec : other) data.emplace(key_type(sec.first, a), section(std::move(sec.second), a));
+    return data;
+  }
 
-    write(os);
-    os.flush();
-    return !os.fail() && !os.bad();
+  /// @brief 统计一次 section 不存在时的 key 查找(未启用 INIFILE_ENABLE_ACCESS_COUNTERS 时为空操作)
+  void count_missing_section(const key_type &sec, const key_type &key) const
+  {
+#if INIFILE_ENABLE_ACCESS_COUNTERS
+    key_type buffer;
+    misses_.add(std::make_pair(detail::to_std_string(sec), detail::to_std_string(detail::trimmed(key, buffer))));
+#else
+    (void)sec;
+    (void)key;
+#endif
   }
 
- private:
   /// @brief 写注释内容
   /// @param os 输出流
   /// @param comments 注释内容
-  static void write_comment(std::ostream &os, const comment &comments)
+  static void write_comment(std::ostream &os, const comment_type &comments)
   {
     if (!comments.empty())
     {
@@ -1771,8 +4244,183 @@ class basic_inifile
     }
   }
 
+  /// @brief 以原始ini文本为基础, 生成反映当前内容的新文本, 未改动的行原样保留(save_incremental使用)
+  /// @param source 原始ini文件内容
+  /// @return 修补后的ini文本
+  std::string patch(const std::string &source) const
+  {
+    using key_set = std::unordered_set<std::string, Hash, Equal>;
+    using line_range = std::pair<std::size_t, std::size_t>;  // [begin, end) 包含行尾换行符
+
+    // 按行切分(保留行尾换行符)并确定换行风格
+    std::vector<line_range> lines;
+    for (std::size_t begin = 0; begin < source.size();)
+    {
+      std::size_t end = source.find('\n', begin);
+      end = (end == std::string::npos) ? source.size() : end + 1;
+      lines.emplace_back(begin, end);
+      begin = end;
+    }
+    const std::string eol = (!lines.empty() && lines[0].second >= 2 && source[lines[0].second - 1] == '\n' &&
+                             source[lines[0].second - 2] == '\r')
+                              ? "\r\n"
+                              : "\n";
+
+    // 第一遍扫描: 记录文件中已存在的 section 和 key, 用于判断哪些是新增内容
+    std::unordered_map<std::string, key_set, Hash, Equal> present;
+    {
+      std::string current;
+      present[current];
+      for (const auto &range : lines)
+      {
+        std::string line = source.substr(range.first, range.second - range.first);
+        detail::trim(line);
+        if (line.empty() || line[0] == ';' || line[0] == '#') continue;
+        if (line.front() == '[' && line.back() == ']')
+        {
+          current = line.substr(1, line.size() - 2);
+          detail::trim(current);
+          present[current];
+          continue;
+        }
+        auto pos = line.find('=');
+        if (pos == std::string::npos) continue;
+        std::string key = line.substr(0, pos);
+        detail::trim(key);
+        present[current].insert(std::move(key));
+      }
+    }
+
+    std::string out;
+    out.reserve(source.size());
+    auto append_line = [&out, &eol](const std::string &text) {
+      if (!out.empty() && out.back() != '\n') out += eol;  // 原文件最后一行可能没有换行符
+      out += text;
+      out += eol;
+    };
+    auto append_comment = [&append_line](const comment_type &comments) {
+      for (const auto &item : comments) append_line(item);
+    };
+
+    // 尚未输出的空行/注释行(second 表示是否为注释行), 它们归属于下一个 section 或 key
+    std::vector<std::pair<line_range, bool>> pending;
+    comment_type pending_comment;  // pending 中注释行解析后的内容
+    // expected 为空时丢弃 pending 中的注释行; 注释未变时原样输出, 否则输出新的注释
+    auto flush_pending = [&](const comment_type *expected, bool verbatim) {
+      const bool keep_comment = verbatim || (expected && *expected == pending_comment);
+      for (const auto &item : pending)
+      {
+        if (keep_comment || !item.second) out.append(source, item.first.first, item.first.second - item.first.first);
+      }
+      if (expected && !keep_comment) append_comment(*expected);
+      pending.clear();
+      pending_comment.clear();
+    };
+
+    std::string current;                     // 当前 section 名
+    auto current_it = find(current);         // 当前 section 在 data_ 中的位置
+    std::unordered_set<std::string, Hash, Equal> completed;  // 已补齐新增 key 的 section
+    auto finish_section = [&]() {
+      if (current_it == data_.end() || !completed.insert(current).second) return;
+      const key_set &keys = present[current];
+      for (const auto &kv : current_it->second)
+      {
+        if (keys.count(detail::to_std_string(kv.first)) != 0) continue;
+        append_comment(kv.second.comment());
+        append_line(detail::to_std_string(kv.first) + "=" + detail::to_std_string(kv.second.value_));
+      }
+    };
+
+    for (const auto &range : lines)
+    {
+      std::string line = source.substr(range.first, range.second - range.first);
+      detail::trim(line);
+      if (line.empty() || line[0] == ';' || line[0] == '#')
+      {
+        if (!line.empty()) pending_comment.add(line, line[0]);
+        pending.emplace_back(range, !line.empty());
+        continue;
+      }
+      if (line.front() == '[' && line.back() == ']')
+      {
+        finish_section();
+        current = line.substr(1, line.size() - 2);
+        detail::trim(current);
+        current_it = find(current);
+        if (current_it == data_.end())
+        {
+          flush_pending(nullptr, false);  // section 已被删除, 丢弃其注释
+          continue;
+        }
+        // 空 section 名 "[]" 不会消耗注释, 原样保留
+        flush_pending(&current_it->second.comment(), current.empty());
+        out.append(source, range.first, range.second - range.first);
+        continue;
+      }
+      auto pos = line.find('=');
+      if (pos == std::string::npos)  // 无法解析的行, 原样保留
+      {
+        pending.emplace_back(range, false);
+        continue;
+      }
+      std::string key = line.substr(0, pos);
+      std::string value = line.substr(pos + 1);
+      detail::trim(key);
+      detail::trim(value);
+      if (current_it == data_.end())  // section 已被删除
+      {
+        flush_pending(nullptr, false);
+        continue;
+      }
+      auto kv_it = current_it->second.find(key);
+      if (kv_it == current_it->second.end())  // key 已被删除
+      {
+        flush_pending(nullptr, false);
+        continue;
+      }
+      flush_pending(&kv_it->second.comment(), false);
+      const std::string &current_value = detail::to_std_string(kv_it->second.value_);
+      if (value == current_value)
+      {
+        out.append(source, range.first, range.second - range.first);
+        continue;
+      }
+      // 保留 '=' 及其之前的原始格式, 仅替换值
+      const std::size_t eq = source.find('=', range.first);
+      const std::size_t value_begin = source.find_first_not_of(" \t", eq + 1);
+      out.append(source, range.first, (std::min)(value_begin, range.second) - range.first);
+      out += current_value;
+      out += eol;
+    }
+    finish_section();
+    std::vector<std::pair<line_range, bool>> trailing;  // 文件末尾不属于任何条目的注释, 放在新增 section 之后
+    trailing.swap(pending);
+
+    // 追加文件中不存在的 section
+    bool need_blank = !out.empty();
+    for (const auto &sec : data_)
+    {
+      if (present.count(detail::to_std_string(sec.first)) != 0) continue;
+      if (need_blank) append_line("");
+      need_blank = true;
+      append_comment(sec.second.comment());
+      append_line("[" + detail::to_std_string(sec.first) + "]");
+      for (const auto &kv : sec.second)
+      {
+        append_comment(kv.second.comment());
+        append_line(detail::to_std_string(kv.first) + "=" + detail::to_std_string(kv.second.value_));
+      }
+    }
+    pending.swap(trailing);
+    flush_pending(nullptr, true);
+    return out;
+  }
+
  private:
   data_container data_;  // section_name - key_value
+#if INIFILE_ENABLE_ACCESS_COUNTERS
+  detail::miss_table<std::pair<std::string, std::string>> misses_;  // section 不存在时的 key 查找次数
+#endif
 };
 
 /// @brief Trims whitespace from both ends of the given string.
@@ -1836,6 +4484,50 @@ using inifile = basic_inifile<>;
 using case_insensitive_section = basic_section<detail::case_insensitive_hash, detail::case_insensitive_equal>;
 /// @brief case_insensitive_inifile class
 using case_insensitive_inifile = basic_inifile<detail::case_insensitive_hash, detail::case_insensitive_equal>;
+/// @brief ordered_section class, keeps keys in insertion order
+using ordered_section = basic_section<std::hash<std::string>, std::equal_to<std::string>, detail::ordered_map>;
+/// @brief ordered_inifile class, keeps sections and keys in insertion order
+using ordered_inifile = basic_inifile<std::hash<std::string>, std::equal_to<std::string>, detail::ordered_map>;
+/// @brief case_insensitive_ordered_section class
+using case_insensitive_ordered_section =
+  basic_section<detail::case_insensitive_hash, detail::case_insensitive_equal, detail::ordered_map>;
+/// @brief case_insensitive_ordered_inifile class
+using case_insensitive_ordered_inifile =
+  basic_inifile<detail::case_insensitive_hash, detail::case_insensitive_equal, detail::ordered_map>;
+/// @brief uncommented_section class, stores no comments (see `no_comments`)
+using uncommented_section = basic_section<std::hash<std::string>, std::equal_to<std::string>, std::unordered_map,
+                                          std::allocator<char>, no_comments>;
+/// @brief uncommented_inifile class, comment lines are skipped while parsing and not stored (see `no_comments`)
+using uncommented_inifile = basic_inifile<std::hash<std::string>, std::equal_to<std::string>, std::unordered_map,
+                                          std::allocator<char>, no_comments>;
+
+#ifdef __cpp_lib_memory_resource  // If we have std::pmr (C++17)
+/// @brief Aliases using `std::pmr::polymorphic_allocator`: the section and key-value containers, the section
+///        storage and the key, value and comment strings (`std::pmr::string`) all come from the
+///        `std::pmr::memory_resource` passed to the constructor, e.g. a `std::pmr::monotonic_buffer_resource` over
+///        a stack buffer. Lookups still accept `std::string` and C strings.
+namespace pmr
+{
+/// @brief pmr section class
+using section = basic_section<std::hash<std::string>, std::equal_to<std::string>, std::unordered_map,
+                              std::pmr::polymorphic_allocator<char>>;
+/// @brief pmr inifile class
+using inifile = basic_inifile<std::hash<std::string>, std::equal_to<std::string>, std::unordered_map,
+                              std::pmr::polymorphic_allocator<char>>;
+/// @brief pmr case_insensitive_section class
+using case_insensitive_section = basic_section<detail::case_insensitive_hash, detail::case_insensitive_equal,
+                                               std::unordered_map, std::pmr::polymorphic_allocator<char>>;
+/// @brief pmr case_insensitive_inifile class
+using case_insensitive_inifile = basic_inifile<detail::case_insensitive_hash, detail::case_insensitive_equal,
+                                               std::unordered_map, std::pmr::polymorphic_allocator<char>>;
+/// @brief pmr ordered_section class
+using ordered_section = basic_section<std::hash<std::string>, std::equal_to<std::string>, detail::ordered_map,
+                                      std::pmr::polymorphic_allocator<char>>;
+/// @brief pmr ordered_inifile class
+using ordered_inifile = basic_inifile<std::hash<std::string>, std::equal_to<std::string>, detail::ordered_map,
+                                      std::pmr::polymorphic_allocator<char>>;
+}  // namespace pmr
+#endif
 
 }  // namespace ini
 
@@ -0,0 +1,256 @@
+/**************************************************************************************************************
+ *~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * @file: interpolate.h
+ * @description: Lazy, memoized `${section:key}` value interpolation.
+ * - `interpolator` wraps a `basic_inifile` and expands references on first access, e.g.
+ *   `log_dir=${paths:root}/logs`. `${key}` refers to a key of the same section, `$$` is a literal `$`.
+ * - Every expanded value is cached together with the raw value it was expanded from and the keys it
+ *   references. A cache hit re-checks those raw values against the document, so changes made directly to
+ *   the inifile (`inif.set()`, `inif[s][k] = ...`, erasing keys) are picked up without `invalidate()`.
+ *   `set()` through the interpolator drops the cached values eagerly.
+ * - Reference cycles are detected and reported with `std::runtime_error`.
+ *
+ * @license: MIT
+ * @repository: https://github.com/abin-z/inifile
+ *~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ **************************************************************************************************************/
+
+#ifndef INI_FILE_INTERPOLATE_H_
+#define INI_FILE_INTERPOLATE_H_
+
+#include <inifile/inifile.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ini
+{
+
+/// @brief Expands `${section:key}` references of an inifile lazily and caches the results
+template <typename Hash = std::hash<std::string>, typename Equal = std::equal_to<std::string>,
+          template <typename...> class Map = std::unordered_map>
+class basic_interpolator
+{
+ public:
+  using inifile_type = basic_inifile<Hash, Equal, Map>;
+
+  /// @param inif Referenced, not copied. Direct modifications of `inif` are detected on the next access.
+  explicit basic_interpolator(inifile_type &inif) : inif_(&inif) {}
+
+  /// @brief Get the expanded value, resolving and caching it on first access.
+  ///        A cached value is returned only if the raw values of the key and of every key it (transitively)
+  ///        references are unchanged, otherwise it is expanded again.
+  /// @return Reference to the cached value, valid until the next call on this interpolator
+  /// @throws `std::out_of_range` if the key, or a key it references, does not exist
+  /// @throws `std::runtime_error` on a reference cycle or a malformed reference
+  const std::string &str(std::string sec, std::string key)
+  {
+    detail::trim(sec);
+    detail::trim(key);
+    std::vector<std::string> resolving;
+    return resolve(sec, key, resolving).value;
+  }
+
+  /// @brief Get the expanded value converted to T.
+  /// @throws `std::invalid_argument` / `std::out_of_range` if the conversion fails, see also `str()`
+  template <typename T>
+  T as(std::string sec, std::string key)
+  {
+    T result;
+    detail::convert<T>::decode(str(std::move(sec), std::move(key)), result);
+    return result;
+  }
+
+  /// @brief Get the expanded value converted to T, or `default_value` if the key does not exist.
+  template <typename T>
+  T get(std::string sec, std::string key, T default_value)
+  {
+    if (!inif_->contains(sec, key)) return default_value;
+    return as<T>(std::move(sec), std::move(key));
+  }
+
+  /// @brief Set the raw (unexpanded) value and invalidate the cached values depending on it.
+  template <typename T>
+  field &set(std::string sec, std::string key, T &&value)
+  {
+    detail::trim(sec);
+    detail::trim(key);
+    invalidate(sec, key);
+    return inif_->set(std::move(sec), std::move(key), std::forward<T>(value));
+  }
+
+  /// @brief Drop the cached value of a key and of every key depending on it (frees memory, stale values are
+  ///        detected without it).
+  void invalidate(std::string sec, std::string key)
+  {
+    detail::trim(sec);
+    detail::trim(key);
+    invalidate_id(make_id(sec, key));
+  }
+
+  /// @brief Drop all cached values.
+  void clear() noexcept
+  {
+    cache_.clear();
+  }
+
+  /// @brief Number of cached values.
+  std::size_t cached() const noexcept
+  {
+    return cache_.size();
+  }
+
+ private:
+  struct entry
+  {
+    std::string section;                    // 所在 section
+    std::string key;                        // 键名
+    std::string raw;                        // 展开时的原始值, 命中缓存时与文档中的当前值比较
+    std::string value;                      // 展开后的值
+    std::vector<std::string> dependencies;  // 该键引用的键(缓存 id)
+    std::vector<std::string> dependents;    // 引用了该键的键(缓存 id)
+  };
+
+  static std::string make_id(const std::string &sec, const std::string &key)
+  {
+    std::string id;
+    id.reserve(sec.size() + key.size() + 1);
+    id.append(sec).push_back('\0');  // '\0' 不会出现在解析得到的名字中
+    id.append(key);
+    return id;
+  }
+
+  static std::string describe(const std::string &id)
+  {
+    std::string text = id;
+    std::replace(text.begin(), text.end(), '\0', ':');
+    return text;
+  }
+
+  const entry &resolve(const std::string &sec, const std::string &key, std::vector<std::string> &resolving)
+  {
+    std::string id = make_id(sec, key);
+    auto cached = cache_.find(id);
+    if (cached != cache_.end())
+    {
+      if (is_current(cached->second)) return cached->second;
+      invalidate_id(id);  // 文档被直接修改过, 连同依赖它的键一起重新展开
+    }
+
+    Equal equal;
+    for (const std::string &pending : resolving)
+    {
+      if (!equal(pending, id)) continue;
+      std::string chain;
+      for (const std::string &step : resolving) chain += describe(step) + " -> ";
+      throw std::runtime_error("ini::interpolator: reference cycle: " + chain + describe(id));
+    }
+
+    const inifile_type &doc = *inif_;  // 通过 const 接口读取, 不影响 section 的写时复制共享
+    const std::string &raw = doc.at(sec).at(key).str();  // 不存在时抛出 std::out_of_range
+    std::string value;
+    std::vector<std::string> dependencies;
+    if (raw.find('$') == std::string::npos)
+    {
+      value = raw;
+    }
+    else
+    {
+      resolving.push_back(id);
+      value.reserve(raw.size());
+      for (std::size_t pos = 0; pos < raw.size();)
+      {
+        if (raw[pos] != '$' || pos + 1 == raw.size())
+        {
+          value.push_back(raw[pos++]);
+          continue;
+        }
+        if (raw[pos + 1] == '$')  // "$$" -> "$"
+        {
+          value.push_back('$');
+          pos += 2;
+          continue;
+        }
+        if (raw[pos + 1] != '{')
+        {
+          value.push_back(raw[pos++]);
+          continue;
+        }
+        const std::size_t close = raw.find('}', pos + 2);
+        if (close == std::string::npos)
+        {
+          throw std::runtime_error("ini::interpolator: unterminated reference in " + describe(id));
+        }
+        std::string ref = raw.substr(pos + 2, close - pos - 2);
+        std::string ref_sec = sec;
+        const std::size_t colon = ref.find(':');
+        if (colon != std::string::npos)
+        {
+          ref_sec = ref.substr(0, colon);
+          ref.erase(0, colon + 1);
+          detail::trim(ref_sec);
+        }
+        detail::trim(ref);
+        value += resolve(ref_sec, ref, resolving).value;
+        dependencies.push_back(make_id(ref_sec, ref));
+        pos = close + 1;
+      }
+      resolving.pop_back();
+    }
+
+    // 依赖的键已经缓存(先于本键解析), 在其上登记反向依赖, 以便修改时级联失效
+    for (const std::string &dependency : dependencies)
+    {
+      std::vector<std::string> &dependents = cache_[dependency].dependents;
+      if (std::find(dependents.begin(), dependents.end(), id) == dependents.end()) dependents.push_back(id);
+    }
+    entry &result = cache_[std::move(id)];
+    result.section = sec;
+    result.key = key;
+    result.raw = raw;
+    result.value = std::move(value);
+    result.dependencies = std::move(dependencies);
+    return result;
+  }
+
+  /// @brief 缓存的展开结果是否仍然有效: 键仍然存在、原始值未变, 且引用的键(递归)同样有效
+  bool is_current(const entry &e) const
+  {
+    const inifile_type &doc = *inif_;
+    auto sec_it = doc.find(e.section);
+    if (sec_it == doc.end()) return false;
+    auto it = sec_it->second.find(e.key);
+    if (it == sec_it->second.end() || it->second.str() != e.raw) return false;
+    for (const std::string &dependency : e.dependencies)
+    {
+      auto dep = cache_.find(dependency);
+      if (dep == cache_.end() || !is_current(dep->second)) return false;
+    }
+    return true;
+  }
+
+  void invalidate_id(const std::string &id)
+  {
+    auto it = cache_.find(id);
+    if (it == cache_.end()) return;
+    std::vector<std::string> dependents = std::move(it->second.dependents);
+    cache_.erase(it);
+    for (const std::string &dependent : dependents) invalidate_id(dependent);
+  }
+
+ private:
+  inifile_type *inif_;
+  Map<std::string, entry, Hash, Equal> cache_;
+};
+
+/// @brief interpolator class
+using interpolator = basic_interpolator<>;
+/// @brief case_insensitive_interpolator class
+using case_insensitive_interpolator = basic_interpolator<detail::case_insensitive_hash, detail::case_insensitive_equal>;
+
+}  // namespace ini
+
+#endif  // INI_FILE_INTERPOLATE_H_
@@ -0,0 +1,283 @@
+/**************************************************************************************************************
+ *~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * @file: journal.h
+ * @description: Append-only change journal for high-frequency updates of an ini file.
+ * - Every `set` / `remove` appends one compact record to `<filename>.journal` instead of rewriting the ini file.
+ * - `load()` replays the journal on top of the base ini file.
+ * - `compact()` folds the journal back into the base ini file (written to a temporary file and renamed over it)
+ *   and then truncates the journal.
+ *
+ * Journal record format (one record per line, fields separated by '\t', '\\' '\t' '\r' '\n' are escaped):
+ *   S <section> <key> <value>   set key-value
+ *   K <section> <key>           remove key
+ *   D <section>                 remove section
+ *
+ * @license: MIT
+ * @repository: https://github.com/abin-z/inifile
+ *~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ **************************************************************************************************************/
+
+#ifndef INI_FILE_JOURNAL_H_
+#define INI_FILE_JOURNAL_H_
+
+#include <inifile/inifile.h>
+
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ini
+{
+
+namespace detail
+{
+/// @brief 转义日志字段中的特殊字符('\\' '\t' '\r' '\n')
+inline void journal_escape(const std::string &str, std::string &out)
+{
+  for (char c : str)
+  {
+    switch (c)
+    {
+    case '\\': out += "\\\\"; break;
+    case '\t': out += "\\t"; break;
+    case '\r': out += "\\r"; break;
+    case '\n': out += "\\n"; break;
+    default: out += c; break;
+    }
+  }
+}
+
+/// @brief 反转义日志字段
+inline std::string journal_unescape(const std::string &str)
+{
+  std::string out;
+  out.reserve(str.size());
+  for (std::size_t i = 0; i < str.size(); ++i)
+  {
+    if (str[i] != '\\' || i + 1 == str.size())
+    {
+      out += str[i];
+      continue;
+    }
+    switch (str[++i])
+    {
+    case 't': out += '\t'; break;
+    case 'r': out += '\r'; break;
+    case 'n': out += '\n'; break;
+    default: out += str[i]; break;
+    }
+  }
+  return out;
+}
+}  // namespace detail
+
+/// @brief ini file with an append-only change journal
+template <typename Hash = std::hash<std::string>, typename Equal = std::equal_to<std::string>>
+class basic_journaled_inifile
+{
+ public:
+  using inifile_type = basic_inifile<Hash, Equal>;
+
+  basic_journaled_inifile() = default;
+  ~basic_journaled_inifile() = default;
+
+  basic_journaled_inifile(const basic_journaled_inifile &) = delete;
+  basic_journaled_inifile &operator=(const basic_journaled_inifile &) = delete;
+
+  /// @brief Load the base ini file and replay `<filename>.journal` on top of it.
+  ///        A missing base file or journal is treated as empty. Subsequent changes are appended to the journal.
+  ///        An incomplete last record (e.g. after a crash during append) is ignored.
+  /// @param filename Base ini file path
+  /// @return Whether the journal is ready for appending, return `true` if successful
+  bool load(const std::string &filename)
+  {
+    filename_ = filename;
+    journal_.close();
+    records_ = 0;
+    if (!data_.load(filename_)) data_.clear();
+    replay();
+    return open_journal();
+  }
+
+  /// @brief Set a key-value pair and append the change to the journal.
+  /// @return Whether the record is appended successfully
+  template <typename T>
+  bool set(const std::string &sec, const std::string &key, T &&value)
+  {
+    std::string s = ini::trim(sec);
+    std::string k = ini::trim(key);
+    field &f = data_.set(s, k, std::forward<T>(value));
+    std::string record("S\t");
+    detail::journal_escape(s, record);
+    record += '\t';
+    detail::journal_escape(k, record);
+    record += '\t';
+    detail::journal_escape(f.as<std::string>(), record);
+    return append(record);
+  }
+
+  /// @brief Remove a key-value pair and append the change to the journal.
+  /// @return Return true if the key existed and the record is appended successfully
+  bool remove(const std::string &sec, const std::string &key)
+  {
+    std::string s = ini::trim(sec);
+    std::string k = ini::trim(key);
+    auto it = data_.find(s);
+    if (it == data_.end() || !it->second.remove(k)) return false;
+    std::string record("K\t");
+    detail::journal_escape(s, record);
+    record += '\t';
+    detail::journal_escape(k, record);
+    return append(record);
+  }
+
+  /// @brief Remove a section and append the change to the journal.
+  /// @return Return true if the section existed and the record is appended successfully
+  bool remove(const std::string &sec)
+  {
+    std::string s = ini::trim(sec);
+    if (!data_.remove(s)) return false;
+    std::string record("D\t");
+    detail::journal_escape(s, record);
+    return append(record);
+  }
+
+  /// @brief Fold the journal back into the base ini file and truncate the journal.
+  ///        The content is written to `<filename>.tmp` and renamed over the base file, the journal is truncated
+  ///        only after that. A crash or a full disk during the save leaves the old base file and the journal
+  ///        intact, so `load()` still recovers every change.
+  /// @return Whether the compaction is successful, return `true` if successful
+  bool compact()
+  {
+    if (filename_.empty()) return false;
+    const std::string tmp = filename_ + ".tmp";
+    if (!data_.save(tmp) || !detail::replace_file(tmp, filename_))
+    {
+      std::remove(tmp.c_str());
+      return false;
+    }
+    journal_.close();
+    records_ = 0;
+    std::ofstream truncate(journal_filename(), std::ios::binary | std::ios::trunc);
+    if (!truncate) return false;
+    truncate.close();
+    return open_journal();
+  }
+
+  /// @brief Automatically call `compact()` once the journal holds `records` records, 0 disables it (default).
+  void set_compact_threshold(std::size_t records) noexcept
+  {
+    compact_threshold_ = records;
+  }
+
+  /// @brief Number of records currently in the journal (since the last load or compaction).
+  std::size_t journal_records() const noexcept
+  {
+    return records_;
+  }
+
+  /// @brief Journal file path, `<filename>.journal`.
+  std::string journal_filename() const
+  {
+    return filename_ + ".journal";
+  }
+
+  /// @brief Get a const reference to the current ini content (base file + journal).
+  const inifile_type &data() const noexcept
+  {
+    return data_;
+  }
+
+  bool contains(const std::string &sec) const
+  {
+    return data_.contains(sec);
+  }
+  bool contains(const std::string &sec, const std::string &key) const
+  {
+    return data_.contains(sec, key);
+  }
+  field get(const std::string &sec, const std::string &key, field default_value = field{}) const
+  {
+    return data_.get(sec, key, std::move(default_value));
+  }
+
+ private:
+  /// @brief 重放日志文件, 不完整的最后一条记录会被丢弃并从日志文件中截掉
+  void replay()
+  {
+    std::string content;
+    {
+      std::ifstream is(journal_filename(), std::ios::binary);
+      if (!is) return;
+      content.assign(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>());
+    }
+    std::size_t begin = 0;
+    for (std::size_t end; (end = content.find('\n', begin)) != std::string::npos; begin = end + 1)
+    {
+      std::vector<std::string> parts = detail::split(content.substr(begin, end - begin), "\t");
+      if (parts[0] == "S" && parts.size() == 4)
+      {
+        data_.set(detail::journal_unescape(parts[1]), detail::journal_unescape(parts[2]),
+                  detail::journal_unescape(parts[3]));
+      }
+      else if (parts[0] == "K" && parts.size() == 3)
+      {
+        auto it = data_.find(detail::journal_unescape(parts[1]));
+        if (it != data_.end()) it->second.remove(detail::journal_unescape(parts[2]));
+      }
+      else if (parts[0] == "D" && parts.size() == 2)
+      {
+        data_.remove(detail::journal_unescape(parts[1]));
+      }
+      else
+      {
+        continue;  // 无法识别的记录
+      }
+      ++records_;
+    }
+    if (begin < content.size())  // 没有换行符结尾, 说明是写入中断的记录
+    {
+      std::ofstream os(journal_filename(), std::ios::binary | std::ios::trunc);
+      os.write(content.data(), static_cast<std::streamsize>(begin));
+    }
+  }
+
+  bool open_journal()
+  {
+    journal_.open(journal_filename(), std::ios::binary | std::ios::app);
+    return journal_.is_open();
+  }
+
+  bool append(std::string &record)
+  {
+    if (!journal_.is_open()) return false;
+    record += '\n';
+    journal_.write(record.data(), static_cast<std::streamsize>(record.size()));
+    journal_.flush();
+    if (!journal_) return false;
+    ++records_;
+    if (compact_threshold_ != 0 && records_ >= compact_threshold_) return compact();
+    return true;
+  }
+
+ private:
+  inifile_type data_;                 // base ini + journal
+  std::string filename_;              // base ini file path
+  std::ofstream journal_;             // journal opened in append mode
+  std::size_t records_ = 0;           // records in the journal
+  std::size_t compact_threshold_ = 0;  // auto compaction threshold, 0 disables it
+};
+
+/// @brief journaled_inifile class
+using journaled_inifile = basic_journaled_inifile<>;
+/// @brief case_insensitive_journaled_inifile class
+using case_insensitive_journaled_inifile =
+  basic_journaled_inifile<detail::case_insensitive_hash, detail::case_insensitive_equal>;
+
+}  // namespace ini
+
+#endif  // INI_FILE_JOURNAL_H_
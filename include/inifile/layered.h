@@ -0,0 +1,258 @@
+/**************************************************************************************************************
+ *~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * @file: layered.h
+ * @description: Layered configuration view (defaults -> site -> host -> overrides) without a merged copy.
+ * - `layered_view` references N `basic_inifile` layers and resolves lookups from the top layer down.
+ * - A layer may carry a Bloom filter of its (section, key) pairs, a lookup that misses in that layer then
+ *   usually costs a few bit tests instead of two hash-map probes. The filter must be rebuilt with
+ *   `refresh(index)` after the layer is modified; other layers are not affected.
+ * - The view does not own the layers, they must outlive it.
+ *
+ * @license: MIT
+ * @repository: https://github.com/abin-z/inifile
+ *~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ **************************************************************************************************************/
+
+#ifndef INI_FILE_LAYERED_H_
+#define INI_FILE_LAYERED_H_
+
+#include <inifile/inifile.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace ini
+{
+
+namespace detail
+{
+/// @brief 简单的 Bloom filter, 使用双重哈希生成 k 个位置, 每个元素约 10 位, 误判率约 1%
+class bloom_filter
+{
+ public:
+  static constexpr unsigned hash_count = 7;
+
+  void reset(std::size_t expected)
+  {
+    std::size_t bits = expected * 10;
+    std::size_t words = bits / 64 + 1;
+    words_.assign(words, 0);
+  }
+
+  void insert(std::uint64_t h) noexcept
+  {
+    const std::uint64_t step = mix64(h) | 1;
+    const std::uint64_t bits = static_cast<std::uint64_t>(words_.size()) * 64;
+    for (unsigned i = 0; i < hash_count; ++i, h += step)
+    {
+      const std::uint64_t bit = h % bits;
+      words_[bit / 64] |= std::uint64_t(1) << (bit % 64);
+    }
+  }
+
+  bool may_contain(std::uint64_t h) const noexcept
+  {
+    const std::uint64_t step = mix64(h) | 1;
+    const std::uint64_t bits = static_cast<std::uint64_t>(words_.size()) * 64;
+    for (unsigned i = 0; i < hash_count; ++i, h += step)
+    {
+      const std::uint64_t bit = h % bits;
+      if ((words_[bit / 64] & (std::uint64_t(1) << (bit % 64))) == 0) return false;
+    }
+    return true;
+  }
+
+ private:
+  std::vector<std::uint64_t> words_;
+};
+}  // namespace detail
+
+/// @brief Read-only view resolving lookups across several inifile layers, later layers override earlier ones
+template <typename Hash = std::hash<std::string>, typename Equal = std::equal_to<std::string>,
+          template <typename...> class Map = std::unordered_map>
+class basic_layered_view
+{
+ public:
+  using inifile_type = basic_inifile<Hash, Equal, Map>;
+  using section_type = basic_section<Hash, Equal, Map>;
+
+  basic_layered_view() = default;
+
+  /// @brief Add a layer on top of the existing ones (highest priority).
+  /// @param layer Referenced, not copied. It must outlive the view.
+  /// @param use_bloom_filter Build a Bloom filter of the layer's keys to make misses cheap
+  /// @return Index of the new layer (0 is the bottom layer)
+  std::size_t push_layer(const inifile_type &layer, bool use_bloom_filter = false)
+  {
+    layers_.push_back(layer_entry{&layer, use_bloom_filter, detail::bloom_filter()});
+    if (use_bloom_filter) rebuild(layers_.back());
+    return layers_.size() - 1;
+  }
+
+  /// @brief Remove the top layer.
+  void pop_layer()
+  {
+    if (!layers_.empty()) layers_.pop_back();
+  }
+
+  /// @brief Rebuild the Bloom filter of a layer after it was modified. Other layers are not touched.
+  /// @throws `std::out_of_range` if index is invalid
+  void refresh(std::size_t index)
+  {
+    layer_entry &entry = layers_.at(index);
+    if (entry.use_bloom) rebuild(entry);
+  }
+
+  /// @brief Number of layers.
+  std::size_t size() const noexcept
+  {
+    return layers_.size();
+  }
+
+  void clear() noexcept
+  {
+    layers_.clear();
+  }
+
+  /// @brief Get a layer by index.
+  const inifile_type &layer(std::size_t index) const
+  {
+    return *layers_.at(index).inif;
+  }
+
+  /// @brief Find the field of the topmost layer defining it.
+  /// @return Pointer to the field inside that layer, nullptr if no layer defines it
+  const field *find(const std::string &sec, const std::string &key) const
+  {
+    std::string sec_buffer, key_buffer;
+    return find_trimmed(detail::trimmed(sec, sec_buffer), detail::trimmed(key, key_buffer), nullptr);
+  }
+
+  /// @brief Index of the topmost layer defining the key, -1 if no layer defines it.
+  int layer_of(const std::string &sec, const std::string &key) const
+  {
+    std::string sec_buffer, key_buffer;
+    std::size_t index = 0;
+    const field *f = find_trimmed(detail::trimmed(sec, sec_buffer), detail::trimmed(key, key_buffer), &index);
+    return f ? static_cast<int>(index) : -1;
+  }
+
+  /// @brief Check if the section exists in any layer.
+  bool contains(const std::string &sec) const
+  {
+    std::string buffer;
+    const std::string &s = detail::trimmed(sec, buffer);
+    for (const layer_entry &entry : layers_)
+    {
+      if (entry.inif->find(s) != entry.inif->end()) return true;
+    }
+    return false;
+  }
+
+  /// @brief Check if the key exists in any layer.
+  bool contains(const std::string &sec, const std::string &key) const
+  {
+    return find(sec, key) != nullptr;
+  }
+
+  /// @brief Returns a reference to the field of the topmost layer defining it.
+  /// @throws `std::out_of_range` if no layer defines the key
+  const field &at(const std::string &sec, const std::string &key) const
+  {
+    const field *f = find(sec, key);
+    if (!f) throw std::out_of_range("ini::layered_view::at: key not found");
+    return *f;
+  }
+
+  /// @brief Returns the field value of the topmost layer defining it
+  /// @param default_value the default value will be returned if no layer defines the key
+  /// @return field value(a copy)
+  field get(const std::string &sec, const std::string &key, field default_value = field{}) const
+  {
+    const field *f = find(sec, key);
+    return f ? *f : default_value;
+  }
+
+  /// @brief Merge all layers into one inifile (upper layers override keys and section comments).
+  inifile_type flatten() const
+  {
+    inifile_type result;
+    for (const layer_entry &entry : layers_)
+    {
+      for (const auto &sec : *entry.inif)
+      {
+        section_type &target = result[sec.first];
+        if (!sec.second.comment().empty()) target.set_comment(sec.second.comment());
+        for (const auto &kv : sec.second) target.set(kv.first, kv.second);
+      }
+    }
+    return result;
+  }
+
+ private:
+  struct layer_entry
+  {
+    const inifile_type *inif;
+    bool use_bloom;
+    detail::bloom_filter bloom;
+  };
+
+  std::uint64_t key_hash(const std::string &sec, const std::string &key) const
+  {
+    // 与 Hash 保持一致, 大小写不敏感的层中只在大小写上不同的键得到相同的哈希值
+    return detail::mix64(static_cast<std::uint64_t>(hash_(sec))) ^ static_cast<std::uint64_t>(hash_(key));
+  }
+
+  void rebuild(layer_entry &entry) const
+  {
+    std::size_t count = 0;
+    for (const auto &sec : *entry.inif) count += sec.second.size();
+    entry.bloom.reset(count);
+    for (const auto &sec : *entry.inif)
+    {
+      for (const auto &kv : sec.second) entry.bloom.insert(key_hash(sec.first, kv.first));
+    }
+  }
+
+  const field *find_trimmed(const std::string &sec, const std::string &key, std::size_t *index) const
+  {
+    std::uint64_t h = 0;
+    bool hashed = false;  // 只有遇到带 Bloom filter 的层时才计算哈希
+    for (std::size_t i = layers_.size(); i-- > 0;)
+    {
+      const layer_entry &entry = layers_[i];
+      if (entry.use_bloom)
+      {
+        if (!hashed)
+        {
+          h = key_hash(sec, key);
+          hashed = true;
+        }
+        if (!entry.bloom.may_contain(h)) continue;  // 该层一定没有这个键
+      }
+      auto sec_it = entry.inif->find(sec);
+      if (sec_it == entry.inif->end()) continue;
+      auto it = sec_it->second.find(key);
+      if (it == sec_it->second.end()) continue;
+      if (index) *index = i;
+      return &it->second;
+    }
+    return nullptr;
+  }
+
+ private:
+  Hash hash_;
+  std::vector<layer_entry> layers_;
+};
+
+/// @brief layered_view class
+using layered_view = basic_layered_view<>;
+/// @brief case_insensitive_layered_view class
+using case_insensitive_layered_view = basic_layered_view<detail::case_insensitive_hash, detail::case_insensitive_equal>;
+
+}  // namespace ini
+
+#endif  // INI_FILE_LAYERED_H_
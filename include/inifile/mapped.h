@@ -0,0 +1,604 @@
+/**************************************************************************************************************
+ *~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * @file: mapped.h
+ * @description: Read-only config image that is used in place after `mmap`, without parsing.
+ * - `ini::save_image()` writes a `basic_inifile` as an image: offset-based (pointer-free) section and key
+ *   tables, an embedded open-addressing hash index per table, and 8-byte aligned tables.
+ * - `ini::mapped_inifile` maps the image read-only and answers `get` / `contains` / `as<T>` directly against
+ *   the mapping, with no per-process heap for the content. Processes mapping the same image share one
+ *   physical copy through the page cache.
+ * - Comments are not stored in the image. The image uses native byte order and is rejected on a host
+ *   with a different byte order.
+ *
+ * @license: MIT
+ * @repository: https://github.com/abin-z/inifile
+ *~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ **************************************************************************************************************/
+
+#ifndef INI_FILE_MAPPED_H_
+#define INI_FILE_MAPPED_H_
+
+#include <inifile/inifile.h>
+
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ini
+{
+
+namespace detail
+{
+/// @brief 映像文件头, 所有偏移量都相对于映像起始地址
+struct image_header
+{
+  char magic[8];                        // "INIMAGE"
+  std::uint32_t version;                // 格式版本
+  std::uint32_t byte_order;             // 0x01020304, 用于检测字节序
+  std::uint64_t total_size;             // 映像总大小
+  std::uint32_t flags;                  // image_case_insensitive
+  std::uint32_t section_count;          // section 数量
+  std::uint32_t key_count;              // key 总数
+  std::uint32_t section_buckets;        // section 哈希索引的桶数(2的幂)
+  std::uint64_t sections_offset;        // image_section[section_count]
+  std::uint64_t section_index_offset;   // std::uint32_t[section_buckets], 存放 section 下标 + 1, 0 表示空桶
+  std::uint64_t keys_offset;            // image_key[key_count]
+  std::uint64_t key_index_offset;       // std::uint32_t[], 每个 section 一段, 存放段内 key 下标 + 1
+  std::uint64_t key_index_size;         // key 哈希索引的总桶数
+  std::uint64_t strings_offset;         // 字符串表
+  std::uint64_t strings_size;           // 字符串表大小
+  std::uint64_t fingerprint;            // 源内容的 fingerprint()
+};
+
+struct image_section
+{
+  std::uint64_t hash;
+  std::uint32_t name_offset;  // 相对字符串表
+  std::uint32_t name_length;
+  std::uint32_t first_key;
+  std::uint32_t key_count;
+  std::uint32_t index_offset;   // 在 key 哈希索引中的起始桶
+  std::uint32_t index_buckets;  // 桶数(2的幂)
+};
+
+struct image_key
+{
+  std::uint64_t hash;
+  std::uint32_t key_offset;  // 相对字符串表
+  std::uint32_t key_length;
+  std::uint32_t value_offset;
+  std::uint32_t value_length;
+};
+
+enum : std::uint32_t
+{
+  image_version = 1,
+  image_byte_order = 0x01020304,
+  image_case_insensitive = 1
+};
+
+inline std::uint64_t image_hash(const char *data, std::size_t size, bool case_insensitive) noexcept
+{
+  std::uint64_t h = 14695981039346656037ULL;
+  for (std::size_t i = 0; i < size; ++i)
+  {
+    unsigned char c = static_cast<unsigned char>(data[i]);
+    if (case_insensitive) c = static_cast<unsigned char>(std::tolower(c));
+    h ^= c;
+    h *= 1099511628211ULL;
+  }
+  return mix64(h);
+}
+
+inline bool image_equal(const char *a, const char *b, std::size_t size, bool case_insensitive) noexcept
+{
+  if (!case_insensitive) return std::memcmp(a, b, size) == 0;
+  for (std::size_t i = 0; i < size; ++i)
+  {
+    if (std::tolower(static_cast<unsigned char>(a[i])) != std::tolower(static_cast<unsigned char>(b[i])))
+      return false;
+  }
+  return true;
+}
+
+/// @brief 去除两端空白, 不分配内存
+inline void image_trim(const char *&data, std::size_t &size) noexcept
+{
+  while (size > 0 && std::strchr(whitespaces, data[0]) != nullptr && data[0] != '\0')
+  {
+    ++data;
+    --size;
+  }
+  while (size > 0 && std::strchr(whitespaces, data[size - 1]) != nullptr && data[size - 1] != '\0') --size;
+}
+
+inline std::uint32_t image_buckets(std::size_t count) noexcept
+{
+  std::uint32_t buckets = 1;
+  while (buckets < count * 2) buckets <<= 1;  // 负载因子不超过 0.5
+  return buckets;
+}
+
+inline std::size_t align8(std::size_t n) noexcept
+{
+  return (n + 7) & ~static_cast<std::size_t>(7);
+}
+
+/// @brief 将条目下标插入开放寻址哈希索引
+inline void image_index_insert(std::uint32_t *buckets, std::uint32_t bucket_count, std::uint64_t hash,
+                               std::uint32_t index) noexcept
+{
+  std::uint32_t b = static_cast<std::uint32_t>(hash) & (bucket_count - 1);
+  while (buckets[b] != 0) b = (b + 1) & (bucket_count - 1);
+  buckets[b] = index + 1;
+}
+}  // namespace detail
+
+/// @brief Build the read-only image of an ini document (see `mapped_inifile`).
+/// @return The image bytes, empty if the content exceeds the 4GB string table limit
+template <typename Hash, typename Equal, template <typename...> class Map, typename Allocator, typename CommentPolicy>
+std::string build_image(const basic_inifile<Hash, Equal, Map, Allocator, CommentPolicy> &content)
+{
+  const bool ci = std::is_same<Equal, detail::case_insensitive_equal>::value;
+  std::vector<detail::image_section> sections;
+  std::vector<detail::image_key> keys;
+  std::string strings;
+  sections.reserve(content.size());
+  auto add_string = [&strings](detail::char_range str, std::uint32_t &offset, std::uint32_t &length) {
+    offset = static_cast<std::uint32_t>(strings.size());
+    length = static_cast<std::uint32_t>(str.size);
+    strings.append(str.data, str.size);
+  };
+
+  std::uint64_t key_index_size = 0;
+  for (const auto &sec : content)
+  {
+    detail::image_section s = {};
+    s.hash = detail::image_hash(sec.first.data(), sec.first.size(), ci);
+    add_string(detail::chars_of(sec.first), s.name_offset, s.name_length);
+    s.first_key = static_cast<std::uint32_t>(keys.size());
+    s.key_count = static_cast<std::uint32_t>(sec.second.size());
+    s.index_offset = static_cast<std::uint32_t>(key_index_size);
+    s.index_buckets = detail::image_buckets(sec.second.size());
+    key_index_size += s.index_buckets;
+    for (const auto &kv : sec.second)
+    {
+      detail::image_key k = {};
+      k.hash = detail::image_hash(kv.first.data(), kv.first.size(), ci);
+      add_string(detail::chars_of(kv.first), k.key_offset, k.key_length);
+      add_string(detail::chars_of(kv.second.str()), k.value_offset, k.value_length);
+      keys.push_back(k);
+    }
+    sections.push_back(s);
+  }
+  if (strings.size() > 0xFFFFFFFFu || key_index_size > 0xFFFFFFFFu) return std::string();
+
+  detail::image_header header = {};
+  std::memcpy(header.magic, "INIMAGE", 8);
+  header.version = detail::image_version;
+  header.byte_order = detail::image_byte_order;
+  header.flags = ci ? static_cast<std::uint32_t>(detail::image_case_insensitive) : 0u;
+  header.section_count = static_cast<std::uint32_t>(sections.size());
+  header.key_count = static_cast<std::uint32_t>(keys.size());
+  header.section_buckets = detail::image_buckets(sections.size());
+  header.key_index_size = key_index_size;
+  header.fingerprint = content.fingerprint();
+
+  std::size_t offset = detail::align8(sizeof(detail::image_header));
+  header.sections_offset = offset;
+  offset = detail::align8(offset + sections.size() * sizeof(detail::image_section));
+  header.section_index_offset = offset;
+  offset = detail::align8(offset + header.section_buckets * sizeof(std::uint32_t));
+  header.keys_offset = offset;
+  offset = detail::align8(offset + keys.size() * sizeof(detail::image_key));
+  header.key_index_offset = offset;
+  offset = detail::align8(offset + static_cast<std::size_t>(key_index_size) * sizeof(std::uint32_t));
+  header.strings_offset = offset;
+  header.strings_size = strings.size();
+  header.total_size = offset + strings.size();
+
+  std::string image(static_cast<std::size_t>(header.total_size), '\0');
+  char *base = &image[0];
+  std::memcpy(base, &header, sizeof(header));
+  if (!sections.empty())
+  {
+    std::memcpy(base + header.sections_offset, sections.data(), sections.size() * sizeof(detail::image_section));
+  }
+  if (!keys.empty()) std::memcpy(base + header.keys_offset, keys.data(), keys.size() * sizeof(detail::image_key));
+  if (!strings.empty()) std::memcpy(base + header.strings_offset, strings.data(), strings.size());
+
+  // 哈希索引
+  std::vector<std::uint32_t> section_index(header.section_buckets, 0);
+  for (std::uint32_t i = 0; i < sections.size(); ++i)
+  {
+    detail::image_index_insert(section_index.data(), header.section_buckets, sections[i].hash, i);
+  }
+  std::memcpy(base + header.section_index_offset, section_index.data(), section_index.size() * sizeof(std::uint32_t));
+  std::vector<std::uint32_t> key_index(static_cast<std::size_t>(key_index_size), 0);
+  for (const auto &s : sections)
+  {
+    for (std::uint32_t i = 0; i < s.key_count; ++i)
+    {
+      detail::image_index_insert(key_index.data() + s.index_offset, s.index_buckets, keys[s.first_key + i].hash, i);
+    }
+  }
+  if (!key_index.empty())
+  {
+    std::memcpy(base + header.key_index_offset, key_index.data(), key_index.size() * sizeof(std::uint32_t));
+  }
+  return image;
+}
+
+/// @brief Write the read-only image of an ini document to a file, to be opened with `mapped_inifile`.
+/// @return Whether the save is successful, return `true` if successful
+template <typename Hash, typename Equal, template <typename...> class Map, typename Allocator, typename CommentPolicy>
+bool save_image(const basic_inifile<Hash, Equal, Map, Allocator, CommentPolicy> &content, const std::string &filename)
+{
+  const std::string image = build_image(content);
+  return !image.empty() && detail::write_file(filename, image);
+}
+
+/// @brief A value inside a mapped image, valid while the image stays mapped.
+class mapped_value
+{
+ public:
+  mapped_value() = default;
+  mapped_value(const char *data, std::size_t size) : data_(data), size_(size) {}
+
+  /// @brief Whether the key exists.
+  explicit operator bool() const noexcept
+  {
+    return data_ != nullptr;
+  }
+
+  const char *data() const noexcept
+  {
+    return data_;
+  }
+  std::size_t size() const noexcept
+  {
+    return size_;
+  }
+
+#ifdef __cpp_lib_string_view
+  /// @brief View of the value inside the mapping (no copy).
+  std::string_view view() const noexcept
+  {
+    return data_ ? std::string_view(data_, size_) : std::string_view();
+  }
+#endif
+
+  /// @brief Copy of the value.
+  std::string str() const
+  {
+    return data_ ? std::string(data_, size_) : std::string();
+  }
+
+  /// @brief Convert the value to type T with the same rules as `field::as<T>()`.
+  ///        `std::string_view` returns `view()` (no copy). Pointer types are rejected at compile time
+  ///        because the values in the mapping are not NUL-terminated, use `data()`/`size()` instead.
+  template <typename T>
+  T as() const
+  {
+    static_assert(!std::is_pointer<T>::value,
+                  "mapped values are not NUL-terminated, use data()/size() or view() instead of as<const char *>()");
+    return decode(static_cast<T *>(nullptr));
+  }
+
+ private:
+  template <typename T>
+  T decode(T *) const
+  {
+    const std::string value = str();  // convert<T>::decode 不能保留指向局部副本的指针, 见 as() 的限制
+    T result;
+    detail::convert<T>::decode(value, result);
+    return result;
+  }
+  std::string decode(std::string *) const
+  {
+    return str();
+  }
+#ifdef __cpp_lib_string_view
+  std::string_view decode(std::string_view *) const
+  {
+    return view();
+  }
+#endif
+
+  const char *data_ = nullptr;
+  std::size_t size_ = 0;
+};
+
+/// @brief Read-only view of an ini image mapped into memory
+class mapped_inifile
+{
+ public:
+  mapped_inifile() = default;
+  ~mapped_inifile()
+  {
+    close();
+  }
+
+  mapped_inifile(const mapped_inifile &) = delete;
+  mapped_inifile &operator=(const mapped_inifile &) = delete;
+
+  mapped_inifile(mapped_inifile &&other) noexcept :
+    base_(other.base_),
+    size_(other.size_),
+    mapping_(other.mapping_),
+    mapping_size_(other.mapping_size_),
+    owned_(std::move(other.owned_))
+  {
+    other.base_ = nullptr;
+    other.size_ = 0;
+    other.mapping_ = nullptr;
+    other.mapping_size_ = 0;
+  }
+  mapped_inifile &operator=(mapped_inifile &&rhs) noexcept
+  {
+    mapped_inifile temp(std::move(rhs));
+    std::swap(base_, temp.base_);
+    std::swap(size_, temp.size_);
+    std::swap(mapping_, temp.mapping_);
+    std::swap(mapping_size_, temp.mapping_size_);
+    owned_.swap(temp.owned_);
+    return *this;
+  }
+
+  /// @brief Map an image file read-only (POSIX `mmap`; on Windows the file is read into memory).
+  /// @return Return false if the file cannot be mapped or is not a valid image
+  bool open(const std::string &filename)
+  {
+    close();
+#if !defined(_WIN32)
+    const int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size <= 0)
+    {
+      ::close(fd);
+      return false;
+    }
+    void *p = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);  // 映射建立后即可关闭文件描述符
+    if (p == MAP_FAILED) return false;
+    mapping_ = p;
+    mapping_size_ = static_cast<std::size_t>(st.st_size);
+    if (!attach(p, static_cast<std::size_t>(st.st_size)))
+    {
+      close();
+      return false;
+    }
+    return true;
+#else
+    std::string bytes;
+    if (!detail::read_file(filename, bytes)) return false;
+    owned_.assign((bytes.size() + 7) / 8, 0);  // 保证 8 字节对齐
+    if (!bytes.empty()) std::memcpy(owned_.data(), bytes.data(), bytes.size());
+    if (!attach(owned_.data(), bytes.size()))
+    {
+      close();
+      return false;
+    }
+    return true;
+#endif
+  }
+
+  /// @brief Use an image that lives in memory owned by the caller (e.g. shared memory).
+  ///        The memory must stay valid and unchanged while the view is used.
+  /// @return Return false if the memory is not a valid, 8-byte aligned image
+  bool attach(const void *data, std::size_t size)
+  {
+    const char *base = static_cast<const char *>(data);
+    if (!validate(base, size)) return false;
+    base_ = base;
+    size_ = size;
+    return true;
+  }
+
+  /// @brief Unmap the image.
+  void close() noexcept
+  {
+#if !defined(_WIN32)
+    if (mapping_) ::munmap(mapping_, mapping_size_);
+#endif
+    mapping_ = nullptr;
+    mapping_size_ = 0;
+    base_ = nullptr;
+    size_ = 0;
+    owned_.clear();
+  }
+
+  bool is_open() const noexcept
+  {
+    return base_ != nullptr;
+  }
+
+  /// @brief Number of sections.
+  std::size_t size() const noexcept
+  {
+    return base_ ? header().section_count : 0;
+  }
+
+  /// @brief `fingerprint()` of the document the image was built from.
+  std::uint64_t fingerprint() const noexcept
+  {
+    return base_ ? header().fingerprint : 0;
+  }
+
+  bool contains(const std::string &sec) const noexcept
+  {
+    return find_section(sec) != nullptr;
+  }
+
+  bool contains(const std::string &sec, const std::string &key) const noexcept
+  {
+    return static_cast<bool>(get(sec, key));
+  }
+
+  /// @brief Look up a value, the result evaluates to false if the section or key does not exist.
+  mapped_value get(const std::string &sec, const std::string &key) const noexcept
+  {
+    const detail::image_section *s = find_section(sec);
+    if (!s) return mapped_value();
+    const char *k = key.data();
+    std::size_t len = key.size();
+    detail::image_trim(k, len);
+    const bool ci = (header().flags & detail::image_case_insensitive) != 0;
+    const std::uint64_t h = detail::image_hash(k, len, ci);
+    const std::uint32_t *index = table<std::uint32_t>(header().key_index_offset) + s->index_offset;
+    const detail::image_key *keys = table<detail::image_key>(header().keys_offset) + s->first_key;
+    for (std::uint32_t b = static_cast<std::uint32_t>(h) & (s->index_buckets - 1); index[b] != 0;
+         b = (b + 1) & (s->index_buckets - 1))
+    {
+      const detail::image_key &e = keys[index[b] - 1];
+      if (e.hash == h && e.key_length == len && detail::image_equal(string_at(e.key_offset), k, len, ci))
+      {
+        return mapped_value(string_at(e.value_offset), e.value_length);
+      }
+    }
+    return mapped_value();
+  }
+
+  /// @brief Look up and convert a value, returns `default_value` if the section or key does not exist.
+  template <typename T>
+  T get(const std::string &sec, const std::string &key, T default_value) const
+  {
+    mapped_value v = get(sec, key);
+    return v ? v.as<T>() : default_value;
+  }
+
+  /// @brief All section names.
+  std::vector<std::string> sections() const
+  {
+    std::vector<std::string> result;
+    if (!base_) return result;
+    const detail::image_section *s = table<detail::image_section>(header().sections_offset);
+    for (std::uint32_t i = 0; i < header().section_count; ++i)
+    {
+      result.emplace_back(string_at(s[i].name_offset), s[i].name_length);
+    }
+    return result;
+  }
+
+ private:
+  const detail::image_header &header() const noexcept
+  {
+    return *reinterpret_cast<const detail::image_header *>(base_);
+  }
+
+  template <typename T>
+  const T *table(std::uint64_t offset) const noexcept
+  {
+    return reinterpret_cast<const T *>(base_ + offset);
+  }
+
+  const char *string_at(std::uint32_t offset) const noexcept
+  {
+    return base_ + header().strings_offset + offset;
+  }
+
+  const detail::image_section *find_section(const std::string &sec) const noexcept
+  {
+    if (!base_) return nullptr;
+    const char *name = sec.data();
+    std::size_t len = sec.size();
+    detail::image_trim(name, len);
+    const bool ci = (header().flags & detail::image_case_insensitive) != 0;
+    const std::uint64_t h = detail::image_hash(name, len, ci);
+    const std::uint32_t *index = table<std::uint32_t>(header().section_index_offset);
+    const detail::image_section *sections = table<detail::image_section>(header().sections_offset);
+    const std::uint32_t mask = header().section_buckets - 1;
+    for (std::uint32_t b = static_cast<std::uint32_t>(h) & mask; index[b] != 0; b = (b + 1) & mask)
+    {
+      const detail::image_section &s = sections[index[b] - 1];
+      if (s.hash == h && s.name_length == len && detail::image_equal(string_at(s.name_offset), name, len, ci))
+      {
+        return &s;
+      }
+    }
+    return nullptr;
+  }
+
+  /// @brief 校验映像: 所有表和字符串都在映像范围内, 对齐正确, 索引中的下标有效且每个哈希表至少有一个空桶
+  static bool validate(const char *base, std::size_t size) noexcept
+  {
+    if (!base || reinterpret_cast<std::uintptr_t>(base) % 8 != 0 || size < sizeof(detail::image_header)) return false;
+    const auto &h = *reinterpret_cast<const detail::image_header *>(base);
+    if (std::memcmp(h.magic, "INIMAGE", 8) != 0 || h.version != detail::image_version ||
+        h.byte_order != detail::image_byte_order || h.total_size != size)
+      return false;
+    auto is_pow2 = [](std::uint64_t n) { return n != 0 && (n & (n - 1)) == 0; };
+    auto fits = [size](std::uint64_t offset, std::uint64_t count, std::uint64_t elem) {
+      return offset % 8 == 0 && offset <= size && count <= (size - offset) / elem;
+    };
+    if (!is_pow2(h.section_buckets) || h.section_buckets < h.section_count * 2ULL ||
+        !fits(h.sections_offset, h.section_count, sizeof(detail::image_section)) ||
+        !fits(h.section_index_offset, h.section_buckets, sizeof(std::uint32_t)) ||
+        !fits(h.keys_offset, h.key_count, sizeof(detail::image_key)) ||
+        !fits(h.key_index_offset, h.key_index_size, sizeof(std::uint32_t)) || h.strings_offset > size ||
+        h.strings_size != size - h.strings_offset)
+      return false;
+
+    auto valid_string = [&h](std::uint32_t offset, std::uint32_t length) {
+      return offset <= h.strings_size && length <= h.strings_size - offset;
+    };
+    const std::uint32_t *section_index = reinterpret_cast<const std::uint32_t *>(base + h.section_index_offset);
+    std::uint64_t used = 0;
+    for (std::uint32_t b = 0; b < h.section_buckets; ++b)
+    {
+      if (section_index[b] > h.section_count) return false;
+      if (section_index[b] != 0) ++used;
+    }
+    if (used != h.section_count) return false;  // 保证探测一定能遇到空桶
+    const auto *sections = reinterpret_cast<const detail::image_section *>(base + h.sections_offset);
+    const auto *keys = reinterpret_cast<const detail::image_key *>(base + h.keys_offset);
+    const std::uint32_t *key_index = reinterpret_cast<const std::uint32_t *>(base + h.key_index_offset);
+    for (std::uint32_t i = 0; i < h.section_count; ++i)
+    {
+      const auto &s = sections[i];
+      if (!valid_string(s.name_offset, s.name_length) || s.first_key > h.key_count ||
+          s.key_count > h.key_count - s.first_key || !is_pow2(s.index_buckets) ||
+          s.index_buckets < s.key_count * 2ULL || s.index_offset > h.key_index_size ||
+          s.index_buckets > h.key_index_size - s.index_offset)
+        return false;
+      used = 0;
+      for (std::uint32_t b = 0; b < s.index_buckets; ++b)
+      {
+        if (key_index[s.index_offset + b] > s.key_count) return false;
+        if (key_index[s.index_offset + b] != 0) ++used;
+      }
+      if (used != s.key_count) return false;
+    }
+    for (std::uint32_t i = 0; i < h.key_count; ++i)
+    {
+      if (!valid_string(keys[i].key_offset, keys[i].key_length) ||
+          !valid_string(keys[i].value_offset, keys[i].value_length))
+        return false;
+    }
+    return true;
+  }
+
+ private:
+  const char *base_ = nullptr;        // 映像起始地址
+  std::size_t size_ = 0;              // 映像大小
+  void *mapping_ = nullptr;           // mmap 返回的地址, 为空表示不是由 open() 映射的
+  std::size_t mapping_size_ = 0;      // 映射长度
+  std::vector<std::uint64_t> owned_;  // 不支持 mmap 的平台上保存文件内容
+};
+
+}  // namespace ini
+
+#endif  // INI_FILE_MAPPED_H_
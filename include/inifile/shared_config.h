@@ -0,0 +1,195 @@
+/**************************************************************************************************************
+ *~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * @file: shared_config.h
+ * @description: Lock-free read path for a frequently read, rarely updated configuration (RCU-style).
+ * - Writers build a new immutable `basic_inifile` and publish it as a `std::shared_ptr<const basic_inifile>`.
+ * - Each reader thread owns a `reader` handle that caches the pinned snapshot. On every access the handle
+ *   only performs one acquire load of the version counter (a read-only shared cache line), and re-pins the
+ *   snapshot only after a new version has been published. Old snapshots are freed once the last reader
+ *   re-pins (or drops) them.
+ *
+ * @license: MIT
+ * @repository: https://github.com/abin-z/inifile
+ *~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ **************************************************************************************************************/
+
+#ifndef INI_FILE_SHARED_CONFIG_H_
+#define INI_FILE_SHARED_CONFIG_H_
+
+#include <inifile/inifile.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+namespace ini
+{
+
+namespace detail
+{
+/// @brief 原子的 shared_ptr, C++20 使用 std::atomic<std::shared_ptr>, 否则使用 std::atomic_load/std::atomic_store
+template <typename T>
+class atomic_shared_ptr
+{
+ public:
+  explicit atomic_shared_ptr(std::shared_ptr<T> ptr) : ptr_(std::move(ptr)) {}
+
+  std::shared_ptr<T> load() const noexcept
+  {
+#if defined(__cpp_lib_atomic_shared_ptr)
+    return ptr_.load(std::memory_order_acquire);
+#else
+    return std::atomic_load_explicit(&ptr_, std::memory_order_acquire);
+#endif
+  }
+
+  void store(std::shared_ptr<T> ptr) noexcept
+  {
+#if defined(__cpp_lib_atomic_shared_ptr)
+    ptr_.store(std::move(ptr), std::memory_order_release);
+#else
+    std::atomic_store_explicit(&ptr_, std::move(ptr), std::memory_order_release);
+#endif
+  }
+
+ private:
+#if defined(__cpp_lib_atomic_shared_ptr)
+  std::atomic<std::shared_ptr<T>> ptr_;
+#else
+  std::shared_ptr<T> ptr_;
+#endif
+};
+}  // namespace detail
+
+/// @brief Configuration published as immutable snapshots, readers never take a lock
+template <typename Hash = std::hash<std::string>, typename Equal = std::equal_to<std::string>,
+          template <typename...> class Map = std::unordered_map>
+class basic_shared_config
+{
+ public:
+  using inifile_type = basic_inifile<Hash, Equal, Map>;
+  using snapshot_type = std::shared_ptr<const inifile_type>;
+
+  /// @brief Per-thread reader handle. A handle must not be shared between threads.
+  class reader
+  {
+   public:
+    explicit reader(const basic_shared_config &config) :
+      config_(&config), version_(config.version()), snapshot_(config.snapshot())
+    {
+    }
+
+    /// @brief Get the pinned snapshot, re-pinning it first if a newer version has been published.
+    ///        The reference stays valid until the next call to `get()` on this handle.
+    const inifile_type &get()
+    {
+      const std::uint64_t latest = config_->version();
+      if (latest != version_)  // 慢路径: 只在发布新版本后执行一次
+      {
+        version_ = latest;
+        snapshot_ = config_->snapshot();
+      }
+      return *snapshot_;
+    }
+
+    const inifile_type *operator->()
+    {
+      return &get();
+    }
+
+    /// @brief Version of the pinned snapshot.
+    std::uint64_t version() const noexcept
+    {
+      return version_;
+    }
+
+   private:
+    const basic_shared_config *config_;
+    std::uint64_t version_;
+    snapshot_type snapshot_;
+  };
+
+  basic_shared_config() : current_(std::make_shared<const inifile_type>()) {}
+  explicit basic_shared_config(inifile_type initial) :
+    current_(std::make_shared<const inifile_type>(std::move(initial)))
+  {
+  }
+
+  basic_shared_config(const basic_shared_config &) = delete;
+  basic_shared_config &operator=(const basic_shared_config &) = delete;
+
+  /// @brief Create a reader handle for the calling thread.
+  reader make_reader() const
+  {
+    return reader(*this);
+  }
+
+  /// @brief Get the current snapshot (takes a reference count, prefer `reader` on hot paths).
+  snapshot_type snapshot() const
+  {
+    return current_.load();
+  }
+
+  /// @brief Version counter, incremented by every publication.
+  std::uint64_t version() const noexcept
+  {
+    return version_.load(std::memory_order_acquire);
+  }
+
+  /// @brief Publish a new version, readers switch to it on their next access.
+  void publish(inifile_type next)
+  {
+    std::lock_guard<std::mutex> lock(writer_mutex_);
+    publish_locked(std::make_shared<const inifile_type>(std::move(next)));
+  }
+
+  /// @brief Copy the current version, let `fn` modify the copy and publish it.
+  ///        Concurrent updates are serialized, so no update is lost.
+  /// @param fn Callable with signature `void(inifile_type &)`
+  template <typename Fn>
+  void update(Fn &&fn)
+  {
+    std::lock_guard<std::mutex> lock(writer_mutex_);
+    auto next = std::make_shared<inifile_type>(*current_.load());
+    fn(*next);
+    publish_locked(std::move(next));
+  }
+
+  /// @brief Load an ini file and publish it.
+  /// @return Whether the loading is successful, nothing is published on failure
+  bool load(const std::string &filename)
+  {
+    inifile_type next;
+    if (!next.load(filename)) return false;
+    publish(std::move(next));
+    return true;
+  }
+
+ private:
+  void publish_locked(snapshot_type next)
+  {
+    current_.store(std::move(next));                   // 先发布快照
+    version_.fetch_add(1, std::memory_order_release);  // 再递增版本号, 读者看到新版本号时一定能取到新快照
+  }
+
+ private:
+  // version_ 前后填充, 独占缓存行(只在发布时写入), 避免与其他数据发生伪共享;
+  // 不使用 alignas(64), 以免在 C++17 之前的 operator new 下产生过对齐问题
+  char pad_before_[64] = {};
+  std::atomic<std::uint64_t> version_{0};
+  char pad_after_[64 - sizeof(std::atomic<std::uint64_t>)] = {};
+  detail::atomic_shared_ptr<const inifile_type> current_;
+  std::mutex writer_mutex_;
+};
+
+/// @brief shared_config class
+using shared_config = basic_shared_config<>;
+/// @brief case_insensitive_shared_config class
+using case_insensitive_shared_config =
+  basic_shared_config<detail::case_insensitive_hash, detail::case_insensitive_equal>;
+
+}  // namespace ini
+
+#endif  // INI_FILE_SHARED_CONFIG_H_
@@ -0,0 +1,307 @@
+/**************************************************************************************************************
+ *~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * @file: shm.h
+ * @description: Publish an ini document to POSIX shared memory for multi-process deployments.
+ * - `shm_publisher` serializes a `basic_inifile` as a read-only image (see `mapped.h`) into a new shared memory
+ *   segment `<name>.<generation>` and then bumps the generation counter in the control segment `<name>`.
+ * - `shm_reader` attaches read-only and answers lookups in place (`mapped_inifile`), without copying.
+ *   `refresh()` detects a new generation and switches over atomically; the previous mapping stays valid
+ *   until the switch, so a worker never observes a half-written document.
+ * - POSIX only (`shm_open` / `mmap`).
+ *
+ * @license: MIT
+ * @repository: https://github.com/abin-z/inifile
+ *~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ **************************************************************************************************************/
+
+#ifndef INI_FILE_SHM_H_
+#define INI_FILE_SHM_H_
+
+#include <inifile/mapped.h>
+
+#if !defined(_WIN32)
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+#include <utility>
+
+namespace ini
+{
+
+namespace detail
+{
+/// @brief 控制段: 只包含当前代数, 发布者写入, 读者只读映射
+struct shm_control
+{
+  char magic[8];                         // "INISHM"
+  std::atomic<std::uint64_t> generation;  // 0 表示尚未发布
+};
+
+inline std::string shm_segment_name(const std::string &name, std::uint64_t generation)
+{
+  return name + "." + std::to_string(generation);
+}
+
+/// @brief 共享内存映射的 RAII 封装
+class shm_mapping
+{
+ public:
+  shm_mapping() = default;
+  ~shm_mapping()
+  {
+    reset();
+  }
+  shm_mapping(const shm_mapping &) = delete;
+  shm_mapping &operator=(const shm_mapping &) = delete;
+  shm_mapping(shm_mapping &&other) noexcept : data_(other.data_), size_(other.size_)
+  {
+    other.data_ = nullptr;
+    other.size_ = 0;
+  }
+  shm_mapping &operator=(shm_mapping &&rhs) noexcept
+  {
+    std::swap(data_, rhs.data_);
+    std::swap(size_, rhs.size_);
+    return *this;
+  }
+
+  /// @brief 打开并映射一个已存在的共享内存段
+  bool open(const std::string &name, bool writable)
+  {
+    reset();
+    const int fd = ::shm_open(name.c_str(), writable ? O_RDWR : O_RDONLY, 0);
+    if (fd < 0) return false;
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size <= 0)
+    {
+      ::close(fd);
+      return false;
+    }
+    return map(fd, static_cast<std::size_t>(st.st_size), writable);
+  }
+
+  /// @brief 创建(或截断)共享内存段并以读写方式映射
+  bool create(const std::string &name, std::size_t size, bool exclusive)
+  {
+    reset();
+    const int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | (exclusive ? O_EXCL : 0), 0644);
+    if (fd < 0) return false;
+    if (::ftruncate(fd, static_cast<off_t>(size)) != 0)
+    {
+      ::close(fd);
+      return false;
+    }
+    return map(fd, size, true);
+  }
+
+  void reset() noexcept
+  {
+    if (data_) ::munmap(data_, size_);
+    data_ = nullptr;
+    size_ = 0;
+  }
+
+  void *data() const noexcept
+  {
+    return data_;
+  }
+  std::size_t size() const noexcept
+  {
+    return size_;
+  }
+
+ private:
+  bool map(int fd, std::size_t size, bool writable)
+  {
+    void *p = ::mmap(nullptr, size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) return false;
+    data_ = p;
+    size_ = size;
+    return true;
+  }
+
+  void *data_ = nullptr;
+  std::size_t size_ = 0;
+};
+}  // namespace detail
+
+/// @brief Publishes ini documents to a named POSIX shared memory area
+class shm_publisher
+{
+ public:
+  /// @param name Shared memory name, e.g. "/myapp_config" (leading '/', no other '/')
+  explicit shm_publisher(std::string name) : name_(std::move(name)) {}
+
+  shm_publisher(const shm_publisher &) = delete;
+  shm_publisher &operator=(const shm_publisher &) = delete;
+
+  /// @brief Publish a new generation. Readers switch to it on their next `refresh()`.
+  ///        The segment of the previous generation is unlinked, readers still mapping it keep a valid view.
+  /// @return The new generation, 0 on failure
+  template <typename Hash, typename Equal, template <typename...> class Map, typename Allocator, typename CommentPolicy>
+  std::uint64_t publish(const basic_inifile<Hash, Equal, Map, Allocator, CommentPolicy> &content)
+  {
+    if (!open_control()) return 0;
+    const std::string image = build_image(content);
+    if (image.empty()) return 0;
+
+    detail::shm_control *control = this->control();
+    const std::uint64_t previous = control->generation.load(std::memory_order_acquire);
+    const std::uint64_t generation = previous + 1;
+    const std::string segment_name = detail::shm_segment_name(name_, generation);
+    detail::shm_mapping segment;
+    if (!segment.create(segment_name, image.size(), true))
+    {
+      // 上一次发布在写入途中中断留下的段
+      if (errno != EEXIST) return 0;
+      ::shm_unlink(segment_name.c_str());
+      if (!segment.create(segment_name, image.size(), true)) return 0;
+    }
+    std::memcpy(segment.data(), image.data(), image.size());
+    segment.reset();
+
+    control->generation.store(generation, std::memory_order_release);  // 段写入完成后才对读者可见
+    if (previous != 0) ::shm_unlink(detail::shm_segment_name(name_, previous).c_str());
+    return generation;
+  }
+
+  /// @brief The last published generation, 0 if nothing was published.
+  std::uint64_t generation()
+  {
+    return open_control() ? control()->generation.load(std::memory_order_acquire) : 0;
+  }
+
+  /// @brief Unlink the control segment and the current generation. Attached readers keep their mappings.
+  static void remove(const std::string &name)
+  {
+    detail::shm_mapping control;
+    if (control.open(name, false) && control.size() >= sizeof(detail::shm_control))
+    {
+      const auto *c = static_cast<const detail::shm_control *>(control.data());
+      const std::uint64_t generation = c->generation.load(std::memory_order_acquire);
+      if (generation != 0) ::shm_unlink(detail::shm_segment_name(name, generation).c_str());
+    }
+    ::shm_unlink(name.c_str());
+  }
+
+ private:
+  detail::shm_control *control() const noexcept
+  {
+    return static_cast<detail::shm_control *>(control_.data());
+  }
+
+  /// @brief 打开或创建控制段, 发布者重启后从已有的代数继续
+  bool open_control()
+  {
+    if (control_.data()) return true;
+    if (control_.open(name_, true) && control_.size() >= sizeof(detail::shm_control) &&
+        std::memcmp(control()->magic, "INISHM", 7) == 0)
+    {
+      return true;
+    }
+    ::shm_unlink(name_.c_str());
+    if (!control_.create(name_, sizeof(detail::shm_control), false)) return false;
+    detail::shm_control *c = new (control_.data()) detail::shm_control;
+    c->generation.store(0, std::memory_order_relaxed);
+    std::memcpy(c->magic, "INISHM", 7);
+    c->magic[7] = '\0';
+    return true;
+  }
+
+ private:
+  std::string name_;
+  detail::shm_mapping control_;
+};
+
+/// @brief Read-only, zero-copy view of the document published by `shm_publisher`
+class shm_reader
+{
+ public:
+  shm_reader() = default;
+  shm_reader(const shm_reader &) = delete;
+  shm_reader &operator=(const shm_reader &) = delete;
+
+  /// @brief Attach to a published document.
+  /// @return Return false if nothing has been published under `name` yet
+  bool open(const std::string &name)
+  {
+    name_ = name;
+    generation_ = 0;
+    view_.close();
+    segment_.reset();
+    if (!control_.open(name_, false) || control_.size() < sizeof(detail::shm_control)) return false;
+    if (std::memcmp(static_cast<const detail::shm_control *>(control_.data())->magic, "INISHM", 7) != 0)
+    {
+      control_.reset();
+      return false;
+    }
+    refresh();
+    return generation_ != 0;
+  }
+
+  /// @brief Latest published generation (one atomic load, cheap enough to call per request).
+  std::uint64_t published_generation() const noexcept
+  {
+    if (!control_.data()) return 0;
+    return static_cast<const detail::shm_control *>(control_.data())->generation.load(std::memory_order_acquire);
+  }
+
+  /// @brief Switch to the latest generation if a new one was published.
+  /// @return Return true if the view switched to a new generation
+  bool refresh()
+  {
+    for (int attempt = 0; attempt < 8; ++attempt)  // 读取代数后段可能已被更新的发布替换, 重试
+    {
+      const std::uint64_t latest = published_generation();
+      if (latest == 0 || latest == generation_) return false;
+      detail::shm_mapping segment;
+      if (!segment.open(detail::shm_segment_name(name_, latest), false)) continue;
+      mapped_inifile view;
+      if (!view.attach(segment.data(), segment.size())) continue;
+      view_ = std::move(view);  // 先替换视图, 再释放旧映射
+      segment_ = std::move(segment);
+      generation_ = latest;
+      return true;
+    }
+    return false;
+  }
+
+  /// @brief Generation of the current view, 0 if not attached.
+  std::uint64_t generation() const noexcept
+  {
+    return generation_;
+  }
+
+  /// @brief The current document.
+  const mapped_inifile &view() const noexcept
+  {
+    return view_;
+  }
+  const mapped_inifile *operator->() const noexcept
+  {
+    return &view_;
+  }
+
+ private:
+  std::string name_;
+  detail::shm_mapping control_;
+  detail::shm_mapping segment_;
+  mapped_inifile view_;
+  std::uint64_t generation_ = 0;
+};
+
+}  // namespace ini
+
+#endif  // !defined(_WIN32)
+
+#endif  // INI_FILE_SHM_H_
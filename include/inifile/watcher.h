@@ -0,0 +1,351 @@
+/**************************************************************************************************************
+ *~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * @file: watcher.h
+ * @description: Hot reload of an ini file with debounce and changed-key diffing.
+ * - Linux: uses inotify on the parent directory (also catches editors that save via rename).
+ * - Other platforms: polls the file size/mtime.
+ * - Bursts of events are coalesced (debounce), the file is parsed once and only the changed
+ *   sections/keys (see `ini::diff`) are delivered to subscribers.
+ * - Callbacks run without any watcher lock held and may call `check()`, `current()` or `subscribe()`.
+ *   Deliveries are serialized and keep the reload order.
+ *
+ * @license: MIT
+ * @repository: https://github.com/abin-z/inifile
+ *~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ **************************************************************************************************************/
+
+#ifndef INI_FILE_WATCHER_H_
+#define INI_FILE_WATCHER_H_
+
+#include <inifile/diff.h>
+#include <inifile/inifile.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace ini
+{
+
+/// @brief Watches an ini file and delivers changed sections/keys to subscribers
+template <typename Hash = std::hash<std::string>, typename Equal = std::equal_to<std::string>,
+          template <typename...> class Map = std::unordered_map>
+class basic_watcher
+{
+ public:
+  using inifile_type = basic_inifile<Hash, Equal, Map>;
+  using snapshot_type = std::shared_ptr<const inifile_type>;
+  /// @brief Subscriber callback: the changes and the newly loaded content.
+  using callback = std::function<void(const diff_result &, const snapshot_type &)>;
+
+  /// @param filename File to watch
+  /// @param debounce Quiet period after the last event before the file is reloaded
+  /// @param poll_interval Interval of the polling fallback
+  explicit basic_watcher(std::string filename,
+                         std::chrono::milliseconds debounce = std::chrono::milliseconds(100),
+                         std::chrono::milliseconds poll_interval = std::chrono::milliseconds(500)) :
+    filename_(std::move(filename)), debounce_(debounce), poll_interval_(poll_interval)
+  {
+    auto initial = std::make_shared<inifile_type>();
+    stamp_ = detail::stat_file(filename_);
+    if (stamp_.exists) initial->load(filename_);
+    current_ = std::move(initial);
+  }
+
+  ~basic_watcher()
+  {
+    stop();
+  }
+
+  basic_watcher(const basic_watcher &) = delete;
+  basic_watcher &operator=(const basic_watcher &) = delete;
+
+  /// @brief Register a subscriber, callbacks are invoked on the watcher thread (or the thread calling `check()`).
+  ///        Callbacks never run concurrently with each other and see the reloads in order.
+  /// @return Subscription id for `unsubscribe()`
+  std::size_t subscribe(callback cb)
+  {
+    std::lock_guard<std::mutex> lock(subscribers_mutex_);
+    subscribers_.emplace_back(++last_id_, std::move(cb));
+    return last_id_;
+  }
+
+  /// @brief Remove a subscriber.
+  void unsubscribe(std::size_t id)
+  {
+    std::lock_guard<std::mutex> lock(subscribers_mutex_);
+    for (auto it = subscribers_.begin(); it != subscribers_.end(); ++it)
+    {
+      if (it->first == id)
+      {
+        subscribers_.erase(it);
+        return;
+      }
+    }
+  }
+
+  /// @brief The most recently loaded content.
+  snapshot_type current() const
+  {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    return current_;
+  }
+
+  /// @brief Start watching on a background thread (inotify on Linux, polling elsewhere or if inotify fails).
+  /// @return Return `false` if already running
+  bool start()
+  {
+    if (thread_.joinable()) return false;
+    {
+      std::lock_guard<std::mutex> lock(stop_mutex_);
+      stop_ = false;
+    }
+    thread_ = std::thread([this] { run(); });
+    return true;
+  }
+
+  /// @brief Stop the background thread, safe to call multiple times.
+  void stop()
+  {
+    {
+      std::lock_guard<std::mutex> lock(stop_mutex_);
+      stop_ = true;
+    }
+    stop_cv_.notify_all();
+    if (thread_.joinable()) thread_.join();
+  }
+
+  /// @brief Reload the file synchronously if its size/mtime changed and notify subscribers.
+  ///        Called from a subscriber callback (or while another thread is delivering), the changes are queued
+  ///        and delivered by that thread once the current callbacks return.
+  /// @return Return `true` if changes were delivered or queued for delivery
+  bool check()
+  {
+    return reload(false);
+  }
+
+ private:
+  struct notification
+  {
+    diff_result changes;
+    snapshot_type snapshot;
+  };
+
+  /// @brief 重新加载文件, 与上一次的内容做 diff, 只有存在变化时才通知订阅者
+  bool reload(bool force)
+  {
+    {
+      // reload_mutex_ 只保护 加载 + diff + 发布 + 入队, 回调在锁外执行, 回调中调用 check() 不会死锁
+      std::lock_guard<std::mutex> reload_lock(reload_mutex_);
+      const detail::file_stamp stamp = detail::stat_file(filename_);
+      if (!force && stamp == stamp_) return false;
+
+      auto next = std::make_shared<inifile_type>();
+      if (stamp.exists && !next->load(filename_)) return false;  // 读取失败(例如文件正在被替换), 保留旧内容
+
+      snapshot_type previous;
+      {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        previous = current_;
+      }
+      diff_result changes = ini::diff(*previous, *next);
+      snapshot_type snapshot(std::move(next));
+      {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        stamp_ = stamp;
+        current_ = snapshot;
+      }
+      if (changes.empty()) return false;
+
+      // 在 reload_mutex_ 内入队, 保证投递顺序与发布顺序一致
+      std::lock_guard<std::mutex> lock(delivery_mutex_);
+      pending_.push_back(notification{std::move(changes), std::move(snapshot)});
+      if (delivering_) return true;  // 其他线程(或外层回调所在的当前线程)正在投递, 由它按顺序投递
+      delivering_ = true;
+    }
+    deliver_pending();
+    return true;
+  }
+
+  /// @brief 依次投递队列中的变化直到队列为空, 同一时刻只有一个线程在投递
+  void deliver_pending()
+  {
+    try
+    {
+      for (;;)
+      {
+        notification next;
+        {
+          std::lock_guard<std::mutex> lock(delivery_mutex_);
+          if (pending_.empty())
+          {
+            delivering_ = false;
+            return;
+          }
+          next = std::move(pending_.front());
+          pending_.pop_front();
+        }
+        std::vector<std::pair<std::size_t, callback>> subscribers;
+        {
+          std::lock_guard<std::mutex> lock(subscribers_mutex_);
+          subscribers = subscribers_;
+        }
+        for (const auto &sub : subscribers) sub.second(next.changes, next.snapshot);
+      }
+    }
+    catch (...)
+    {
+      std::lock_guard<std::mutex> lock(delivery_mutex_);
+      delivering_ = false;  // 回调抛出异常, 剩余的变化由下一次 reload 投递
+      throw;
+    }
+  }
+
+  /// @brief 等待指定时长, 返回 true 表示收到停止请求
+  bool wait_for_stop(std::chrono::milliseconds timeout)
+  {
+    std::unique_lock<std::mutex> lock(stop_mutex_);
+    return stop_cv_.wait_for(lock, timeout, [this] { return stop_; });
+  }
+
+  bool stopping()
+  {
+    std::lock_guard<std::mutex> lock(stop_mutex_);
+    return stop_;
+  }
+
+  void run()
+  {
+#if defined(__linux__)
+    if (run_inotify()) return;
+#endif
+    run_polling();
+  }
+
+  /// @brief 轮询模式: 检测到变化后等待文件稳定 debounce 时长再重新加载
+  void run_polling()
+  {
+    while (!wait_for_stop(poll_interval_))
+    {
+      detail::file_stamp seen = detail::stat_file(filename_);
+      {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        if (seen == stamp_) continue;
+      }
+      for (;;)  // 合并连续的写入
+      {
+        if (wait_for_stop(debounce_)) return;
+        detail::file_stamp now = detail::stat_file(filename_);
+        if (now == seen) break;
+        seen = now;
+      }
+      reload(false);
+    }
+  }
+
+#if defined(__linux__)
+  /// @brief inotify 模式: 监视父目录, 在最后一个事件之后静默 debounce 时长再重新加载
+  /// @return 返回 false 表示 inotify 不可用, 需要退回到轮询模式
+  bool run_inotify()
+  {
+    const std::string::size_type slash = filename_.find_last_of('/');
+    const std::string dir = slash == std::string::npos ? "." : (slash == 0 ? "/" : filename_.substr(0, slash));
+    const std::string name = slash == std::string::npos ? filename_ : filename_.substr(slash + 1);
+
+    const int fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) return false;
+    const std::uint32_t mask = IN_CLOSE_WRITE | IN_MODIFY | IN_MOVED_TO | IN_CREATE | IN_DELETE | IN_ATTRIB;
+    if (::inotify_add_watch(fd, dir.c_str(), mask) < 0)
+    {
+      ::close(fd);
+      return false;
+    }
+
+    using clock = std::chrono::steady_clock;
+    bool pending = false;
+    clock::time_point deadline;
+    alignas(struct inotify_event) char buffer[4096];
+    while (!stopping())
+    {
+      int timeout_ms = 100;  // 定期醒来检查停止请求
+      if (pending)
+      {
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - clock::now()).count();
+        timeout_ms = remaining < 0 ? 0 : (remaining < timeout_ms ? static_cast<int>(remaining) : timeout_ms);
+      }
+      struct pollfd pfd = {fd, POLLIN, 0};
+      const int ready = ::poll(&pfd, 1, timeout_ms);
+      if (ready > 0 && (pfd.revents & POLLIN))
+      {
+        ssize_t len;
+        while ((len = ::read(fd, buffer, sizeof(buffer))) > 0)
+        {
+          for (char *p = buffer; p < buffer + len;)
+          {
+            const auto *event = reinterpret_cast<const struct inotify_event *>(p);
+            if (event->len > 0 && name == event->name)
+            {
+              pending = true;
+              deadline = clock::now() + debounce_;  // 每个新事件都会推迟重新加载
+            }
+            p += sizeof(struct inotify_event) + event->len;
+          }
+        }
+      }
+      if (pending && clock::now() >= deadline)
+      {
+        pending = false;
+        reload(true);
+      }
+    }
+    ::close(fd);
+    return true;
+  }
+#endif
+
+ private:
+  const std::string filename_;
+  const std::chrono::milliseconds debounce_;
+  const std::chrono::milliseconds poll_interval_;
+
+  mutable std::mutex state_mutex_;  // 保护 current_ 和 stamp_
+  snapshot_type current_;
+  detail::file_stamp stamp_;
+  std::mutex reload_mutex_;  // 串行化 加载 + diff + 发布
+
+  std::mutex delivery_mutex_;  // 保护 pending_ 和 delivering_
+  std::deque<notification> pending_;
+  bool delivering_ = false;
+
+  std::mutex subscribers_mutex_;
+  std::vector<std::pair<std::size_t, callback>> subscribers_;
+  std::size_t last_id_ = 0;
+
+  std::mutex stop_mutex_;
+  std::condition_variable stop_cv_;
+  bool stop_ = false;
+  std::thread thread_;
+};
+
+/// @brief watcher class
+using watcher = basic_watcher<>;
+/// @brief case_insensitive_watcher class
+using case_insensitive_watcher = basic_watcher<detail::case_insensitive_hash, detail::case_insensitive_equal>;
+
+}  // namespace ini
+
+#endif  // INI_FILE_WATCHER_H_
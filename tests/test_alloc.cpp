@@ -0,0 +1,263 @@
+// 内存分配预算测试: 替换全局 operator new/delete 统计堆分配次数,
+// 为核心操作设定精确的分配预算, 意外的字符串/field 拷贝会让测试失败.
+// 单独编译为 inialloc, 不启用 INIFILE_ENABLE_STATS / INIFILE_ENABLE_ACCESS_COUNTERS.
+#define CATCH_CONFIG_MAIN
+#include <inifile/inifile.h>
+#include <inifile/layered.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <sstream>
+#include <string>
+
+#include "catch2/catch.hpp"
+
+namespace
+{
+std::atomic<bool> g_counting{false};
+std::atomic<std::size_t> g_allocations{0};
+
+void *counted_alloc(std::size_t size)
+{
+  if (g_counting.load(std::memory_order_relaxed)) g_allocations.fetch_add(1, std::memory_order_relaxed);
+  if (size == 0) size = 1;
+  void *p = std::malloc(size);
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+
+/// @brief 统计作用域内(当前进程)的堆分配次数
+class allocation_counter
+{
+ public:
+  allocation_counter()
+  {
+    g_allocations.store(0);
+    g_counting.store(true);
+  }
+  ~allocation_counter()
+  {
+    g_counting.store(false);
+  }
+  std::size_t count() const
+  {
+    return g_allocations.load();
+  }
+
+  allocation_counter(const allocation_counter &) = delete;
+  allocation_counter &operator=(const allocation_counter &) = delete;
+};
+
+/// @brief 统计 fn 执行期间的堆分配次数
+template <typename Fn>
+std::size_t count_allocations(Fn &&fn)
+{
+  allocation_counter counter;
+  fn();
+  return counter.count();
+}
+
+// 超过短字符串优化(SSO)容量的字符串, 拷贝时必然分配内存
+const std::string long_key = "a_key_name_that_does_not_fit_into_the_sso_buffer";
+const std::string long_value = "a_value_that_does_not_fit_into_the_small_string_buffer";
+}  // namespace
+
+void *operator new(std::size_t size)
+{
+  return counted_alloc(size);
+}
+void *operator new[](std::size_t size)
+{
+  return counted_alloc(size);
+}
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+  try
+  {
+    return counted_alloc(size);
+  }
+  catch (...)
+  {
+    return nullptr;
+  }
+}
+void *operator new[](std::size_t size, const std::nothrow_t &tag) noexcept
+{
+  return operator new(size, tag);
+}
+void operator delete(void *p) noexcept
+{
+  std::free(p);
+}
+void operator delete[](void *p) noexcept
+{
+  std::free(p);
+}
+void operator delete(void *p, std::size_t) noexcept
+{
+  std::free(p);
+}
+void operator delete[](void *p, std::size_t) noexcept
+{
+  std::free(p);
+}
+
+TEST_CASE("allocation counter observes heap allocations", "[alloc]")
+{
+  std::size_t n = count_allocations([] { std::string s(long_value); });
+  REQUIRE(n == 1);
+  n = count_allocations([] { std::string s("short"); });
+  REQUIRE(n == 0);
+}
+
+TEST_CASE("lookup hits do not allocate", "[alloc]")
+{
+  ini::inifile inif;
+  inif["server"]["port"] = 8080;
+  inif["server"][long_key] = long_value;
+  inif[long_key]["host"] = "localhost";
+  const ini::inifile &cinif = inif;
+  const ini::section &sec = cinif.at("server");
+
+  bool ok = false;  // 断言放在计数范围之外, Catch2 本身可能分配内存
+  std::size_t n = count_allocations([&] {
+    ok = sec.contains(long_key) && sec.at(long_key).str() == long_value && sec.find(long_key) != sec.end() &&
+         sec.count("port") == 1 && sec.get("port").as<int>() == 8080;
+  });
+  REQUIRE(ok);
+  REQUIRE(n == 0);
+
+  n = count_allocations([&] {
+    ok = cinif.contains(long_key) && cinif.contains("server", long_key) &&
+         cinif.at(long_key).at("host").str() == "localhost" && cinif.find("server") != cinif.end() &&
+         cinif.count(long_key) == 1 && cinif.get("server", "port").as<int>() == 8080;
+  });
+  REQUIRE(ok);
+  REQUIRE(n == 0);
+
+  // 查找未命中同样不分配
+  n = count_allocations([&] {
+    ok = !sec.contains("missing") && !cinif.contains("missing", "port") && cinif.get("missing", "port").empty();
+  });
+  REQUIRE(ok);
+  REQUIRE(n == 0);
+
+  // 两端带空白的 key 需要一份去除空白的副本
+  const std::string padded = "  " + long_key + "  ";
+  n = count_allocations([&] { ok = sec.contains(padded); });
+  REQUIRE(ok);
+  REQUIRE(n == 1);
+}
+
+TEST_CASE("layered_view lookups do not allocate", "[alloc][layered]")
+{
+  ini::inifile defaults, overrides;
+  defaults["server"][long_key] = long_value;
+  defaults["server"]["port"] = 80;
+  overrides["server"]["port"] = 8080;
+  ini::layered_view view;
+  view.push_layer(defaults);
+  view.push_layer(overrides, true);
+
+  bool ok = false;
+  std::size_t n = count_allocations([&] {
+    ok = view.contains("server") && view.contains("server", long_key) && view.layer_of("server", long_key) == 0 &&
+         view.at("server", "port").as<int>() == 8080 && view.find("server", "missing") == nullptr &&
+         !view.contains(long_key, long_key);
+  });
+  REQUIRE(ok);
+  REQUIRE(n == 0);
+}
+
+TEST_CASE("get copies the value, at does not", "[alloc]")
+{
+  ini::section sec;
+  sec["long"] = long_value;
+  const ini::section &csec = sec;
+  bool ok = false;
+  std::size_t n = count_allocations([&] { ok = csec.get("long").str() == long_value; });
+  REQUIRE(ok);
+  REQUIRE(n == 1);  // 返回的 field 拷贝了长字符串
+  n = count_allocations([&] { ok = csec.at("long").str() == long_value; });
+  REQUIRE(ok);
+  REQUIRE(n == 0);
+}
+
+TEST_CASE("inserting keys allocates one node per key", "[alloc]")
+{
+  ini::section sec;
+  sec.reserve(64);
+  std::size_t n = count_allocations([&] {
+    for (int i = 0; i < 64; ++i)
+    {
+      char key[8] = {'k', char('0' + i / 10), char('0' + i % 10), 0};
+      sec.set(key, i);
+    }
+  });
+  REQUIRE(sec.size() == 64);
+  REQUIRE(n == 64);
+
+  // 覆盖已有 key 的短值不分配
+  n = count_allocations([&] { sec.set("k00", 100); });
+  REQUIRE(n == 0);
+
+  // 长 key 和长值各需要一次额外分配
+  n = count_allocations([&] { sec.set(long_key, long_value); });
+  REQUIRE(n == 3);
+
+  ini::inifile inif;
+  inif.reserve(8);
+  n = count_allocations([&] { inif["s1"]; });
+  REQUIRE(n == 1);  // section 节点, 空 section 不分配存储
+  n = count_allocations([&] { inif["s1"]["k"] = 1; });
+  REQUIRE(n == 3);  // section 的共享存储(make_shared 一次分配) + key 节点 + 桶数组
+}
+
+TEST_CASE("parsing N keys costs N allocations plus a bounded overhead", "[alloc]")
+{
+  auto make_text = [](int keys) {
+    std::string text = "[s]\n";
+    for (int i = 0; i < keys; ++i) text += "k" + std::to_string(i) + "=" + std::to_string(i) + "\n";
+    return text;
+  };
+  auto parse_cost = [](const std::string &text) {
+    ini::inifile inif;
+    std::istringstream is(text);
+    return count_allocations([&] { inif.read(is); });
+  };
+  const std::string small = make_text(1000);
+  const std::string large = make_text(2000);
+  const std::size_t small_cost = parse_cost(small);
+  const std::size_t large_cost = parse_cost(large);
+  // 每个 key 一个节点, 加上 section 节点/存储以及桶数组扩容(次数随 N 对数增长)
+  REQUIRE(small_cost >= 1000);
+  REQUIRE(small_cost <= 1000 + 32);
+  REQUIRE(large_cost - small_cost >= 1000);
+  REQUIRE(large_cost - small_cost <= 1000 + 4);
+}
+
+TEST_CASE("no_comments policy skips comment lines without allocating", "[alloc][comment]")
+{
+  std::string plain = "[s]\n";
+  std::string commented = "; " + long_value + "\n[s]\n";
+  for (int i = 0; i < 100; ++i)
+  {
+    const std::string kv = "k" + std::to_string(i) + "=" + std::to_string(i) + "\n";
+    plain += kv;
+    commented += "# " + long_value + "\n" + kv;
+  }
+  auto parse_cost = [](const std::string &text) {
+    ini::uncommented_inifile inif;
+    std::istringstream is(text);
+    return count_allocations([&] { inif.read(is); });
+  };
+  // getline 读入长注释行时行缓冲区会增长, 最多为此多分配一次
+  REQUIRE(parse_cost(commented) <= parse_cost(plain) + 1);
+
+  // 默认策略下每条注释都要存储
+  ini::inifile inif;
+  std::istringstream is(commented);
+  const std::size_t kept = count_allocations([&] { inif.read(is); });
+  REQUIRE(kept >= parse_cost(plain) + 100);
+}
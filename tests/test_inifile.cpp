@@ -1,14 +1,38 @@
 #define CATCH_CONFIG_MAIN
 #include <inifile/inifile.h>
+#include <inifile/concurrent.h>
+#include <inifile/diff.h>
+#include <inifile/directory.h>
+#include <inifile/history.h>
+#include <inifile/include.h>
+#include <inifile/interpolate.h>
+#include <inifile/journal.h>
+#include <inifile/layered.h>
+#include <inifile/mapped.h>
+#include <inifile/shared_config.h>
+#include <inifile/shm.h>
+#include <inifile/watcher.h>
 
 #include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
 #include <deque>
 #include <forward_list>
 #include <list>
+#include <map>
+#include <mutex>
 #include <set>
+#include <thread>
 #include <string>
 #include <vector>
 
+#if !defined(_WIN32)
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #include "catch2/catch.hpp"
 
 TEST_CASE("basic test")
@@ -5589,3 +5613,1865 @@ TEST_CASE("inifile: roundtrip preserves multiple sections and types", "[inifile]
   REQUIRE(reloaded["three"]["c"].as<double>() == Approx(3.1415));
   REQUIRE(reloaded["three"]["c"].comment().view()[0] == "; pi");
 }
+
+TEST_CASE("inifile: fingerprint is independent of insertion order", "[inifile][fingerprint]")
+{
+  ini::inifile a;
+  a["s1"]["k1"] = 1;
+  a["s1"]["k2"] = "two";
+  a["s2"]["k3"] = 3.5;
+  a["s2"].set_comment("section comment");
+
+  ini::inifile b;
+  b["s2"]["k3"] = 3.5;
+  b["s2"].set_comment("section comment");
+  b["s1"]["k2"] = "two";
+  b["s1"]["k1"] = 1;
+
+  REQUIRE(a.fingerprint() == b.fingerprint());
+  REQUIRE(a["s1"].fingerprint() == b["s1"].fingerprint());
+
+  b["s1"]["k1"] = 2;
+  REQUIRE(a.fingerprint() != b.fingerprint());
+  b["s1"]["k1"] = 1;
+  b["s1"]["k1"].set_comment("key comment");
+  REQUIRE(a.fingerprint() != b.fingerprint());
+
+  ini::inifile c;
+  c["s1"];  // empty section differs from no section
+  REQUIRE(c.fingerprint() != ini::inifile{}.fingerprint());
+}
+
+TEST_CASE("inifile: save_if_changed skips unchanged content", "[inifile][fingerprint][io]")
+{
+  const std::string path = "test_save_if_changed.ini";
+  const std::string original = "; hand written\n[net]\nport = 8080\nhost = localhost\n";
+  {
+    std::ofstream ofs(path);
+    ofs << original;
+  }
+
+  ini::inifile inif;
+  REQUIRE(inif.load(path));
+  REQUIRE(inif.save_if_changed(path));
+  {
+    std::ifstream ifs(path);
+    std::string content((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+    REQUIRE(content == original);  // 内容相同, 文件未被重写
+  }
+
+  inif["net"]["port"] = 9090;
+  REQUIRE(inif.save_if_changed(path));
+  ini::inifile reloaded;
+  REQUIRE(reloaded.load(path));
+  REQUIRE(reloaded["net"]["port"].as<int>() == 9090);
+  std::remove(path.c_str());
+
+  // 由调用者维护上次保存的指纹, 不读取文件
+  std::uint64_t last = 0;
+  REQUIRE(inif.save_if_changed(path, last));
+  REQUIRE(last == inif.fingerprint());
+  std::remove(path.c_str());
+  REQUIRE(inif.save_if_changed(path, last));
+  REQUIRE_FALSE(std::ifstream(path).good());  // 指纹未变, 没有写文件
+}
+
+TEST_CASE("inifile: save_incremental preserves untouched layout", "[inifile][io][incremental]")
+{
+  const std::string path = "test_save_incremental.ini";
+  const std::string original =
+    "; global comment\r\n"
+    "name = demo\r\n"
+    "\r\n"
+    "# network settings\r\n"
+    "[net]\r\n"
+    "  port   =  8080\r\n"
+    "; host comment\r\n"
+    "host=localhost\r\n"
+    "timeout = 30\r\n"
+    "\r\n"
+    "[old]\r\n"
+    "x = 1\r\n"
+    "\r\n"
+    "[log]\r\n"
+    "level = info\r\n"
+    "; trailing comment\r\n";
+  {
+    std::ofstream ofs(path, std::ios::binary);
+    ofs << original;
+  }
+
+  ini::inifile inif;
+  REQUIRE(inif.load(path));
+  REQUIRE(inif.save_incremental(path));  // 未修改时文件内容不变
+  {
+    std::ifstream ifs(path, std::ios::binary);
+    std::string content((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+    REQUIRE(content == original);
+  }
+
+  inif["net"]["port"] = 9090;
+  inif["net"].remove("timeout");
+  inif["net"]["retries"] = 3;
+  inif["net"]["host"].set_comment("new host comment");
+  inif.remove("old");
+  inif["db"]["user"] = "admin";
+  REQUIRE(inif.save_incremental(path));
+
+  const std::string expected =
+    "; global comment\r\n"
+    "name = demo\r\n"
+    "\r\n"
+    "# network settings\r\n"
+    "[net]\r\n"
+    "  port   =  9090\r\n"
+    "; new host comment\r\n"
+    "host=localhost\r\n"
+    "retries=3\r\n"
+    "\r\n"
+    "\r\n"
+    "[log]\r\n"
+    "level = info\r\n"
+    "\r\n"
+    "[db]\r\n"
+    "user=admin\r\n"
+    "; trailing comment\r\n";
+  std::ifstream ifs(path, std::ios::binary);
+  std::string content((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+  REQUIRE(content == expected);
+
+  ini::inifile reloaded;
+  REQUIRE(reloaded.load(path));
+  REQUIRE(reloaded.fingerprint() == inif.fingerprint());
+  ifs.close();
+  std::remove(path.c_str());
+}
+
+TEST_CASE("inifile: save_incremental keeps unchanged bytes as values grow and shrink", "[inifile][io][incremental]")
+{
+  const std::string path = "test_save_incremental_range.ini";
+  std::string original = "[head]\nfirst=1\n";
+  for (int i = 0; i < 1000; ++i) original += "[s" + std::to_string(i) + "]\nk=" + std::to_string(i % 10) + "\n";
+  original += "[tail]\nlast=1\n";
+  {
+    std::ofstream ofs(path, std::ios::binary);
+    ofs << original;
+  }
+  auto read_back = [&path] {
+    std::ifstream ifs(path, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+  };
+  auto replace_once = [](std::string &text, const std::string &from, const std::string &to) {
+    text.replace(text.find(from), from.size(), to);
+  };
+
+  ini::inifile inif;
+  REQUIRE(inif.load(path));
+
+  // 长度不变
+  inif["s500"]["k"] = 7;
+  REQUIRE(inif.save_incremental(path));
+  std::string expected = original;
+  replace_once(expected, "[s500]\nk=0", "[s500]\nk=7");
+  REQUIRE(read_back() == expected);
+
+  // 变长
+  inif["s10"]["k"] = "longer value";
+  inif["tail"]["extra"] = 2;
+  REQUIRE(inif.save_incremental(path));
+  replace_once(expected, "[s10]\nk=0", "[s10]\nk=longer value");
+  expected += "extra=2\n";
+  REQUIRE(read_back() == expected);
+
+  // 变短
+  inif["s10"]["k"] = 0;
+  inif["tail"].remove("extra");
+  inif["head"]["first"] = 2;
+  REQUIRE(inif.save_incremental(path));
+  expected = original;
+  replace_once(expected, "first=1", "first=2");
+  replace_once(expected, "[s500]\nk=0", "[s500]\nk=7");
+  REQUIRE(read_back() == expected);
+  REQUIRE_FALSE(std::ifstream(path + ".tmp").good());  // 临时文件已重命名为目标文件
+
+#if !defined(_WIN32)
+  // 临时文件无法写入(此处被同名目录占用)时保存失败, 原文件保持不变
+  inif["head"]["first"] = 3;
+  const std::string blocker = path + ".tmp/blocker";
+  REQUIRE(::mkdir((path + ".tmp").c_str(), 0700) == 0);
+  REQUIRE(ini::detail::write_file(blocker, "x"));
+  REQUIRE_FALSE(inif.save_incremental(path));
+  REQUIRE(std::remove(blocker.c_str()) == 0);
+  REQUIRE(::rmdir((path + ".tmp").c_str()) == 0);
+  REQUIRE(read_back() == expected);
+  inif["head"]["first"] = 2;
+#endif
+
+  ini::inifile reloaded;
+  REQUIRE(reloaded.load(path));
+  REQUIRE(reloaded.fingerprint() == inif.fingerprint());
+  std::remove(path.c_str());
+}
+
+TEST_CASE("inifile: save_incremental creates missing file", "[inifile][io][incremental]")
+{
+  const std::string path = "test_save_incremental_new.ini";
+  std::remove(path.c_str());
+  ini::inifile inif;
+  inif[""]["global"] = 1;
+  inif["s"]["k"] = "v";
+  REQUIRE(inif.save_incremental(path));
+
+  ini::inifile reloaded;
+  REQUIRE(reloaded.load(path));
+  REQUIRE(reloaded.fingerprint() == inif.fingerprint());
+
+  // 已存在的文件中新增全局 key, 应写在第一个 section 之前
+  inif[""]["added"] = 2;
+  REQUIRE(inif.save_incremental(path));
+  REQUIRE(reloaded.load(path));
+  REQUIRE(reloaded[""]["added"].as<int>() == 2);
+  REQUIRE(reloaded.fingerprint() == inif.fingerprint());
+  std::remove(path.c_str());
+}
+
+TEST_CASE("journaled_inifile: replay and compact", "[journal]")
+{
+  const std::string path = "test_journal.ini";
+  std::remove(path.c_str());
+  std::remove((path + ".journal").c_str());
+  {
+    ini::inifile base;
+    base["net"]["port"] = 8080;
+    base["net"]["host"] = "localhost";
+    base["old"]["x"] = 1;
+    REQUIRE(base.save(path));
+  }
+
+  {
+    ini::journaled_inifile jini;
+    REQUIRE(jini.load(path));
+    REQUIRE(jini.set("net", "port", 9090));
+    REQUIRE(jini.set("net", "motd", "hello\tworld \\ end"));
+    REQUIRE(jini.remove("net", "host"));
+    REQUIRE(jini.remove("old"));
+    REQUIRE_FALSE(jini.remove("missing"));
+    REQUIRE(jini.journal_records() == 4);
+  }
+
+  // 基础文件未被修改, 变更只存在于日志中
+  ini::inifile base;
+  REQUIRE(base.load(path));
+  REQUIRE(base["net"]["port"].as<int>() == 8080);
+
+  {
+    // 模拟写入中断的最后一条记录
+    std::ofstream journal(path + ".journal", std::ios::binary | std::ios::app);
+    journal << "S\tnet\tport\t1";
+  }
+
+  ini::journaled_inifile jini;
+  REQUIRE(jini.load(path));
+  REQUIRE(jini.journal_records() == 4);
+  REQUIRE(jini.get("net", "port").as<int>() == 9090);
+  REQUIRE(jini.get("net", "motd").as<std::string>() == "hello\tworld \\ end");
+  REQUIRE_FALSE(jini.contains("net", "host"));
+  REQUIRE_FALSE(jini.contains("old"));
+  REQUIRE(jini.set("net", "port", 9091));  // 不完整的记录已被截掉, 新记录可正常追加
+  {
+    ini::journaled_inifile again;
+    REQUIRE(again.load(path));
+    REQUIRE(again.journal_records() == 5);
+    REQUIRE(again.get("net", "port").as<int>() == 9091);
+  }
+
+  REQUIRE(jini.compact());
+  REQUIRE(jini.journal_records() == 0);
+  REQUIRE(base.load(path));
+  REQUIRE(base.fingerprint() == jini.data().fingerprint());
+  std::ifstream journal(path + ".journal", std::ios::binary | std::ios::ate);
+  REQUIRE(journal.tellg() == 0);
+  journal.close();
+
+  // 自动压缩
+  jini.set_compact_threshold(2);
+  REQUIRE(jini.set("auto", "a", 1));
+  REQUIRE(jini.journal_records() == 1);
+  REQUIRE(jini.set("auto", "b", 2));
+  REQUIRE(jini.journal_records() == 0);
+  REQUIRE(base.load(path));
+  REQUIRE(base["auto"]["b"].as<int>() == 2);
+
+#if !defined(_WIN32)
+  // 临时文件无法写入(此处被同名目录占用)时压缩失败, 基础文件和日志都保持不变
+  jini.set_compact_threshold(0);
+  REQUIRE(jini.set("auto", "c", 3));
+  const std::string blocker = path + ".tmp/blocker";
+  REQUIRE(::mkdir((path + ".tmp").c_str(), 0700) == 0);
+  REQUIRE(ini::detail::write_file(blocker, "x"));
+  REQUIRE_FALSE(jini.compact());
+  REQUIRE(std::remove(blocker.c_str()) == 0);
+  REQUIRE(::rmdir((path + ".tmp").c_str()) == 0);
+  REQUIRE(jini.journal_records() == 1);
+  REQUIRE(base.load(path));
+  REQUIRE_FALSE(base.contains("auto", "c"));
+  {
+    ini::journaled_inifile recovered;
+    REQUIRE(recovered.load(path));
+    REQUIRE(recovered.get("auto", "c").as<int>() == 3);
+  }
+  REQUIRE(jini.compact());
+  REQUIRE(base.load(path));
+  REQUIRE(base.get("auto", "c").as<int>() == 3);
+#endif
+
+  std::remove(path.c_str());
+  std::remove((path + ".journal").c_str());
+}
+
+TEST_CASE("ordered_inifile: keeps insertion order", "[ordered]")
+{
+  ini::ordered_inifile inif;
+  inif["zeta"]["z"] = 1;
+  inif["alpha"]["b"] = 2;
+  inif["alpha"]["a"] = 3;
+  inif[""]["global"] = "g";
+  inif["mid"]["m"] = 4;
+
+  REQUIRE(inif.to_string() == "global=g\n\n[zeta]\nz=1\n\n[alpha]\nb=2\na=3\n\n[mid]\nm=4\n");
+  REQUIRE(inif.sections() == std::vector<std::string>{"zeta", "alpha", "", "mid"});
+  REQUIRE(inif["alpha"].keys() == std::vector<std::string>{"b", "a"});
+
+  // 读取后再写出, 内容与顺序都不变
+  ini::ordered_inifile reloaded;
+  reloaded.from_string(inif.to_string());
+  REQUIRE(reloaded.to_string() == inif.to_string());
+
+  // 删除后顺序与查找仍然正确
+  REQUIRE(inif.remove("zeta"));
+  REQUIRE(inif["alpha"].remove("b"));
+  REQUIRE(inif.sections() == std::vector<std::string>{"alpha", "", "mid"});
+  REQUIRE(inif.contains("mid", "m"));
+  REQUIRE(inif.get("alpha", "a").as<int>() == 3);
+  REQUIRE_FALSE(inif.contains("zeta"));
+  REQUIRE_THROWS_AS(inif.at("zeta"), std::out_of_range);
+}
+
+TEST_CASE("ordered_inifile: large section and erase ranges", "[ordered]")
+{
+  ini::ordered_section sec;
+  for (int i = 0; i < 1000; ++i) sec["key" + std::to_string(i)] = i;
+  REQUIRE(sec.size() == 1000);
+
+  int expected = 0;
+  for (const auto &kv : sec)
+  {
+    REQUIRE(kv.first == "key" + std::to_string(expected));
+    REQUIRE(kv.second.as<int>() == expected);
+    ++expected;
+  }
+
+  // 删除一段范围
+  auto first = sec.find("key100");
+  auto last = sec.find("key200");
+  auto it = sec.erase(first, last);
+  REQUIRE(it->first == "key200");
+  REQUIRE(sec.size() == 900);
+  REQUIRE_FALSE(sec.contains("key150"));
+  for (int i = 0; i < 1000; ++i)
+  {
+    if (i >= 100 && i < 200) continue;
+    REQUIRE(sec.at("key" + std::to_string(i)).as<int>() == i);
+  }
+
+  ini::ordered_section copy = sec;
+  REQUIRE(copy.erase("key0") == 1);
+  REQUIRE(copy.begin()->first == "key1");
+  REQUIRE(sec.begin()->first == "key0");
+}
+
+TEST_CASE("ordered_inifile: references stay valid across inserts and erases", "[ordered]")
+{
+  ini::ordered_inifile inif;
+  auto &sec = inif["a"];
+  auto &field = sec["k0"];
+  field = "first";
+
+  // 大量插入会让底层数组多次扩容, 之前取得的引用必须仍然有效
+  for (int i = 0; i < 1000; ++i) inif["s" + std::to_string(i)]["x"] = i;
+  for (int i = 1; i < 1000; ++i) sec["k" + std::to_string(i)] = i;
+  REQUIRE(&inif["a"] == &sec);
+  REQUIRE(&inif["a"]["k0"] == &field);
+  REQUIRE(field.str() == "first");
+  sec["k0"] = "second";
+  REQUIRE(inif.at("a").at("k0").str() == "second");
+
+  // 删除其他元素同样不影响引用
+  auto &last = inif["s999"];
+  REQUIRE(inif.erase("s0") == 1);
+  REQUIRE(sec.erase("k1") == 1);
+  REQUIRE(&inif["a"] == &sec);
+  REQUIRE(&inif["s999"] == &last);
+  REQUIRE(&sec["k0"] == &field);
+  REQUIRE(inif.begin()->first == "a");
+
+  // 拷贝和移动保持顺序
+  ini::ordered_inifile copy = inif;
+  REQUIRE(copy.sections() == inif.sections());
+  ini::ordered_inifile moved(std::move(copy));
+  REQUIRE(moved.sections() == inif.sections());
+  copy = moved;
+  REQUIRE(copy.fingerprint() == inif.fingerprint());
+}
+
+TEST_CASE("ordered_inifile: case insensitive variant", "[ordered][case_insensitive]")
+{
+  ini::case_insensitive_ordered_inifile inif;
+  inif["Section"]["Key"] = 1;
+  inif["SECTION"]["other"] = 2;
+  REQUIRE(inif.size() == 1);
+  REQUIRE(inif["section"]["KEY"].as<int>() == 1);
+  REQUIRE(inif.to_string() == "[Section]\nKey=1\nother=2\n");
+}
+
+TEST_CASE("diff: added removed and modified sections and keys", "[diff]")
+{
+  ini::inifile a;
+  a.from_string("[keep]\nx=1\n[change]\nv=1\nold=1\n[gone]\ng=1\n");
+  ini::inifile b;
+  b.from_string("[keep]\nx=1\n[change]\nv=2\nnew=1\n[fresh]\nf=1\n");
+
+  REQUIRE(ini::diff(a, a).empty());
+
+  ini::diff_result d = ini::diff(a, b);
+  REQUIRE(d.sections.size() == 3);
+  std::size_t added = 0, removed = 0, modified = 0;
+  for (const auto &sc : d.sections)
+  {
+    REQUIRE(sc.section != "keep");
+    if (sc.kind == ini::change_kind::added)
+    {
+      ++added;
+      REQUIRE(sc.section == "fresh");
+    }
+    if (sc.kind == ini::change_kind::removed)
+    {
+      ++removed;
+      REQUIRE(sc.section == "gone");
+    }
+    if (sc.kind == ini::change_kind::modified)
+    {
+      ++modified;
+      REQUIRE(sc.section == "change");
+    }
+  }
+  REQUIRE(added == 1);
+  REQUIRE(removed == 1);
+  REQUIRE(modified == 1);
+
+  REQUIRE(d.keys.size() == 5);  // change.v, change.old, change.new, gone.g, fresh.f
+  for (const auto &kc : d.keys)
+  {
+    if (kc.key == "v")
+    {
+      REQUIRE((kc.kind == ini::change_kind::modified));
+      REQUIRE(kc.old_value == "1");
+      REQUIRE(kc.new_value == "2");
+    }
+    if (kc.key == "g") REQUIRE((kc.kind == ini::change_kind::removed));
+    if (kc.key == "f") REQUIRE((kc.kind == ini::change_kind::added));
+  }
+
+  // 只有注释变化也算修改
+  ini::inifile c = a;
+  c["keep"]["x"].set_comment("new comment");
+  d = ini::diff(a, c);
+  REQUIRE(d.keys.size() == 1);
+  REQUIRE((d.keys[0].kind == ini::change_kind::modified));
+}
+
+TEST_CASE("merge3: three-way merge with conflicts", "[diff]")
+{
+  ini::inifile base;
+  base.from_string("[same]\na=1\n[ours]\nx=1\n[theirs]\ny=1\n[both]\nk=1\nm=1\nn=1\n[drop]\nd=1\n");
+  ini::inifile ours = base;
+  ini::inifile theirs = base;
+  REQUIRE(ours["same"].shares_storage_with(base["same"]));  // 未修改的 section 共享存储
+
+  ours["ours"]["x"] = 2;
+  theirs["theirs"]["y"] = 3;
+  ours["both"]["k"] = 10;     // 冲突
+  theirs["both"]["k"] = 20;
+  ours["both"]["m"] = 5;      // 双方相同的修改
+  theirs["both"]["m"] = 5;
+  theirs["both"].remove("n");
+  theirs["both"]["t"] = "new";
+  ours.remove("drop");
+  theirs["added"]["z"] = 1;
+
+  auto result = ini::merge3(base, ours, theirs);
+  REQUIRE_FALSE(result.clean());
+  REQUIRE(result.conflicts.size() == 1);
+  REQUIRE(result.conflicts[0].section == "both");
+  REQUIRE(result.conflicts[0].key == "k");
+  REQUIRE(result.conflicts[0].base_value == "1");
+  REQUIRE(result.conflicts[0].our_value == "10");
+  REQUIRE(result.conflicts[0].their_value == "20");
+
+  const ini::inifile &m = result.merged;
+  REQUIRE(m.at("same").at("a").as<int>() == 1);
+  REQUIRE(m.at("ours").at("x").as<int>() == 2);
+  REQUIRE(m.at("theirs").at("y").as<int>() == 3);
+  REQUIRE(m.at("both").at("k").as<int>() == 10);  // 冲突时保留 ours
+  REQUIRE(m.at("both").at("m").as<int>() == 5);
+  REQUIRE_FALSE(m.at("both").contains("n"));
+  REQUIRE(m.at("both").at("t").as<std::string>() == "new");
+  REQUIRE_FALSE(m.contains("drop"));
+  REQUIRE(m.at("added").at("z").as<int>() == 1);
+
+  // 一方删除, 另一方修改同一个 section
+  ini::inifile edited = base;
+  edited["drop"]["d"] = 2;
+  result = ini::merge3(base, ours, edited);
+  REQUIRE(result.conflicts.size() == 1);
+  REQUIRE(result.conflicts[0].section == "drop");
+  REQUIRE(result.conflicts[0].key.empty());
+  REQUIRE_FALSE(result.merged.contains("drop"));
+
+  REQUIRE(ini::merge3(base, base, base).clean());
+  REQUIRE(ini::merge3(base, base, theirs).merged.fingerprint() == theirs.fingerprint());
+}
+
+TEST_CASE("section fingerprint cache follows modifications", "[diff]")
+{
+  ini::inifile a;
+  a.from_string("[s]\nk=1\n");
+  ini::inifile b = a;
+  const std::uint64_t before = b.at("s").fingerprint();
+  REQUIRE(before == a.at("s").fingerprint());
+  b["s"].set("k", 2);
+  REQUIRE(b.at("s").fingerprint() != before);
+  b["s"].set("k", 1);
+  REQUIRE(b.at("s").fingerprint() == before);
+  b["s"]["k"].set_comment("note");  // 通过引用修改
+  REQUIRE(b.at("s").fingerprint() != before);
+  REQUIRE(ini::diff(a, b).keys.size() == 1);
+  b["s"].clear();
+  REQUIRE(b.at("s").fingerprint() != before);
+}
+
+TEST_CASE("watcher: check() delivers only changed keys", "[watcher]")
+{
+  const std::string path = "test_watcher_check.ini";
+  {
+    std::ofstream ofs(path);
+    ofs << "[net]\nport=8080\nhost=localhost\n";
+  }
+
+  ini::watcher w(path);
+  REQUIRE(w.current()->get("net", "port").as<int>() == 8080);
+
+  std::vector<ini::key_change> received;
+  w.subscribe([&received](const ini::diff_result &d, const ini::watcher::snapshot_type &snap) {
+    received = d.keys;
+    REQUIRE(snap->get("net", "port").as<int>() == 9090);
+  });
+  REQUIRE_FALSE(w.check());  // 文件未变化
+
+  {
+    std::ofstream ofs(path);
+    ofs << "[net]\nport=9090\nhost=localhost\n\n";
+  }
+  REQUIRE(w.check());
+  REQUIRE(received.size() == 1);
+  REQUIRE(received[0].section == "net");
+  REQUIRE(received[0].key == "port");
+  REQUIRE(w.current()->get("net", "port").as<int>() == 9090);
+
+  // 文件内容变化但配置语义不变, 不通知
+  received.clear();
+  {
+    std::ofstream ofs(path);
+    ofs << "\n[net]\n  port = 9090\n  host = localhost\n";
+  }
+  REQUIRE_FALSE(w.check());
+  REQUIRE(received.empty());
+  std::remove(path.c_str());
+}
+
+TEST_CASE("watcher: subscribers may call check() from the callback", "[watcher]")
+{
+  const std::string path = "test_watcher_reentrant.ini";
+  {
+    std::ofstream ofs(path);
+    ofs << "[app]\nvalue=1\n";
+  }
+
+  ini::watcher w(path);
+  std::vector<int> seen;
+  bool nested_result = false;
+  w.subscribe([&](const ini::diff_result &, const ini::watcher::snapshot_type &snap) {
+    seen.push_back(snap->get("app", "value").as<int>());
+    if (seen.size() == 1)
+    {
+      {
+        std::ofstream ofs(path);
+        ofs << "[app]\nvalue=300\n";  // 大小不同, 一定能检测到变化
+      }
+      nested_result = w.check();  // 旧实现在这里因 reload_mutex_ 死锁
+      REQUIRE(seen.size() == 1);  // 嵌套的变化排队, 外层回调返回后才投递
+    }
+  });
+
+  {
+    std::ofstream ofs(path);
+    ofs << "[app]\nvalue=20\n";
+  }
+  REQUIRE(w.check());
+  REQUIRE(nested_result);
+  REQUIRE(seen == std::vector<int>{20, 300});
+  REQUIRE(w.current()->get("app", "value").as<int>() == 300);
+  std::remove(path.c_str());
+}
+
+TEST_CASE("watcher: background thread coalesces bursts", "[watcher][thread]")
+{
+  const std::string path = "test_watcher_thread.ini";
+  {
+    std::ofstream ofs(path);
+    ofs << "[app]\nvalue=0\n";
+  }
+
+  ini::watcher w(path, std::chrono::milliseconds(50), std::chrono::milliseconds(20));
+  std::mutex mtx;
+  std::condition_variable cv;
+  int deliveries = 0;
+  int last_value = 0;
+  w.subscribe([&](const ini::diff_result &, const ini::watcher::snapshot_type &snap) {
+    std::lock_guard<std::mutex> lock(mtx);
+    ++deliveries;
+    last_value = snap->get("app", "value").as<int>();
+    cv.notify_all();
+  });
+  REQUIRE(w.start());
+  REQUIRE_FALSE(w.start());
+
+  for (int i = 1; i <= 5; ++i)  // 连续写入
+  {
+    std::ofstream ofs(path);
+    ofs << "[app]\nvalue=" << i << "\n";
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(mtx);
+    REQUIRE(cv.wait_for(lock, std::chrono::seconds(5), [&] { return last_value == 5; }));
+    REQUIRE(deliveries >= 1);
+    REQUIRE(deliveries <= 5);
+  }
+  w.stop();
+  w.stop();
+  std::remove(path.c_str());
+}
+
+TEST_CASE("shared_config: readers see consistent snapshots", "[shared_config][thread]")
+{
+  ini::inifile initial;
+  initial["counter"]["a"] = 0;
+  initial["counter"]["b"] = 0;
+  ini::shared_config config(initial);
+
+  auto reader = config.make_reader();
+  REQUIRE(reader.get().at("counter").at("a").as<int>() == 0);
+  REQUIRE(reader.version() == 0);
+
+  const int updates = 200;
+  std::atomic<bool> done{false};
+  std::atomic<int> inconsistent{0};
+  std::vector<std::thread> readers;
+  for (int t = 0; t < 4; ++t)
+  {
+    readers.emplace_back([&config, &done, &inconsistent] {
+      auto r = config.make_reader();
+      while (!done.load())
+      {
+        const ini::inifile &snap = r.get();
+        // 同一个快照中 a 和 b 必须始终相等
+        if (snap.get("counter", "a").as<int>() != snap.get("counter", "b").as<int>()) ++inconsistent;
+      }
+      if (r.get().get("counter", "a").as<int>() != updates) ++inconsistent;
+    });
+  }
+
+  for (int i = 1; i <= updates; ++i)
+  {
+    config.update([i](ini::inifile &next) {
+      next["counter"]["a"] = i;
+      next["counter"]["b"] = i;
+    });
+  }
+  done = true;
+  for (auto &t : readers) t.join();
+
+  REQUIRE(inconsistent.load() == 0);
+  REQUIRE(config.version() == static_cast<std::uint64_t>(updates));
+  REQUIRE(reader.get().at("counter").at("a").as<int>() == updates);
+  REQUIRE(reader.version() == static_cast<std::uint64_t>(updates));
+
+  // 已被读者持有的旧快照保持不变
+  auto old_snapshot = config.snapshot();
+  ini::inifile replacement;
+  replacement["other"]["x"] = 1;
+  config.publish(replacement);
+  REQUIRE(old_snapshot->contains("counter"));
+  REQUIRE_FALSE(config.snapshot()->contains("counter"));
+  REQUIRE(reader->contains("other"));
+}
+
+TEST_CASE("concurrent_inifile: basic operations", "[concurrent]")
+{
+  ini::concurrent_inifile inif(4);
+  inif.set(" tenant1 ", " port ", 8080);
+  inif.set("tenant2", "host", "localhost");
+  REQUIRE(inif.contains("tenant1"));
+  REQUIRE(inif.contains("tenant1", "port"));
+  REQUIRE(inif.get("tenant1", "port").as<int>() == 8080);
+  REQUIRE(inif.get("tenant3", "port", 1).as<int>() == 1);
+  REQUIRE(inif.size() == 2);
+
+  inif.update_section("tenant1", [](ini::section &sec) {
+    sec["a"] = 1;
+    sec["b"] = 2;
+  });
+  int sum = 0;
+  REQUIRE(inif.read_section("tenant1", [&sum](const ini::section &sec) {
+    sum = sec.at("a").as<int>() + sec.at("b").as<int>();
+  }));
+  REQUIRE(sum == 3);
+  REQUIRE_FALSE(inif.read_section("missing", [](const ini::section &) {}));
+
+  REQUIRE(inif.remove("tenant1", "a"));
+  REQUIRE_FALSE(inif.remove("tenant1", "a"));
+  REQUIRE(inif.remove("tenant2"));
+  REQUIRE_FALSE(inif.contains("tenant2"));
+
+  ini::inifile snap = inif.snapshot();
+  REQUIRE(snap.size() == 1);
+  REQUIRE(snap.at("tenant1").at("port").as<int>() == 8080);
+
+  REQUIRE(inif.save("concurrent_test.ini"));
+  ini::concurrent_inifile loaded;
+  REQUIRE(loaded.load("concurrent_test.ini"));
+  REQUIRE(loaded.get("tenant1", "b").as<int>() == 2);
+  std::remove("concurrent_test.ini");
+
+  loaded.clear();
+  REQUIRE(loaded.size() == 0);
+}
+
+TEST_CASE("concurrent_inifile: parallel writers on different sections", "[concurrent][thread]")
+{
+  ini::concurrent_inifile inif;
+  const int threads = 4;
+  const int per_thread = 500;
+  std::vector<std::thread> pool;
+  for (int t = 0; t < threads; ++t)
+  {
+    pool.emplace_back([&inif, t] {
+      const std::string sec = "tenant" + std::to_string(t);
+      for (int i = 0; i < per_thread; ++i)
+      {
+        inif.set(sec, "key" + std::to_string(i), i);
+        inif.update_section("shared", [](ini::section &s) { s["counter"] = s.get("counter", 0).as<int>() + 1; });
+        (void)inif.get("tenant" + std::to_string((t + 1) % threads), "key0");
+        if (i % 100 == 0) inif.remove("scratch" + std::to_string(t));
+        inif.set("scratch" + std::to_string(t), "x", i);
+      }
+    });
+  }
+  for (auto &th : pool) th.join();
+
+  REQUIRE(inif.get("shared", "counter").as<int>() == threads * per_thread);
+  for (int t = 0; t < threads; ++t)
+  {
+    int keys = 0;
+    inif.read_section("tenant" + std::to_string(t), [&keys](const ini::section &s) { keys = static_cast<int>(s.size()); });
+    REQUIRE(keys == per_thread);
+    REQUIRE(inif.get("scratch" + std::to_string(t), "x").as<int>() == per_thread - 1);
+  }
+}
+
+TEST_CASE("concurrent_inifile: readers never see a half-loaded config", "[concurrent][thread]")
+{
+  const std::string path_a = "concurrent_reload_a.ini";
+  const std::string path_b = "concurrent_reload_b.ini";
+  ini::inifile a;
+  a.from_string("[stable]\nv=1\n[db]\nhost=a\nport=1\n[only_a]\nx=1\n");
+  ini::inifile b;
+  b.from_string("[stable]\nv=1\n[db]\nhost=b\nport=2\n[only_b]\ny=2\n");
+  for (int i = 0; i < 500; ++i)  // 让每次替换持续足够长的时间
+  {
+    a["fill" + std::to_string(i)]["k"] = i;
+    b["fill" + std::to_string(i)]["k"] = i;
+  }
+  REQUIRE(a.save(path_a));
+  REQUIRE(b.save(path_b));
+
+  ini::concurrent_inifile inif(4);
+  REQUIRE(inif.load(path_a));
+
+  std::atomic<bool> done{false};
+  std::atomic<int> errors{0};
+  std::vector<std::thread> readers;
+  for (int t = 0; t < 4; ++t)
+  {
+    readers.emplace_back([&inif, &done, &errors] {
+      while (!done.load())
+      {
+        // 两个文件都有的 section 在重新加载期间始终可见, 且每个 section 整体替换
+        if (!inif.contains("stable") || inif.get("stable", "v", 0).as<int>() != 1) ++errors;
+        inif.read_section("db", [&errors](const ini::section &s) {
+          const std::string host = s.get("host").str();
+          const int port = s.get("port", 0).as<int>();
+          if (!((host == "a" && port == 1) || (host == "b" && port == 2))) ++errors;
+        });
+        if (!inif.contains("db")) ++errors;
+      }
+    });
+  }
+  for (int i = 0; i < 50; ++i) REQUIRE(inif.load(i % 2 == 0 ? path_b : path_a));
+  done = true;
+  for (auto &th : readers) th.join();
+  REQUIRE(errors.load() == 0);
+
+  // 最后加载的是 path_a: 只存在于 path_b 中的 section 已被删除
+  REQUIRE(inif.contains("only_a"));
+  REQUIRE_FALSE(inif.contains("only_b"));
+  REQUIRE(inif.get("db", "host").str() == "a");
+  REQUIRE(inif.size() == 503);
+  std::remove(path_a.c_str());
+  std::remove(path_b.c_str());
+}
+
+TEST_CASE("section copy-on-write", "[section][cow]")
+{
+  ini::inifile base;
+  base.from_string("[db]\nhost=localhost\nport=5432\n[log]\nlevel=info\n");
+
+  SECTION("copies share sections until modified")
+  {
+    ini::inifile copy = base;
+    const ini::inifile &cbase = base;
+    const ini::inifile &ccopy = copy;
+    REQUIRE(&cbase.at("db").at("host") == &ccopy.at("db").at("host"));
+
+    copy["db"]["port"] = 6543;  // 只复制被修改的 section
+    REQUIRE(cbase.at("db").at("port").as<int>() == 5432);
+    REQUIRE(ccopy.at("db").at("port").as<int>() == 6543);
+    REQUIRE(&cbase.at("db").at("host") != &ccopy.at("db").at("host"));
+    REQUIRE(&cbase.at("log").at("level") == &ccopy.at("log").at("level"));
+
+    copy.at("log").set_comment("changed");
+    REQUIRE(cbase.at("log").comment().empty());
+    copy.at("log").remove("level");
+    REQUIRE(cbase.at("log").contains("level"));
+  }
+
+  SECTION("references handed out keep their meaning")
+  {
+    ini::field &port = base["db"]["port"];
+    ini::inifile copy = base;  // base 的 db section 已交出引用, 必须深拷贝
+    port = 1;
+    REQUIRE(base["db"]["port"].as<int>() == 1);
+    REQUIRE(copy["db"]["port"].as<int>() == 5432);
+  }
+
+  SECTION("erase through an iterator of shared data")
+  {
+    ini::section sec = base.at("db");
+    const ini::section &csec = sec;
+    auto it = csec.find("host");
+    REQUIRE((it != csec.end()));
+    sec.erase(it);
+    REQUIRE_FALSE(sec.contains("host"));
+    REQUIRE(sec.contains("port"));
+    REQUIRE(base.at("db").contains("host"));
+
+    ini::section all = base.at("db");
+    const ini::section &call = all;
+    REQUIRE((all.erase(call.begin(), call.end()) == all.end()));
+    REQUIRE(all.empty());
+    REQUIRE(base.at("db").size() == 2);
+  }
+
+  SECTION("clear and moved-from sections")
+  {
+    ini::section sec = base.at("db");
+    sec.clear();
+    REQUIRE(sec.empty());
+    REQUIRE(base.at("db").size() == 2);
+
+    ini::section moved = std::move(sec);
+    REQUIRE(sec.empty());
+    REQUIRE(sec.comment().empty());
+    sec["k"] = 1;
+    REQUIRE(sec.at("k").as<int>() == 1);
+  }
+}
+
+TEST_CASE("persistent_map structural sharing", "[history]")
+{
+  using map_type = ini::detail::persistent_map<int, int>;
+  map_type empty;
+  map_type m = empty;
+  for (int i = 0; i < 2000; ++i) m = m.set(i, i * 2);
+  REQUIRE(m.size() == 2000);
+  REQUIRE(empty.size() == 0);
+  REQUIRE(*m.find(1234) == 2468);
+  REQUIRE(m.find(5000) == nullptr);
+
+  map_type changed = m.set(7, -1).erase(8).set(4000, 1);
+  REQUIRE(changed.size() == 2000);
+  REQUIRE(*m.find(7) == 14);
+  REQUIRE(*changed.find(7) == -1);
+  REQUIRE(changed.find(8) == nullptr);
+  REQUIRE(m.find(8) != nullptr);
+
+  std::map<int, std::pair<const int *, const int *>> reported;
+  map_type::diff(m, changed, [&reported](const int &k, const int *old_value, const int *new_value) {
+    reported[k] = std::make_pair(old_value, new_value);
+  });
+  REQUIRE(reported.size() == 3);  // 共享的子树不会被访问
+  REQUIRE((*reported[7].first == 14 && *reported[7].second == -1));
+  REQUIRE((reported[8].second == nullptr));
+  REQUIRE((reported[4000].first == nullptr));
+
+  REQUIRE(m.erase(99999).same_root(m));
+  map_type drained = m;
+  for (int i = 0; i < 2000; ++i) drained = drained.erase(i);
+  REQUIRE(drained.empty());
+  REQUIRE(m.size() == 2000);
+}
+
+TEST_CASE("config_history keeps versions with shared structure", "[history]")
+{
+  ini::inifile inif;
+  inif.from_string("; database\n[db]\nhost=localhost\nport=5432\n[log]\nlevel=info\n");
+
+  ini::config_history history(3);
+  const auto v1 = history.commit(inif);
+  REQUIRE(v1 == 1);
+  REQUIRE(history.head().get("db", "port").as<int>() == 5432);
+
+  inif["db"]["port"] = 6543;
+  inif["cache"]["size"] = 64;
+  const auto v2 = history.commit(inif);
+
+  const ini::persistent_inifile &first = history.at(v1);
+  const ini::persistent_inifile &second = history.at(v2);
+  REQUIRE(first.get("db", "port").as<int>() == 5432);
+  REQUIRE(second.get("db", "port").as<int>() == 6543);
+  REQUIRE(first.find("log")->fields.same_root(second.find("log")->fields));  // 未修改的 section 被共享
+  REQUIRE(second.find("db")->comment().view().size() == 1);
+
+  ini::diff_result changes = ini::diff(first, second);
+  REQUIRE(changes.keys.size() == 2);
+  REQUIRE(changes.sections.size() == 2);
+  REQUIRE(ini::diff(second, second).empty());
+  REQUIRE(ini::diff(first, second).keys.size() == ini::diff(first.to_inifile(), second.to_inifile()).keys.size());
+
+  // 不可变修改
+  ini::persistent_inifile third = second.set("log", "level", "debug").remove("cache");
+  REQUIRE(second.get("log", "level").as<std::string>() == "info");
+  REQUIRE(third.get("log", "level").as<std::string>() == "debug");
+  REQUIRE_FALSE(third.contains("cache"));
+  const auto v3 = history.commit(third);
+
+  // 回滚产生新的版本, 超出容量的最旧版本被丢弃
+  const auto v4 = history.rollback(v1);
+  REQUIRE(history.size() == 3);
+  REQUIRE_FALSE(history.contains(v1));
+  REQUIRE_THROWS_AS(history.at(v1), std::out_of_range);
+  REQUIRE(history.head_id() == v4);
+  REQUIRE(history.head().get("db", "port").as<int>() == 5432);
+  REQUIRE(history.at(v3).get("log", "level").as<std::string>() == "debug");
+
+  ini::inifile restored = history.head().to_inifile();
+  REQUIRE(restored["db"]["port"].as<int>() == 5432);
+  REQUIRE_FALSE(restored.contains("cache"));
+  REQUIRE(restored.at("db").comment().view().size() == 1);
+}
+
+TEST_CASE("binary format round trip", "[binary]")
+{
+  ini::inifile inif;
+  inif.from_string(
+    "; global\nroot=1\n\n# database settings\n[db]\nhost = localhost\n; port comment\nport=5432\nempty=\n"
+    "[empty section]\n[log]\nlevel=info\n");
+  inif["db"]["path"] = std::string("a\tb=c \\ ;d");
+
+  REQUIRE(inif.save_binary("binary_test.bin"));
+  ini::inifile loaded;
+  loaded["stale"]["x"] = 1;
+  REQUIRE(loaded.load_binary("binary_test.bin"));
+  REQUIRE(loaded.fingerprint() == inif.fingerprint());
+  REQUIRE_FALSE(loaded.contains("stale"));
+  REQUIRE(loaded["db"]["path"].as<std::string>() == "a\tb=c \\ ;d");
+  REQUIRE(loaded.at("db").comment().view() == inif.at("db").comment().view());
+  REQUIRE(loaded.at("empty section").empty());
+
+  // 损坏或截断的文件不会修改当前内容
+  std::string bytes;
+  REQUIRE(ini::detail::read_file("binary_test.bin", bytes));
+  REQUIRE(ini::detail::write_file("binary_test.bin", bytes.substr(0, bytes.size() - 1)));
+  REQUIRE_FALSE(loaded.load_binary("binary_test.bin"));
+  bytes[0] = 'X';
+  REQUIRE(ini::detail::write_file("binary_test.bin", bytes));
+  REQUIRE_FALSE(loaded.load_binary("binary_test.bin"));
+  REQUIRE_FALSE(loaded.load_binary("binary_test_missing.bin"));
+  REQUIRE(loaded.fingerprint() == inif.fingerprint());
+  std::remove("binary_test.bin");
+
+  ini::ordered_inifile ordered;
+  ordered["z"]["b"] = 2;
+  ordered["z"]["a"] = 1;
+  ordered["a"]["k"] = 0;
+  REQUIRE(ordered.save_binary("binary_test.bin"));
+  ini::ordered_inifile ordered_loaded;
+  REQUIRE(ordered_loaded.load_binary("binary_test.bin"));
+  REQUIRE(ordered_loaded.to_string() == ordered.to_string());  // 保持插入顺序
+  std::remove("binary_test.bin");
+}
+
+TEST_CASE("load through sidecar binary cache", "[binary]")
+{
+  const std::string path = "binary_cache_test.ini";
+  const std::string cache = ini::inifile::binary_cache_filename(path);
+  REQUIRE(cache == "binary_cache_test.inic");
+  REQUIRE(ini::inifile::binary_cache_filename("config.conf") == "config.conf.inic");
+  std::remove(cache.c_str());
+
+  ini::inifile source;
+  source["server"]["port"] = 8080;
+  REQUIRE(source.save(path));
+
+  ini::inifile first;
+  REQUIRE(first.load(path, true));  // 解析文本并生成缓存
+  REQUIRE(first["server"]["port"].as<int>() == 8080);
+  std::string bytes;
+  REQUIRE(ini::detail::read_file(cache, bytes));
+
+  ini::inifile second;
+  REQUIRE(second.load(path, true));  // 命中缓存
+  REQUIRE(second.fingerprint() == first.fingerprint());
+
+  source["server"]["port"] = 9090;  // 源文件变化后缓存失效并被重建
+  REQUIRE(source.save(path));
+  ini::inifile third;
+  REQUIRE(third.load(path, true));
+  REQUIRE(third["server"]["port"].as<int>() == 9090);
+  std::string rebuilt;
+  REQUIRE(ini::detail::read_file(cache, rebuilt));
+  REQUIRE(rebuilt != bytes);
+
+  REQUIRE_FALSE(third.load("binary_cache_missing.ini", true));
+  std::remove(path.c_str());
+  std::remove(cache.c_str());
+}
+
+TEST_CASE("mapped_inifile reads an image in place", "[mapped]")
+{
+  ini::inifile inif;
+  inif.from_string("root=top\n[server]\nhost = example.com\nport=8080\nratio=0.5\nenabled=true\n[empty]\n");
+  for (int i = 0; i < 200; ++i) inif["bulk"]["key" + std::to_string(i)] = i;
+  REQUIRE(ini::save_image(inif, "mapped_test.img"));
+
+  ini::mapped_inifile view;
+  REQUIRE(view.open("mapped_test.img"));
+  REQUIRE(view.is_open());
+  REQUIRE(view.size() == inif.size());
+  REQUIRE(view.fingerprint() == inif.fingerprint());
+  REQUIRE(view.contains("server"));
+  REQUIRE(view.contains(" server ", " port "));
+  REQUIRE(view.contains("empty"));
+  REQUIRE_FALSE(view.contains("missing"));
+  REQUIRE_FALSE(view.contains("server", "missing"));
+  REQUIRE(view.get("", "root").str() == "top");
+  REQUIRE(view.get("server", "host").str() == "example.com");
+  REQUIRE(view.get("server", "port").as<int>() == 8080);
+  REQUIRE(view.get("server", "host").as<std::string>() == "example.com");
+#ifdef __cpp_lib_string_view
+  // string_view 直接指向映射内存, 返回后仍然有效
+  const ini::mapped_value host = view.get("server", "host");
+  const std::string_view host_view = host.as<std::string_view>();
+  REQUIRE(host_view == "example.com");
+  REQUIRE(host_view.data() == host.data());
+#endif
+  REQUIRE(view.get("server", "ratio").as<double>() == 0.5);
+  REQUIRE(view.get("server", "enabled").as<bool>());
+  REQUIRE(view.get("server", "missing", 42) == 42);
+  REQUIRE(view.get("server", "port", 0) == 8080);
+  REQUIRE_FALSE(static_cast<bool>(view.get("missing", "port")));
+  for (int i = 0; i < 200; ++i) REQUIRE(view.get("bulk", "key" + std::to_string(i)).as<int>() == i);
+  REQUIRE(view.sections().size() == 4);
+
+  ini::mapped_inifile moved(std::move(view));
+  REQUIRE_FALSE(view.is_open());
+  REQUIRE(moved.get("server", "port").as<int>() == 8080);
+  moved.close();
+  REQUIRE_FALSE(moved.contains("server"));
+
+  // 损坏的映像被拒绝
+  std::string bytes;
+  REQUIRE(ini::detail::read_file("mapped_test.img", bytes));
+  REQUIRE(ini::detail::write_file("mapped_test.img", bytes.substr(0, bytes.size() - 1)));
+  REQUIRE_FALSE(moved.open("mapped_test.img"));
+  REQUIRE_FALSE(moved.open("mapped_test_missing.img"));
+  std::remove("mapped_test.img");
+
+  // 大小写不敏感的文档生成大小写不敏感的映像
+  ini::case_insensitive_inifile ci;
+  ci["Server"]["Port"] = 1;
+  const std::string image = ini::build_image(ci);
+  std::vector<std::uint64_t> aligned((image.size() + 7) / 8);
+  std::memcpy(aligned.data(), image.data(), image.size());
+  ini::mapped_inifile ci_view;
+  REQUIRE(ci_view.attach(aligned.data(), image.size()));
+  REQUIRE(ci_view.get("SERVER", "port").as<int>() == 1);
+}
+
+#if !defined(_WIN32)
+TEST_CASE("shm publisher and reader", "[shm]")
+{
+  const std::string name = "/inifile_test_" + std::to_string(::getpid());
+  ini::shm_publisher::remove(name);
+
+  ini::shm_reader reader;
+  REQUIRE_FALSE(reader.open(name));  // 尚未发布
+
+  ini::shm_publisher publisher(name);
+  ini::inifile inif;
+  inif["server"]["port"] = 8080;
+  inif["server"]["host"] = "localhost";
+  REQUIRE(publisher.publish(inif) == 1);
+  REQUIRE(publisher.generation() == 1);
+
+  REQUIRE(reader.open(name));
+  REQUIRE(reader.generation() == 1);
+  REQUIRE(reader->get("server", "port").as<int>() == 8080);
+  REQUIRE_FALSE(reader.refresh());  // 没有新的发布
+
+  inif["server"]["port"] = 9090;
+  inif["log"]["level"] = "debug";
+  REQUIRE(publisher.publish(inif) == 2);
+  REQUIRE(reader.published_generation() == 2);
+  REQUIRE(reader->get("server", "port").as<int>() == 8080);  // 切换前仍然是旧视图
+  REQUIRE(reader.refresh());
+  REQUIRE(reader.generation() == 2);
+  REQUIRE(reader->get("server", "port").as<int>() == 9090);
+  REQUIRE(reader.view().get("log", "level").str() == "debug");
+
+  // 发布者重启后从已有的代数继续
+  ini::shm_publisher restarted(name);
+  REQUIRE(restarted.publish(inif) == 3);
+  ini::shm_reader second;
+  REQUIRE(second.open(name));
+  REQUIRE(second.generation() == 3);
+
+  ini::shm_publisher::remove(name);
+  REQUIRE(reader->get("server", "port").as<int>() == 9090);  // 已映射的视图不受影响
+  ini::shm_reader after_remove;
+  REQUIRE_FALSE(after_remove.open(name));
+}
+#endif
+
+TEST_CASE("layered_view resolves keys top-down", "[layered]")
+{
+  ini::inifile defaults;
+  defaults.from_string("[server]\nport=80\nhost=localhost\n[log]\nlevel=info\n");
+  ini::inifile site;
+  site.from_string("[server]\nport=8080\n");
+  ini::inifile overrides;
+
+  ini::layered_view view;
+  REQUIRE(view.push_layer(defaults) == 0);
+  REQUIRE(view.push_layer(site, true) == 1);
+  REQUIRE(view.push_layer(overrides, true) == 2);
+
+  REQUIRE(view.at("server", "port").as<int>() == 8080);
+  REQUIRE(view.get(" server ", " host ").as<std::string>() == "localhost");
+  REQUIRE(view.layer_of("server", "port") == 1);
+  REQUIRE(view.layer_of("server", "missing") == -1);
+  REQUIRE(view.contains("log"));
+  REQUIRE(view.contains("log", "level"));
+  REQUIRE_FALSE(view.contains("nope"));
+  REQUIRE(view.get("nope", "x", 5).as<int>() == 5);
+  REQUIRE_THROWS_AS(view.at("nope", "x"), std::out_of_range);
+  REQUIRE(view.find("server", "port") == &site.at("server").at("port"));  // 不复制
+
+  // 修改一层后只需刷新该层的 Bloom filter
+  overrides["server"]["port"] = 9090;
+  view.refresh(2);
+  REQUIRE(view.at("server", "port").as<int>() == 9090);
+
+  ini::inifile flat = view.flatten();
+  REQUIRE(flat.at("server").at("port").as<int>() == 9090);
+  REQUIRE(flat.at("server").at("host").as<std::string>() == "localhost");
+  REQUIRE(flat.at("log").at("level").as<std::string>() == "info");
+
+  view.pop_layer();
+  REQUIRE(view.size() == 2);
+  REQUIRE(view.at("server", "port").as<int>() == 8080);
+
+  // Bloom filter 不会产生假阴性
+  ini::inifile big;
+  for (int i = 0; i < 500; ++i) big["s" + std::to_string(i % 7)]["k" + std::to_string(i)] = i;
+  ini::layered_view bloom_view;
+  bloom_view.push_layer(big, true);
+  for (int i = 0; i < 500; ++i) REQUIRE(bloom_view.contains("s" + std::to_string(i % 7), "k" + std::to_string(i)));
+}
+
+TEST_CASE("interpolator expands references lazily", "[interpolate]")
+{
+  ini::inifile inif;
+  inif.from_string(
+    "[paths]\nroot=/opt/app\nlogs=${root}/logs\n"
+    "[log]\nfile=${paths:logs}/app.log\nprice=$$5\nsize=${limits:size}\n"
+    "[limits]\nsize=64\n"
+    "[loop]\na=${b}\nb=${loop:a}\nbad=${paths:root\nmissing=${nope:x}\n");
+  ini::interpolator interp(inif);
+
+  REQUIRE(interp.str("log", "file") == "/opt/app/logs/app.log");
+  REQUIRE(interp.cached() == 3);  // log.file, paths.logs, paths.root
+  REQUIRE(interp.str("log", "price") == "$5");
+  REQUIRE(interp.as<int>("log", "size") == 64);
+  REQUIRE(interp.get<int>("log", "none", 7) == 7);
+  REQUIRE(inif["log"]["file"].as<std::string>() == "${paths:logs}/app.log");  // 原始值不变
+
+  // 修改被引用的键, 依赖它的键全部失效
+  interp.set("paths", "root", "/srv");
+  REQUIRE(interp.str("log", "file") == "/srv/logs/app.log");
+  REQUIRE(interp.str("paths", "logs") == "/srv/logs");
+  interp.set("limits", "size", 128);
+  REQUIRE(interp.as<int>("log", "size") == 128);
+
+  REQUIRE_THROWS_AS(interp.str("loop", "a"), std::runtime_error);
+  REQUIRE_THROWS_AS(interp.str("loop", "bad"), std::runtime_error);
+  REQUIRE_THROWS_AS(interp.str("loop", "missing"), std::out_of_range);
+
+  // 直接修改 inifile 也能被检测到, 不需要手动失效
+  inif["paths"]["root"] = "/home";
+  REQUIRE(interp.str("log", "file") == "/home/logs/app.log");
+  inif.set("limits", "size", 256);
+  REQUIRE(interp.as<int>("log", "size") == 256);
+  {
+    ini::field &logs = inif["paths"]["logs"];  // 持有引用, 之后在 interpolator 不知情时修改
+    REQUIRE(interp.str("log", "file") == "/home/logs/app.log");
+    logs = "${root}/var/log";
+    REQUIRE(interp.str("log", "file") == "/home/var/log/app.log");
+  }
+  inif["limits"].remove("size");
+  REQUIRE_THROWS_AS(interp.str("log", "size"), std::out_of_range);
+  interp.invalidate("paths", "root");
+  interp.clear();
+  REQUIRE(interp.cached() == 0);
+}
+
+TEST_CASE("include_loader merges included files in order", "[include]")
+{
+  auto write = [](const std::string &path, const std::string &text) {
+    std::ofstream ofs(path, std::ios::binary);
+    ofs << text;
+  };
+  write("test_inc_root.ini", "include=test_inc_a.ini\ninclude = ./test_inc_b.ini\n[app]\nname=root\n");
+  write("test_inc_a.ini", "include=test_inc_common.ini\n[app]\nname=a\nlevel=1\n[a]\nx=1\n");
+  write("test_inc_b.ini", "[app]\ninclude=test_inc_common.ini\nlevel=2\n");
+  write("test_inc_common.ini", "[common]\nc=1\n[app]\nname=common\n");
+
+  ini::include_loader loader(2);
+  ini::inifile inif;
+  REQUIRE(loader.load("test_inc_root.ini", inif));
+  REQUIRE(loader.parsed_count() == 4);  // common 被包含两次, 只解析一次
+  REQUIRE(inif["app"]["name"].as<std::string>() == "root");
+  REQUIRE(inif["app"]["level"].as<int>() == 2);
+  REQUIRE(inif["common"]["c"].as<int>() == 1);
+  REQUIRE(inif["a"]["x"].as<int>() == 1);
+  REQUIRE_FALSE(inif["app"].contains("include"));
+
+  // 未变化的文件直接使用缓存
+  ini::inifile again;
+  REQUIRE(loader.load("test_inc_root.ini", again));
+  REQUIRE(loader.parsed_count() == 0);
+  REQUIRE(again.fingerprint() == inif.fingerprint());
+
+  write("test_inc_b.ini", "[app]\ninclude=test_inc_common.ini\nlevel=three\n");
+  REQUIRE(loader.load("test_inc_root.ini", again));
+  REQUIRE(loader.parsed_count() == 1);
+  REQUIRE(again["app"]["level"].as<std::string>() == "three");
+
+  write("test_inc_cycle1.ini", "include=test_inc_cycle2.ini\n");
+  write("test_inc_cycle2.ini", "include=test_inc_cycle1.ini\n");
+  REQUIRE_FALSE(loader.load("test_inc_cycle1.ini", again));
+  REQUIRE(again["app"]["level"].as<std::string>() == "three");  // 失败时不修改
+  write("test_inc_cycle2.ini", "include=test_inc_missing.ini\n");
+  REQUIRE_FALSE(loader.load("test_inc_cycle1.ini", again));
+
+  for (const char *f : {"test_inc_root.ini", "test_inc_a.ini", "test_inc_b.ini", "test_inc_common.ini",
+                        "test_inc_cycle1.ini", "test_inc_cycle2.ini"})
+  {
+    std::remove(f);
+  }
+}
+
+TEST_CASE("load_directory merges files in lexical order", "[directory]")
+{
+  const std::vector<std::pair<std::string, std::string>> files = {
+    {"test_confd_20_c.ini", "[app]\nlevel=3\n[c]\nz=1\n"},
+    {"test_confd_02_a.ini", "[app]\nname=base\nlevel=1\n"},
+    {"test_confd_10_b.ini", ";site\n[app]\nlevel=2\n[b]\ny=1\n"},
+    {"test_confd_99_x.txt", "[app]\nlevel=99\n"},  // 不匹配 pattern
+  };
+  for (const auto &f : files)
+  {
+    std::ofstream ofs(f.first, std::ios::binary);
+    ofs << f.second;
+  }
+
+  ini::inifile inif;
+  ini::directory_load_report report;
+  REQUIRE(ini::load_directory(inif, ".", "test_confd_*.ini", &report, 2));
+  REQUIRE(report.files.size() == 3);
+  REQUIRE(report.files[0].filename == "./test_confd_02_a.ini");
+  REQUIRE(report.files[2].filename == "./test_confd_20_c.ini");
+  REQUIRE(report.files[1].bytes == files[2].second.size());
+  for (const auto &stat : report.files) REQUIRE(stat.ok);
+
+  REQUIRE(inif["app"]["name"].as<std::string>() == "base");
+  REQUIRE(inif["app"]["level"].as<int>() == 3);
+  REQUIRE(inif["b"]["y"].as<int>() == 1);
+  REQUIRE(inif["c"]["z"].as<int>() == 1);
+  REQUIRE(inif.size() == 3);
+
+  REQUIRE(ini::load_directory(inif, ".", "test_confd_none_*.ini"));
+  REQUIRE(inif.empty());
+  REQUIRE_FALSE(ini::load_directory(inif, "test_confd_no_such_dir"));
+
+  for (const auto &f : files) std::remove(f.first.c_str());
+}
+
+TEST_CASE("stats collects parse and serialize statistics", "[stats]")
+{
+  const std::string text =
+    "top=1\n"
+    "; section comment\n"
+    "[server]\n"
+    "host = localhost\n"
+    "# key comment\n"
+    "# second line\n"
+    "path=/a/value/that/does/not/fit/into/the/small/string/buffer\n"
+    "\n"
+    "[client]\n"
+    "retries=3\n"
+    "[server]\n"
+    "port=8080";  // 最后一行没有换行符
+
+  ini::inifile inif;
+  ini::stats st;
+  std::istringstream is(text);
+  inif.read(is, st);
+  REQUIRE(inif.size() == 3);
+  REQUIRE(inif["server"]["port"].as<int>() == 8080);
+  if (!ini::stats::enabled())
+  {
+    REQUIRE(st.lines == 0);
+    return;
+  }
+  REQUIRE(st.bytes == text.size());
+  REQUIRE(st.lines == 12);
+  REQUIRE(st.sections == 3);  // "", server, client
+  REQUIRE(st.keys == 5);
+  REQUIRE(st.comment_lines == 3);
+  REQUIRE(st.estimated_allocations >= 3 + 5 + 1);  // 节点, 以及较长的 value
+  REQUIRE(st.estimated_allocated_bytes > 0);
+  REQUIRE(st.io_time.count() >= 0);
+
+  ini::stats out;
+  const std::string serialized = inif.to_string();
+  std::ostringstream os;
+  inif.write(os, out);
+  REQUIRE(os.str() == serialized);
+  REQUIRE(out.bytes == serialized.size());
+  REQUIRE(out.lines == static_cast<std::uint64_t>(std::count(serialized.begin(), serialized.end(), '\n')));
+  REQUIRE(out.estimated_allocations == 0);  // write() 直接写入流, 不估算分配
+  REQUIRE(out.scan_time.count() == 0);
+  REQUIRE(out.sections == 2);  // 无名 section 不写出 section 行
+  REQUIRE(out.keys == 5);
+  REQUIRE(out.comment_lines == 3);
+  REQUIRE(out.insert_time.count() == 0);
+
+  // 大量 key 触发 rehash, 统计在多次调用之间累计, reset() 清零
+  std::string big = "[s]\n";
+  for (int i = 0; i < 1000; ++i) big += "key" + std::to_string(i) + "=" + std::to_string(i) + "\n";
+  std::istringstream big_is(big);
+  inif.read(big_is, st);
+  REQUIRE(st.keys == 1005);
+  REQUIRE(st.rehashes > 0);
+
+  const char *path = "test_stats.ini";
+  ini::stats file_stats;
+  REQUIRE(inif.save(path, file_stats));
+  REQUIRE(file_stats.keys == 1000);
+  file_stats.reset();
+  REQUIRE(file_stats.keys == 0);
+  ini::inifile loaded;
+  REQUIRE(loaded.load(path, file_stats));
+  REQUIRE(file_stats.keys == 1000);
+  REQUIRE(file_stats.sections == 1);
+  REQUIRE(loaded["s"]["key999"].as<int>() == 999);
+  REQUIRE_FALSE(loaded.load("test_stats_missing.ini", file_stats));
+  std::remove(path);
+}
+
+TEST_CASE("access counters report hot, unused and missing keys", "[access]")
+{
+  ini::inifile inif;
+  inif.from_string(
+    "[server]\n"
+    "host=localhost\n"
+    "port=8080\n"
+    "timeout=30\n"
+    "[client]\n"
+    "retries=3\n");
+
+  ini::access_report empty = inif.report_access();
+  REQUIRE(empty.hot.empty());  // 解析不计入访问
+  REQUIRE(empty.missing.empty());
+  if (!ini::access_report::enabled())
+  {
+    REQUIRE(empty.unused.empty());
+    return;
+  }
+  REQUIRE(empty.unused.size() == 4);
+
+  for (int i = 0; i < 5; ++i) REQUIRE(inif.get("server", "port").as<int>() == 8080);
+  REQUIRE(inif.contains("server", " host "));
+  REQUIRE(inif.at("server").at("host").str() == "localhost");
+  REQUIRE(inif["client"]["retries"].as<int>() == 3);
+  const ini::inifile &cref = inif;
+  REQUIRE(cref.at("server").at("port").as<int>() == 8080);
+  REQUIRE_FALSE(inif.contains("server", "user"));
+  REQUIRE(inif.get("server", "user", "root").str() == "root");
+  REQUIRE(inif.get("database", "url").empty());
+  REQUIRE_THROWS_AS(inif.at("client").at("delay"), std::out_of_range);
+
+  ini::access_report report = inif.report_access(2);
+  REQUIRE(report.hot.size() == 2);
+  REQUIRE(report.hot[0].section == "server");
+  REQUIRE(report.hot[0].key == "port");
+  REQUIRE(report.hot[0].hits == 6);
+  REQUIRE(report.hot[1].key == "host");
+  REQUIRE(report.hot[1].hits == 2);
+  REQUIRE(report.unused.size() == 1);
+  REQUIRE(report.unused[0].key == "timeout");
+  REQUIRE(report.missing.size() == 3);
+  REQUIRE(report.missing[0].key == "user");
+  REQUIRE(report.missing[0].misses == 2);
+  REQUIRE(report.missing[1].section == "client");
+  REQUIRE(report.missing[1].key == "delay");
+  REQUIRE(report.missing[2].section == "database");
+  REQUIRE(report.missing[2].key == "url");
+
+  // 计数属于 key, 赋值不清零; operator[] 插入新 key 计为一次未命中
+  inif["server"]["port"] = 9090;
+  inif["server"]["user"] = "admin";
+  report = inif.report_access();
+  REQUIRE(report.hot[0].hits == 7);
+  REQUIRE(report.missing.size() == 2);
+  auto user = std::find_if(report.unused.begin(), report.unused.end(),
+                           [](const ini::key_access &a) { return a.key == "user"; });
+  REQUIRE((user != report.unused.end() && user->misses == 3));
+
+  ini::access_report sec_report = inif.at("client").report_access();
+  REQUIRE(sec_report.hot.size() == 1);
+  REQUIRE(sec_report.hot[0].section.empty());
+  REQUIRE(sec_report.hot[0].hits == 1);
+
+  // 移动构造转移计数(不复制), 源对象不再有记录
+  ini::inifile moved(std::move(inif));
+  REQUIRE(moved.report_access().missing.size() == 2);
+  REQUIRE(inif.report_access().missing.empty());
+  ini::section client(std::move(moved["client"]));
+  REQUIRE(client.report_access().hot.size() == 1);
+  REQUIRE(client.report_access().missing.size() == 1);
+  REQUIRE(moved.at("client").report_access().missing.empty());
+  moved["client"] = client;  // 赋值不转移计数: 目标 key 保留自己的计数
+
+  moved.reset_access_counts();
+  report = moved.report_access();
+  REQUIRE(report.hot.empty());
+  REQUIRE(report.missing.empty());
+  REQUIRE(report.unused.size() == 5);
+}
+
+namespace
+{
+/// @brief 有状态的计数分配器, 记录通过它分配的字节数
+template <typename T>
+struct arena_allocator
+{
+  using value_type = T;
+
+  explicit arena_allocator(std::shared_ptr<std::size_t> counter = std::make_shared<std::size_t>(0)) :
+    used(std::move(counter))
+  {
+  }
+  template <typename U>
+  arena_allocator(const arena_allocator<U> &other) : used(other.used)  // NOLINT(google-explicit-constructor)
+  {
+  }
+
+  T *allocate(std::size_t n)
+  {
+    *used += n * sizeof(T);
+    return static_cast<T *>(::operator new(n * sizeof(T)));
+  }
+  void deallocate(T *p, std::size_t n)
+  {
+    *used -= n * sizeof(T);
+    ::operator delete(p);
+  }
+
+  template <typename U>
+  bool operator==(const arena_allocator<U> &rhs) const
+  {
+    return used == rhs.used;
+  }
+  template <typename U>
+  bool operator!=(const arena_allocator<U> &rhs) const
+  {
+    return used != rhs.used;
+  }
+
+  std::shared_ptr<std::size_t> used;
+};
+}  // namespace
+
+TEST_CASE("allocator-aware basic_inifile and basic_section", "[allocator]")
+{
+  using alloc_type = arena_allocator<char>;
+  using arena_inifile =
+    ini::basic_inifile<std::hash<std::string>, std::equal_to<std::string>, std::unordered_map, alloc_type>;
+  using arena_ordered_inifile =
+    ini::basic_inifile<std::hash<std::string>, std::equal_to<std::string>, ini::detail::ordered_map, alloc_type>;
+
+  alloc_type arena;
+  {
+    arena_inifile inif(arena);
+    REQUIRE(inif.get_allocator() == arena);
+    inif.from_string("[server]\nhost=localhost\nport=8080\n[client]\nretries=3\n");
+    REQUIRE(*arena.used > 0);
+    REQUIRE(inif["server"].get_allocator() == arena);
+    REQUIRE(inif.at("client").get_allocator() == arena);
+    REQUIRE(inif["server"]["port"].as<int>() == 8080);
+    // key, value 和注释的字符串同样使用 arena
+    REQUIRE(inif.find("server")->first.get_allocator() == arena);
+    REQUIRE(inif["server"].find("host")->first.get_allocator() == arena);
+    REQUIRE(inif["server"]["host"].str().get_allocator() == arena);
+    inif["server"]["host"].set_comment("; upstream");
+    REQUIRE(inif["server"]["host"].comment().get_allocator() == arena);
+    REQUIRE(inif["server"]["host"].comment().view().front().get_allocator() == arena);
+    REQUIRE(inif["server"]["host"].comment().to_vector() == std::vector<std::string>{"; upstream"});
+    const std::string name = "server";
+    REQUIRE(inif.contains(name, std::string("port")));  // std::string 兼容重载
+    REQUIRE(inif[name]["port"].as<int>() == 8080);
+    inif.set("new", "key", 1);
+    REQUIRE(inif.at("new").get_allocator() == arena);
+
+    // 与另一个分配器之间的拷贝/移动
+    alloc_type other;
+    arena_inifile copy(inif, other);
+    REQUIRE(copy.get_allocator() == other);
+    REQUIRE(copy.fingerprint() == inif.fingerprint());
+    REQUIRE(*other.used > 0);
+    arena_inifile moved(std::move(copy), arena);
+    REQUIRE(moved.get_allocator() == arena);
+    REQUIRE(moved.fingerprint() == inif.fingerprint());
+    REQUIRE(copy.empty());  // NOLINT(bugprone-use-after-move)
+
+    arena_inifile assigned(other);
+    assigned = std::move(moved);  // 分配器不同, 逐个移动元素
+    REQUIRE(assigned.get_allocator() == other);
+    REQUIRE(assigned.fingerprint() == inif.fingerprint());
+
+    ini::diff_result changes = ini::diff(inif, assigned);
+    REQUIRE(changes.empty());
+    REQUIRE(inif.save_binary("arena_test.bin"));  // 二进制缓存和各个扩展头文件都接受其他分配器的 inifile
+    arena_inifile loaded(arena);
+    REQUIRE(loaded.load_binary("arena_test.bin"));
+    REQUIRE(loaded.fingerprint() == inif.fingerprint());
+    REQUIRE(loaded["server"].find("host")->first.get_allocator() == arena);
+    std::remove("arena_test.bin");
+    REQUIRE(!ini::build_image(inif).empty());
+    ini::persistent_inifile doc(inif);
+    REQUIRE(doc.to_inifile().fingerprint() == inif.fingerprint());
+    REQUIRE(ini::diff(doc.to_inifile<std::unordered_map, alloc_type>(arena), inif).empty());
+
+    // section 写时复制与分配器
+    auto sec = inif.at("server");
+    sec.set("host", "example.com");
+    REQUIRE(sec.get_allocator() == arena);
+    REQUIRE(inif["server"]["host"].str() == "localhost");
+
+    arena_ordered_inifile ordered(arena);
+    ordered.from_string("[b]\nz=1\na=2\n[a]\nk=v\n");
+    REQUIRE(ini::join(ordered.sections(), ",") == "b,a");
+    REQUIRE(ini::join(ordered.at("b").keys(), ",") == "z,a");
+    REQUIRE(ordered.at("a").get_allocator() == arena);
+  }
+  REQUIRE(*arena.used == 0);  // 所有内存都归还给了 arena
+
+  // 默认分配器不增加 section 的大小
+  REQUIRE(sizeof(ini::section) == sizeof(std::shared_ptr<int>)
+#if INIFILE_ENABLE_ACCESS_COUNTERS
+                                    + sizeof(ini::detail::miss_table<std::string>)
+#endif
+  );
+}
+
+#ifdef __cpp_lib_memory_resource
+TEST_CASE("pmr aliases allocate from the given memory_resource", "[allocator][pmr]")
+{
+  // 上游为 null_memory_resource: 任何容器分配若未落在栈缓冲区内都会抛出 std::bad_alloc
+  alignas(std::max_align_t) char buffer[64 * 1024];
+  std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer), std::pmr::null_memory_resource());
+
+  const std::string text =
+    "; header\n"
+    "[Server]\n"
+    "host=localhost\n"
+    "port=8080\n"
+    "[client]\n"
+    "retries=3\n";
+  {
+    ini::pmr::inifile inif(&arena);
+    REQUIRE_NOTHROW(inif.from_string(text));
+    REQUIRE(inif.get_allocator().resource() == &arena);
+    REQUIRE(inif["Server"]["port"].as<int>() == 8080);
+    REQUIRE(inif["Server"].get_allocator().resource() == &arena);
+    REQUIRE_NOTHROW(inif.set("extra", "key", 1));
+    REQUIRE(inif.at("extra").get_allocator().resource() == &arena);
+
+    ini::pmr::inifile copy(inif, &arena);
+    REQUIRE(copy.fingerprint() == inif.fingerprint());
+    REQUIRE(copy.at("client").get_allocator().resource() == &arena);
+
+    ini::pmr::case_insensitive_inifile ci(&arena);
+    REQUIRE_NOTHROW(ci.from_string(text));
+    REQUIRE(ci.get("server", "HOST").str() == "localhost");
+
+    ini::pmr::ordered_inifile ordered(&arena);
+    REQUIRE_NOTHROW(ordered.from_string(text));
+    REQUIRE(ini::join(ordered.sections(), ",") == "Server,client");
+    REQUIRE(ordered.to_string().find("; header\n[Server]\nhost=localhost\nport=8080\n") == 0);
+  }
+  {
+    // 超出短字符串缓冲区的 section 名, key, value 和注释同样来自 arena; 解析期间默认 resource 也置为 null,
+    // 确认没有字符串落到 arena 以外
+    const std::string name(40, 's'), key(64, 'k'), value(256, 'v'), note = "; " + std::string(128, 'c');
+    const std::string long_text = note + "\n[" + name + "]\n" + note + "\n" + key + "=" + value + "\n";
+    ini::pmr::inifile inif(&arena);
+    std::pmr::memory_resource *previous = std::pmr::set_default_resource(std::pmr::null_memory_resource());
+    bool parsed = false;
+    try
+    {
+      inif.from_string(long_text);
+      parsed = true;
+    }
+    catch (const std::bad_alloc &)
+    {
+    }
+    std::pmr::set_default_resource(previous);
+    REQUIRE(parsed);
+
+    auto sec = inif.find(name);
+    REQUIRE(sec != inif.end());
+    REQUIRE(sec->first.get_allocator().resource() == &arena);
+    REQUIRE(sec->second.contains(key));
+    auto kv = sec->second.find(key);
+    REQUIRE(kv->first.get_allocator().resource() == &arena);
+    REQUIRE(kv->second.as<std::string>() == value);
+    REQUIRE(kv->second.str().get_allocator().resource() == &arena);
+    REQUIRE(kv->second.comment().to_vector() == std::vector<std::string>{note});
+    REQUIRE(kv->second.comment().view().front().get_allocator().resource() == &arena);
+    REQUIRE(sec->second.comment().view().front().get_allocator().resource() == &arena);
+    REQUIRE(inif.to_string() == long_text);
+  }
+  arena.release();  // 一次性释放所有内存
+
+  // 栈缓冲区耗尽后, 分配失败以 std::bad_alloc 报告
+  alignas(std::max_align_t) char tiny[256];
+  std::pmr::monotonic_buffer_resource small(tiny, sizeof(tiny), std::pmr::null_memory_resource());
+  ini::pmr::inifile overflow(&small);
+  std::string many;
+  for (int i = 0; i < 100; ++i) many += "[s" + std::to_string(i) + "]\nk=v\n";
+  REQUIRE_THROWS_AS(overflow.from_string(many), std::bad_alloc);
+}
+
+namespace
+{
+/// 记录分配所在的线程, 用于确认 load_directory 不会在多个线程上使用同一个 memory_resource
+class thread_recording_resource : public std::pmr::memory_resource
+{
+ public:
+  std::set<std::thread::id> threads;
+
+ private:
+  std::mutex mutex_;
+  void *do_allocate(std::size_t bytes, std::size_t alignment) override
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      threads.insert(std::this_thread::get_id());
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds(200));  // 放慢解析, 使并行时其他线程一定能分到文件
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+  }
+  void do_deallocate(void *p, std::size_t bytes, std::size_t alignment) override
+  {
+    std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+  }
+  bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+  {
+    return this == &other;
+  }
+};
+}  // namespace
+
+TEST_CASE("load_directory parses serially with a pmr allocator", "[directory][pmr]")
+{
+  std::vector<std::string> names;
+  for (int i = 0; i < 8; ++i)
+  {
+    names.push_back("test_pmr_confd_" + std::to_string(i) + ".ini");
+    std::ofstream ofs(names.back(), std::ios::binary);
+    ofs << "[app]\nlevel=" << i << "\n[s" << i << "]\nkey_with_a_long_name_" << i << "=some value longer than sso\n";
+  }
+
+  thread_recording_resource resource;
+  {
+    ini::pmr::inifile inif(&resource);
+    REQUIRE(ini::load_directory(inif, ".", "test_pmr_confd_*.ini", nullptr, 4));
+    REQUIRE(inif["app"]["level"].as<int>() == 7);
+    REQUIRE(inif.size() == 9);
+    REQUIRE(inif.at("s3").get_allocator().resource() == &resource);
+  }
+  REQUIRE(resource.threads == std::set<std::thread::id>{std::this_thread::get_id()});
+
+  for (const auto &name : names) std::remove(name.c_str());
+}
+#endif
+
+TEST_CASE("no_comments policy drops comment storage", "[comment][policy]")
+{
+  // 不启用访问计数时 field 只剩 value_; 这里计数开启, 比较两种策略的差值
+  REQUIRE(sizeof(ini::basic_field<ini::no_comments>) + sizeof(ini::comment) == sizeof(ini::field));
+
+  const std::string text =
+    "; file header\n"
+    "[server]\n"
+    "# host comment\n"
+    "host=localhost\n"
+    "port=8080\n";
+  ini::uncommented_inifile inif;
+  inif.from_string(text);
+  REQUIRE(inif.get("server", "host").str() == "localhost");
+  REQUIRE(inif["server"]["port"].as<int>() == 8080);
+
+  const ini::uncommented_inifile &cinif = inif;
+  REQUIRE(cinif.at("server").comment().empty());
+  REQUIRE(cinif.at("server").at("host").comment().empty());
+  REQUIRE(inif.to_string().find_first_of(";#") == std::string::npos);
+
+  // 注释相关接口可以调用, 但不存储任何内容
+  inif["server"].set_comment("section comment");
+  inif["server"].add_comment({"more"});
+  inif["server"]["host"].set_comment("key comment", '#');
+  inif["server"]["host"].add_comment("more");
+  inif["server"].clear_comment();
+  inif["server"]["port"].clear_comment();
+  REQUIRE(cinif.at("server").comment().empty());
+  REQUIRE(cinif.at("server").at("host").comment().empty());
+  REQUIRE(inif.to_string().find_first_of(";#") == std::string::npos);
+
+  // 指纹与去掉注释后的默认 inifile 一致
+  ini::inifile plain;
+  plain.from_string("[server]\nhost=localhost\nport=8080\n");
+  REQUIRE(inif.fingerprint() == plain.fingerprint());
+
+  // 二进制格式往返
+  const std::string path = "uncommented_test.bin";
+  REQUIRE(inif.save_binary(path));
+  ini::uncommented_inifile loaded;
+  REQUIRE(loaded.load_binary(path));
+  REQUIRE(loaded.fingerprint() == inif.fingerprint());
+  std::remove(path.c_str());
+
+  ini::inifile commented;
+  commented.from_string(text);
+  REQUIRE(commented.save_binary(path));
+  REQUIRE(loaded.load_binary(path));
+  REQUIRE(loaded.fingerprint() == inif.fingerprint());
+  std::remove(path.c_str());
+
+  ini::uncommented_section sec;
+  sec["k"] = 1;
+  sec.set_comment("ignored");
+  REQUIRE(static_cast<const ini::uncommented_section &>(sec).comment().empty());
+  ini::uncommented_section copy = sec;
+  REQUIRE(copy.at("k").as<int>() == 1);
+}
+
+TEST_CASE("extension headers accept the no_comments policy", "[comment][policy]")
+{
+  ini::uncommented_inifile base;
+  base.from_string("; dropped\n[app]\nname=base\nlevel=1\n");
+  ini::uncommented_inifile ours = base;
+  ours["app"]["level"] = 2;
+  ini::uncommented_inifile theirs = base;
+  theirs["app"]["name"] = "theirs";
+
+  const ini::diff_result changes = ini::diff(base, ours);
+  REQUIRE(changes.keys.size() == 1);
+  REQUIRE(changes.keys[0].key == "level");
+  const auto merged = ini::merge3(base, ours, theirs);
+  REQUIRE(merged.conflicts.empty());
+  REQUIRE(merged.merged.get("app", "level").as<int>() == 2);
+  REQUIRE(merged.merged.get("app", "name").str() == "theirs");
+
+  const std::string dir_file = "test_uncommented_confd_a.ini";
+  REQUIRE(base.save(dir_file));
+  ini::uncommented_inifile loaded;
+  REQUIRE(ini::load_directory(loaded, ".", "test_uncommented_confd_*.ini"));
+  REQUIRE(loaded.fingerprint() == base.fingerprint());
+  std::remove(dir_file.c_str());
+
+  const std::string image_file = "uncommented_test.img";
+  REQUIRE(ini::save_image(ours, image_file));
+  ini::mapped_inifile view;
+  REQUIRE(view.open(image_file));
+  REQUIRE(view.get("app", "level").as<int>() == 2);
+  view.close();
+  std::remove(image_file.c_str());
+
+#if !defined(_WIN32)
+  const std::string name = "/inifile_uncommented_" + std::to_string(::getpid());
+  ini::shm_publisher::remove(name);
+  {
+    ini::shm_publisher publisher(name);
+    REQUIRE(publisher.publish(ours) == 1);
+    ini::shm_reader reader;
+    REQUIRE(reader.open(name));
+    REQUIRE(reader->get("app", "level").as<int>() == 2);
+  }
+  ini::shm_publisher::remove(name);
+#endif
+}